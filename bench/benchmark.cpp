@@ -0,0 +1,579 @@
+/** Headless benchmark suite of the triangulation engines.
+* Builds without OpenGL from the engine sources only, e.g.
+*   g++ -O2 -std=c++20 -pthread -Isrc bench/benchmark.cpp src/mesh.cpp src/hierarchy.cpp src/conflictgraph.cpp
+*       src/threadpool.cpp src/batchtriangulator.cpp src/workload.cpp src/trace.cpp src/verifier.cpp
+*       src/shardedtriangulator.cpp
+* Usage: benchmark [--min-n n] [--max-n n] [--budget seconds] [--engine name] [--distribution name]
+*                  [--sets count] [--json path] [--trace path] [--verify max-n] [--shards max]
+* Define TRIANGULATION_STATS to print the hot path counters of every run, and
+* TRIANGULATION_TRACE to record the timeline that --trace writes.
+* Every engine runs over n = min-n, 10 min-n, ... max-n (1e3 to 1e7 by default) for every
+* distribution, until the next size is predicted to take longer than the budget. The
+* insertion times of each engine are fitted to c n^k; an exponent more than TOLERANCE
+* above the one the engine is known for on that distribution, engines disagreeing on the
+* triangle count, or a mesh of at most max-n points failing --verify makes the benchmark
+* exit with 1.
+* --shards runs max-n uniform points through 1, 2, 4 ... max worker processes to show how
+* the sharded triangulator scales; a triangle count differing from one mesh fails too. */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/hierarchy.h"
+#include "../src/conflictgraph.h"
+#include "../src/batchtriangulator.h"
+#include "../src/smalltriangulation.h"
+#include "../src/workload.h"
+#include "../src/stats.h"
+#include "../src/trace.h"
+#include "../src/verifier.h"
+#include "../src/shardedtriangulator.h"
+
+/// how far the fitted exponent may exceed the expected one, an O(n log n) engine turning quadratic fails
+static const double TOLERANCE = 0.5;
+/// runs faster than this are too noisy to enter the complexity fit
+static const double MIN_FIT_SECONDS = 0.005;
+/// growth assumed when predicting the time of the next size
+static const double PREDICTION_EXPONENT = 1.2;
+
+#if defined(_WIN32)
+static void resetPeakMemory(void)
+{
+    // the peak working set cannot be reset, the process peak is reported
+}
+
+static std::size_t peakMemory(void)
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize;
+}
+#else
+static void resetPeakMemory(void)
+{
+    // resets VmHWM on Linux, elsewhere the process peak is reported
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+static std::size_t peakMemory(void)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line))
+    {
+        if(line.compare(0, 6, "VmHWM:") == 0)
+            return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+}
+#endif
+
+/// wall clock split into named phases
+class Phases
+{
+public:
+    Phases(void) : last(std::chrono::steady_clock::now()) {}
+
+    /// ends the current phase, naming it
+    void mark(const std::string& name)
+    {
+        auto now = std::chrono::steady_clock::now();
+        this->times.emplace_back(name, std::chrono::duration<double>(now - this->last).count());
+        this->last = now;
+    }
+
+    double get(const std::string& name) const
+    {
+        for(const auto& phase : this->times)
+        {
+            if(phase.first == name)
+                return phase.second;
+        }
+        return 0.0;
+    }
+
+    std::vector<std::pair<std::string, double>> times;
+
+private:
+    std::chrono::steady_clock::time_point last;
+};
+
+/// looks at the finished mesh of a run, after the timed phases
+typedef std::function<void(const Mesh&)> Inspect;
+/// builds a triangulation of nodes, marking an "insert" and an "extract" phase, then inspects the mesh
+typedef std::function<std::size_t(const std::vector<Node>&, Phases*, const Inspect&)> Build;
+
+class Engine
+{
+public:
+    std::string name;
+    double exponent;           // expected growth: 1 for O(n log n), 1.5 for plain walks on random input
+    double degenerateExponent; // on CIRCLE and LINE, where a plain walk crosses O(n) faces per point
+    Build build;
+
+    double expected(Workload::Distribution distribution) const noexcept
+    {
+        bool degenerate = distribution == Workload::CIRCLE || distribution == Workload::LINE;
+        return degenerate ? this->degenerateExponent : this->exponent;
+    }
+};
+
+class Result
+{
+public:
+    std::string engine;
+    std::string distribution;
+    std::size_t n;
+    std::size_t triangles;
+    std::size_t peakBytes;
+    Phases phases;
+
+    double seconds(void) const
+    {
+        return this->phases.get("insert") + this->phases.get("extract");
+    }
+};
+
+class Fit
+{
+public:
+    std::string engine;
+    std::string distribution;
+    double exponent;
+    double limit;
+    int samples;
+    bool ok;
+};
+
+/// index triples of the finite faces
+static std::size_t extract(const Mesh& mesh, Phases* phases, const Inspect& inspect)
+{
+    std::vector<std::array<int, 3>> triangles;
+    mesh.getTriangles(&triangles);
+    phases->mark("extract");
+    inspect(mesh);
+    return triangles.size();
+}
+
+static std::vector<Engine> engines(void)
+{
+    return {
+        {"batch", 1.0, 1.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            Mesh mesh;
+            mesh.insertBatch(nodes);
+            phases->mark("insert");
+            return extract(mesh, phases, inspect);
+        }},
+        {"batch-flip", 1.0, 1.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            Mesh mesh;
+            mesh.setEngine(Mesh::FLIP_ENGINE);
+            mesh.insertBatch(nodes);
+            phases->mark("insert");
+            return extract(mesh, phases, inspect);
+        }},
+        {"walk", 1.5, 2.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            Mesh mesh;
+            for(const Node& n : nodes)
+                mesh.insert(n);
+            phases->mark("insert");
+            return extract(mesh, phases, inspect);
+        }},
+        {"walk-flip", 1.5, 2.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            Mesh mesh;
+            mesh.setEngine(Mesh::FLIP_ENGINE);
+            for(const Node& n : nodes)
+                mesh.insert(n);
+            phases->mark("insert");
+            return extract(mesh, phases, inspect);
+        }},
+        {"hierarchy", 1.0, 1.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            DelaunayHierarchy hierarchy;
+            for(const Node& n : nodes)
+                hierarchy.insert(n);
+            phases->mark("insert");
+            return extract(hierarchy.base(), phases, inspect);
+        }},
+        {"hierarchy-flip", 1.0, 1.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            DelaunayHierarchy hierarchy;
+            hierarchy.setEngine(Mesh::FLIP_ENGINE);
+            for(const Node& n : nodes)
+                hierarchy.insert(n);
+            phases->mark("insert");
+            return extract(hierarchy.base(), phases, inspect);
+        }},
+        {"conflict-graph", 1.0, 1.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            Mesh mesh;
+            ConflictGraph().build(&mesh, nodes, ConflictGraph::RANDOM_ORDER);
+            phases->mark("insert");
+            return extract(mesh, phases, inspect);
+        }},
+        {"conflict-graph-cheapest", 1.0, 1.0, [](const std::vector<Node>& nodes, Phases* phases, const Inspect& inspect)
+        {
+            Mesh mesh;
+            ConflictGraph().build(&mesh, nodes, ConflictGraph::CHEAPEST_FIRST);
+            phases->mark("insert");
+            return extract(mesh, phases, inspect);
+        }}
+    };
+}
+
+/**==============================================
+*@return the least squares exponent k of seconds = c n^k over the runs slow enough to measure */
+static Fit fitComplexity(const std::vector<Result>& runs, double expected)
+{
+    Fit fit{runs.front().engine, runs.front().distribution, 0.0, expected + TOLERANCE, 0, true};
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for(const Result& run : runs)
+    {
+        double seconds = run.phases.get("insert");
+        if(seconds < MIN_FIT_SECONDS)
+            continue;
+        double x = std::log(double(run.n)), y = std::log(seconds);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        fit.samples++;
+    }
+    if(fit.samples < 2)
+        return fit;
+    fit.exponent = (fit.samples * sxy - sx * sy) / (fit.samples * sxx - sx * sx);
+    fit.ok = fit.exponent <= fit.limit;
+    return fit;
+}
+
+static void printRow(const Result& result)
+{
+    std::cout << std::left << std::setw(24) << result.engine << std::setw(15) << result.distribution
+              << std::right << std::setw(10) << result.n << std::setw(11) << result.triangles
+              << std::fixed << std::setprecision(4)
+              << std::setw(10) << result.phases.get("generate") << std::setw(10) << result.phases.get("insert")
+              << std::setw(10) << result.phases.get("extract")
+              << std::setprecision(0) << std::setw(12) << result.n / result.seconds()
+              << std::setprecision(1) << std::setw(10) << result.peakBytes / 1048576.0 << '\n';
+}
+
+static void writeJson(const std::string& path, const std::vector<Result>& results, const std::vector<Fit>& fits)
+{
+    std::ofstream out(path);
+    out << std::setprecision(6) << "{\n  \"threads\": " << std::thread::hardware_concurrency()
+        << ",\n  \"results\": [";
+    for(std::size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"engine\": \"" << r.engine << "\", \"distribution\": \"" << r.distribution
+            << "\", \"n\": " << r.n << ", \"triangles\": " << r.triangles << ", \"seconds\": " << r.seconds()
+            << ", \"points_per_second\": " << r.n / r.seconds() << ", \"peak_rss_bytes\": " << r.peakBytes
+            << ", \"phases\": {";
+        for(std::size_t p = 0; p < r.phases.times.size(); p++)
+            out << (p ? ", " : "") << '"' << r.phases.times[p].first << "\": " << r.phases.times[p].second;
+        out << "}}";
+    }
+    out << "\n  ],\n  \"complexity\": [";
+    for(std::size_t i = 0; i < fits.size(); i++)
+    {
+        const Fit& f = fits[i];
+        out << (i ? ",\n" : "\n") << "    {\"engine\": \"" << f.engine << "\", \"distribution\": \"" << f.distribution
+            << "\", \"exponent\": " << f.exponent << ", \"limit\": " << f.limit << ", \"samples\": " << f.samples
+            << ", \"ok\": " << (f.ok ? "true" : "false") << '}';
+    }
+    out << "\n  ]\n}\n";
+}
+
+/// many independent sets of 10 to 200 points, reported in point sets per second
+static void runSmallSets(int setCount)
+{
+    CounterRandom random(3);
+    std::vector<std::size_t> offsets = {0};
+    for(int set = 0; set < setCount; set++)
+        offsets.push_back(offsets.back() + 10 + random.bits(set) % 191);
+
+    Workload workload;
+    workload.seed = 3;
+    std::vector<Node> nodes;
+    WorkloadGenerator().generate(workload, offsets.back(), &nodes);
+
+    BatchTriangulator triangulator;
+    MeshBatch batch;
+    triangulator.triangulate(nodes, offsets, &batch); // warm up the per-thread scratch
+
+    auto start = std::chrono::steady_clock::now();
+    triangulator.triangulate(nodes, offsets, &batch);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\nsmall sets: " << setCount << " sets, " << nodes.size() << " points, "
+              << batch.triangles.size() << " triangles on " << std::thread::hardware_concurrency() << " threads\n"
+              << std::fixed << std::setprecision(4) << seconds << " s, "
+              << std::setprecision(0) << setCount / seconds << " sets/s\n";
+}
+
+/// single threaded cost of one tiny triangulation, fixed-capacity kernel against a reused Mesh
+static void runSmallKernels(void)
+{
+    const int REPEATS = 20000;
+    std::cout << "\n" << std::left << std::setw(24) << "set size" << std::right
+              << std::setw(16) << "kernel ns" << std::setw(16) << "mesh ns" << '\n';
+
+    WorkloadGenerator generator;
+    for(int size : {4, 8, 16, 32})
+    {
+        Workload workload;
+        workload.seed = size;
+        std::vector<Node> nodes;
+        generator.generate(workload, size * REPEATS, &nodes);
+        std::array<std::array<int, 3>, 2 * SMALL_KERNEL_LIMIT> triangles;
+        std::size_t checksum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for(int r = 0; r < REPEATS; r++)
+            checksum += triangulateSmall(std::span<const Node>(nodes).subspan(r * size, size), triangles.data());
+        double kernel = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+
+        Mesh mesh;
+        std::vector<std::array<int, 3>> faces;
+        start = std::chrono::steady_clock::now();
+        for(int r = 0; r < REPEATS; r++)
+        {
+            mesh.reset(Node(-1.0f, -1.0f), Node(1.0f, 1.0f));
+            mesh.insertBatch(std::span<const Node>(nodes).subspan(r * size, size));
+            faces.clear();
+            mesh.getTriangles(&faces);
+            checksum -= faces.size();
+        }
+        double reused = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / REPEATS;
+
+        std::cout << std::left << std::setw(24) << size << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(16) << kernel << std::setw(16) << reused
+                  << (checksum != 0 ? "  triangle counts differ" : "") << '\n';
+    }
+}
+
+/// the sharded triangulator on 1, 2, 4 ... worker processes against one mesh on the same points
+/// @return false if a run failed or disagreed with the mesh
+static bool runShards(int maxShards, std::size_t n)
+{
+    Workload workload;
+    workload.seed = 1;
+    std::vector<Node> nodes;
+    WorkloadGenerator().generate(workload, n, &nodes);
+
+    auto start = std::chrono::steady_clock::now();
+    Mesh mesh;
+    mesh.insertBatch(nodes);
+    std::vector<std::array<int, 3>> reference;
+    mesh.getTriangles(&reference);
+    double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\nsharded: " << n << " uniform points, one mesh takes " << std::fixed << std::setprecision(3) << single << " s\n"
+              << std::left << std::setw(24) << "shards" << std::right << std::setw(10) << "seconds" << std::setw(10)
+              << "speedup" << std::setw(12) << "seam" << std::setw(11) << "triangles" << '\n';
+    bool ok = true;
+    for(int shards = 1; shards <= maxShards; shards *= 2)
+    {
+        ShardedTriangulator triangulator(shards);
+        std::vector<std::array<int, 3>> triangles;
+        start = std::chrono::steady_clock::now();
+        bool done = triangulator.triangulate(nodes, &triangles);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(!done)
+        {
+            std::cout << "FAILED: " << shards << " shards, " << triangulator.getError() << '\n';
+            ok = false;
+            continue;
+        }
+        std::cout << std::left << std::setw(24) << shards << std::right << std::setprecision(3) << std::setw(10) << seconds
+                  << std::setprecision(2) << std::setw(10) << single / seconds << std::setw(12) << triangulator.getSeamPoints()
+                  << std::setw(11) << triangles.size()
+                  << (triangles.size() != reference.size() ? "  MISMATCH with one mesh" : "") << '\n';
+        for(const ShardReport& report : triangulator.getShards())
+            std::cout << "  " << report << '\n';
+        ok = ok && triangles.size() == reference.size();
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t minCount = 1000, maxCount = 10000000, verifyCount = 0;
+    double budget = 60.0;
+    int setCount = 100000, shardCount = 0;
+    std::string engineFilter, distributionFilter, jsonPath, tracePath;
+
+    for(int i = 1; i < argc; i += 2)
+    {
+        if(i + 1 == argc)
+        {
+            std::cerr << "missing value for " << argv[i] << '\n';
+            return 2;
+        }
+        if(std::strcmp(argv[i], "--min-n") == 0)
+            minCount = std::max<std::size_t>(std::strtoull(argv[i + 1], nullptr, 10), 1);
+        else if(std::strcmp(argv[i], "--max-n") == 0)
+            maxCount = std::strtoull(argv[i + 1], nullptr, 10);
+        else if(std::strcmp(argv[i], "--budget") == 0)
+            budget = std::atof(argv[i + 1]);
+        else if(std::strcmp(argv[i], "--engine") == 0)
+            engineFilter = argv[i + 1];
+        else if(std::strcmp(argv[i], "--distribution") == 0)
+            distributionFilter = argv[i + 1];
+        else if(std::strcmp(argv[i], "--sets") == 0)
+            setCount = std::atoi(argv[i + 1]);
+        else if(std::strcmp(argv[i], "--json") == 0)
+            jsonPath = argv[i + 1];
+        else if(std::strcmp(argv[i], "--trace") == 0)
+            tracePath = argv[i + 1];
+        else if(std::strcmp(argv[i], "--verify") == 0)
+            verifyCount = std::strtoull(argv[i + 1], nullptr, 10);
+        else if(std::strcmp(argv[i], "--shards") == 0)
+            shardCount = std::atoi(argv[i + 1]);
+        else
+        {
+            std::cerr << "unknown option " << argv[i] << '\n';
+            return 2;
+        }
+    }
+
+    std::cout << std::left << std::setw(24) << "engine" << std::setw(15) << "points"
+              << std::right << std::setw(10) << "n" << std::setw(11) << "triangles"
+              << std::setw(10) << "generate" << std::setw(10) << "insert" << std::setw(10) << "extract"
+              << std::setw(12) << "points/s" << std::setw(10) << "peak MB" << '\n';
+
+    const std::vector<Workload::Distribution> distributions = {
+        Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::GRID,
+        Workload::JITTERED_GRID, Workload::CIRCLE, Workload::LINE
+    };
+
+    WorkloadGenerator generator;
+    DelaunayVerifier verifier;
+    std::vector<Result> results;
+    std::vector<Fit> fits;
+    bool failed = false;
+
+    for(Workload::Distribution distribution : distributions)
+    {
+        Workload workload;
+        workload.distribution = distribution;
+        workload.seed = 1;
+        std::string name = Workload::name(distribution);
+        if(!distributionFilter.empty() && distributionFilter != name)
+            continue;
+
+        for(const Engine& engine : engines())
+        {
+            if(!engineFilter.empty() && engineFilter != engine.name)
+                continue;
+
+            std::vector<Result> runs;
+            for(std::size_t n = minCount; n <= maxCount; n *= 10)
+            {
+                if(!runs.empty() && runs.back().seconds() * std::pow(double(n) / runs.back().n, PREDICTION_EXPONENT) > budget)
+                {
+                    std::cout << std::left << std::setw(24) << engine.name << std::setw(15) << name
+                              << std::right << std::setw(10) << n << "  skipped, over the " << budget << " s budget\n";
+                    break;
+                }
+
+                Result result{engine.name, name, n, 0, 0, Phases()};
+                std::vector<Node> nodes;
+                generator.generate(workload, n, &nodes);
+                result.phases.mark("generate");
+
+                resetPeakMemory();
+                triangulationStats().reset();
+                VerifyReport report;
+                result.triangles = engine.build(nodes, &result.phases, [&](const Mesh& mesh)
+                {
+                    result.peakBytes = peakMemory(); // before the verifier allocates its own buffers
+                    if(n <= verifyCount)
+                    {
+                        report = verifier.verify(mesh);
+                        result.phases.mark("verify");
+                    }
+                });
+                printRow(result);
+                if(!report.isValid())
+                {
+                    std::cout << "INVALID: " << engine.name << " on " << n << ' ' << name << " points\n" << report;
+                    failed = true;
+                }
+#ifdef TRIANGULATION_STATS
+                std::cout << triangulationStats();
+#endif
+
+                // every engine must agree with the ones before it on the same input
+                for(const Result& other : results)
+                {
+                    if(other.distribution == name && other.n == n && other.triangles != result.triangles)
+                    {
+                        std::cout << "MISMATCH: " << engine.name << " built " << result.triangles << " triangles, "
+                                  << other.engine << " built " << other.triangles << '\n';
+                        failed = true;
+                        break;
+                    }
+                }
+                runs.push_back(result);
+                results.push_back(result);
+            }
+
+            if(runs.empty())
+                continue;
+            Fit fit = fitComplexity(runs, engine.expected(distribution));
+            fits.push_back(fit);
+            if(fit.samples >= 2)
+            {
+                std::cout << std::left << std::setw(24) << engine.name << std::setw(15) << name << "  time ~ n^"
+                          << std::fixed << std::setprecision(2) << fit.exponent
+                          << (fit.ok ? "" : "   COMPLEXITY REGRESSION, limit n^" + std::to_string(fit.limit).substr(0, 4)) << '\n';
+            }
+            failed = failed || !fit.ok;
+        }
+    }
+
+    if(!jsonPath.empty())
+        writeJson(jsonPath, results, fits);
+
+    if(setCount > 0)
+    {
+        runSmallSets(setCount);
+        runSmallKernels();
+    }
+
+    if(shardCount > 0)
+        failed = !runShards(shardCount, maxCount) || failed;
+
+    if(!tracePath.empty() && !Tracer::instance().dump(tracePath.c_str()))
+        std::cerr << "could not write " << tracePath << '\n';
+
+    if(failed)
+        std::cout << "\nFAILED: see the regressions above\n";
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+/** Triangulation daemon, serves meshes over a Unix domain socket (see TriangulationService).
+* Builds without OpenGL from the engine sources only, e.g.
+*   g++ -O2 -std=c++20 -Isrc service/triangulationd.cpp src/triangulationservice.cpp src/mesh.cpp src/trace.cpp
+* Usage: triangulationd [--socket path] [--window microseconds]
+*        triangulationd --stats [--socket path]
+* The first form serves until SIGINT or SIGTERM and prints the counters on the way out,
+* the second asks a running daemon for its counters over the STATS request. */
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "../src/serviceprotocol.h"
+#include "../src/triangulationservice.h"
+
+static TriangulationService* service = nullptr;
+
+static void stopService(int signal)
+{
+    (void)signal;
+    if(service != nullptr)
+        service->stop();
+}
+
+/// sends one STATS request to the daemon at path and prints the reply
+static bool printStats(const char* path)
+{
+#if defined(_WIN32)
+    (void)path;
+    std::cerr << "the triangulation service needs POSIX sockets\n";
+    return false;
+#else
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(socket < 0 || connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        std::cerr << "cannot connect to " << path << ": " << std::strerror(errno) << '\n';
+        if(socket >= 0)
+            close(socket);
+        return false;
+    }
+
+    RequestHeader request{};
+    request.opcode = RequestHeader::STATS;
+    ReplyHeader reply{};
+    ServiceStats stats{};
+    bool ok = write(socket, &request, sizeof(request)) == static_cast<ssize_t>(sizeof(request));
+    char* p = reinterpret_cast<char*>(&reply);
+    for(std::size_t got = 0; ok && got < sizeof(reply); )
+    {
+        ssize_t n = read(socket, p + got, sizeof(reply) - got);
+        ok = n > 0;
+        got += ok ? static_cast<std::size_t>(n) : 0;
+    }
+    ok = ok && reply.status == ReplyHeader::OK && reply.length == sizeof(stats);
+    p = reinterpret_cast<char*>(&stats);
+    for(std::size_t got = 0; ok && got < sizeof(stats); )
+    {
+        ssize_t n = read(socket, p + got, sizeof(stats) - got);
+        ok = n > 0;
+        got += ok ? static_cast<std::size_t>(n) : 0;
+    }
+    close(socket);
+    if(!ok)
+    {
+        std::cerr << "no valid stats reply from " << path << '\n';
+        return false;
+    }
+    std::cout << stats;
+    return true;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = "/tmp/triangulation.sock";
+    int window = 200;
+    bool stats = false;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(option == "--socket" && i + 1 < argc)
+            path = argv[++i];
+        else if(option == "--window" && i + 1 < argc)
+            window = std::atoi(argv[++i]);
+        else if(option == "--stats")
+            stats = true;
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--socket path] [--window microseconds] [--stats]\n";
+            return 2;
+        }
+    }
+    if(stats)
+        return printStats(path) ? 0 : 1;
+
+    TriangulationService daemon(window);
+    if(!daemon.listen(path))
+    {
+        std::cerr << daemon.getError() << '\n';
+        return 1;
+    }
+    service = &daemon;
+    std::signal(SIGINT, stopService);
+    std::signal(SIGTERM, stopService);
+#if !defined(_WIN32)
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    std::cout << "serving on " << path << " with a " << daemon.getWindow() << " us batch window" << std::endl;
+    bool ok = daemon.run();
+    service = nullptr;
+    if(!ok)
+        std::cerr << daemon.getError() << '\n';
+    std::cout << daemon.getStats();
+    return ok ? 0 : 1;
+}
@@ -1,10 +1,23 @@
 #version 330 core
 
-in vec3 vertexColor;
+// the seed of the triangulation, a new one gives every triangle a new color
+uniform int seed;
 
 out vec4 fragColor;
 
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
 void main()
 {
-    fragColor = vec4(vertexColor, 1.0);
+    // one flat color per face slot, the primitive id is the slot in the index buffer
+    uint h = hash(uint(gl_PrimitiveID) ^ hash(uint(seed)));
+    fragColor = vec4(float(h & 255u), float((h >> 8) & 255u), float((h >> 16) & 255u), 255.0) / 255.0;
 }
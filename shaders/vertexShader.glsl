@@ -1,12 +1,8 @@
 #version 330 core
 
-layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 color;
-
-out vec3 vertexColor;
+layout (location = 0) in vec2 position;
 
 void main()
 {
-    gl_Position = vec4(position, 1.0);
-    vertexColor = color;
+    gl_Position = vec4(position, 0.0, 1.0);
 }
@@ -1,14 +1,35 @@
 #include "application.h"
 
+/// @return true only in the frame a key or button goes down, held carries its state between frames
+static bool wentDown(int state, bool* held)
+{
+    bool down = state == GLFW_PRESS;
+    bool pressed = down && !*held;
+    *held = down;
+    return pressed;
+}
+
 Application::Application(GLuint screenWidth, GLuint screenHeight, const char* appTitle, GLFWframebuffersizefun fbsf)
 {
-    std::srand(time(0));
+    // a new seed every run, printed so an interesting set can be reproduced
+    this->workload.seed = static_cast<std::uint64_t>(std::time(0));
 
     std::cout << "================================================================================\n"
               << "Welcome to my Bowyer Watson Algorithm implementation with C++ and OpenGL. V.1.02\n"
               << "Press `R` to generate a new triangulation.\n"
+              << "Press `C` or `F` to insert with cavities (Bowyer-Watson) or edge flips (Lawson).\n"
+              << "Press `W` to write the triangulation to triangulation.mesh and, compressed, triangulation.meshz.\n"
+              << "Press `E` to export it as triangulation.obj, .ply, .stl and .geojson.\n"
+              << "Click to insert a point, right-click to remove the one nearest to the cursor.\n"
               << "================================================================================\n";
 
+    // other processes follow the mesh through the ring, see MeshReplica
+    this->publishing = this->publisher.create("delaunay-mesh");
+    if(this->publishing)
+        this->publisher.attach(&this->triangulator.front().mesh);
+    else
+        std::cout << "Error, " << this->publisher.getError() << '\n';
+
     // Setup openGL
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -38,125 +59,98 @@ Application::Application(GLuint screenWidth, GLuint screenHeight, const char* ap
 
 void Application::start(void)
 {
-    this->generateTriangulation();
-    this->bufferData();
+    this->setupBuffers();
+    this->requestTriangulation();
 
     while(!glfwWindowShouldClose(this->window))
     {
         this->render();
     }
+    for(MeshRenderer& renderer : this->renderers)
+        renderer.destroy();
     glfwTerminate();
 }
 
-void Application::generateTriangulation(void)
+bool Application::loadPoints(const char* path)
 {
-
-    for(int n = 0; n < this->MAX_NODES; n++)
-        this->nodes.emplace_back(randomValue(), randomValue());
-
-    // superTriangle must contain all nodes in the space ...
-    Triangle superTriangle(Node(-5.0f, -2.0f), Node(0.0f, 7.0f), Node(5.0f, -2.0f));
-    this->triangulation.push_back(superTriangle); // first triangle must be superTriangle
-    // other vars
-    std::vector<Triangle> badTriangles = {};
-    std::vector<Segment> polygon = {};
-    /// Begin Bowyer Watson Algorithm -----------------------------------------
-    // for each point in pointList do
-    for(auto node = this->nodes.begin(); node != this->nodes.end(); node++)
+    // the mapping of a mesh file is used in place unless a point has to be dropped
+    if(std::string_view(path).ends_with(".mesh") && this->meshFile.open(path))
     {
-        // badTriangles := empty set
-        badTriangles.clear();
-        // for each triangle in triangulation do
-        for(auto tri = this->triangulation.begin(); tri != this->triangulation.end(); tri++)
+        std::span<const Node> vertices = this->meshFile.vertices();
+        if(std::all_of(vertices.begin(), vertices.end(), [](const Node& n) { return std::isfinite(n.x) && std::isfinite(n.y); }))
         {
-            // if point is inside circumcircle of triangle
-            tri->setIsBad(tri->isNodeInCircumCircle(*node));
-
-            if(tri->getIsBad())
-                badTriangles.push_back(*tri);
+            std::cout << "mapped " << vertices.size() << " points and " << this->meshFile.triangles().size()
+                      << " triangles from " << path << '\n';
+            this->pointsLoaded = true;
+            return true;
         }
+        this->meshFile.close();
+    }
 
-        // polygon := empty set
-        polygon.clear();
-        // for each triangle in badTriangles do
-        for(auto tri = badTriangles.begin(); tri != badTriangles.end(); tri++)
-        {
-            // for each edge in triangle do
-            for(int i = 0; i < 3; i++)
-            {
-                bool isSharedSeg = false;
-                //  if edge is not shared by any other triangles in badTriangles
-                for(auto tri2 = badTriangles.begin(); tri2 != badTriangles.end(); tri2++)
-                {
-                    // if triangles are the same
-                    // skip this loop -> to next triangle
-                    if(tri == tri2) continue;
-
-                    for(int j = 0; j < 3; j++)
-                    {
-                        if( tri->segArray.at(i) == tri2->segArray.at(j) )
-                        {
-                            isSharedSeg = true;
-                        }
-                    }
-                }
-                // add edge to polygon
-                if(!isSharedSeg)
-                    polygon.push_back(tri->segArray.at(i));
-            }
-        }
+    PointReader reader;
+    if(!reader.read(path, &this->nodes))
+    {
+        std::cout << "Error, " << reader.getError() << '\n';
+        return false;
+    }
+    std::cout << "read " << this->nodes.size() << " points from " << path << " (" << reader.getSkippedLines() << " lines skipped)\n";
+    this->pointsLoaded = true;
+    return true;
+}
 
-        for(auto tri = this->triangulation.begin(); tri != this->triangulation.end(); tri++)
-        {
-            // if triangle contains a vertex from original super-triangle
-            if(tri->getIsBad())
-                this->triangulation.erase(tri--);
-        }
+void Application::requestTriangulation(void)
+{
+    // a build still streaming to the GPU is superseded as well
+    this->uploading = nullptr;
+    if(!this->pointsLoaded)
+        std::cout << "seed " << this->workload.seed << '\n';
 
-        // for each edge in polygon do
-        for(auto seg = polygon.begin(); seg != polygon.end(); seg++)
+    Workload workload = this->workload;
+    Mesh::Engine engine = this->engine;
+    this->triangulator.request([this, workload, engine](BackgroundTriangulator::Buffer* back, const std::atomic<bool>& cancel)
+    {
+        TRACE_SCOPE("generateTriangulation");
+        back->seed = workload.seed;
+        // loaded points stay the same from build to build, only the worker generates
+        std::span<const Node> points = this->meshFile.isOpen() ? this->meshFile.vertices() : std::span<const Node>(this->nodes);
+        if(!this->pointsLoaded)
         {
-            // newTri := form a triangle from edge to point
-            // add newTri to triangulation
-            this->triangulation.emplace_back(*seg, *node);
+            this->generator.generate(workload, this->MAX_NODES, &back->nodes);
+            points = back->nodes;
         }
-    }
-    /*
-    // for each triangle in triangulation
-    for(auto tri = this->triangulation.begin(); tri != this->triangulation.end(); tri++)
-    {
-        // if triangle contains a vertex from original super-triangle
-        if(tri->containsNodesOf(superTriangle) )
-            this->triangulation.erase(tri--);
-    }*/
+        if(cancel.load(std::memory_order_relaxed))
+            return false;
+
+        /// Begin Bowyer Watson Algorithm -----------------------------------------
+        // the mesh starts from its superTriangle and walks from the last touched
+        // triangle to find the cavity of each new node
+        triangulationStats().reset();
+        back->mesh.setEngine(engine);
+        back->mesh.clear();
+        // the triangles of a mesh file are taken as they are, once checked and linked
+        if(!this->meshFile.isOpen() || !back->mesh.assign(points, this->meshFile.triangles(), this->meshFile.adjacency()))
+            back->mesh.insertBatch(points, &cancel);
+        if(cancel.load(std::memory_order_relaxed))
+            return false;
+
+        // faces containing a vertex from the super-triangle draw nothing
+        MeshRenderer::format(back->mesh, &back->indices);
+#ifdef TRIANGULATION_STATS
+        std::cout << triangulationStats();
+#endif
+        return true;
+    });
 }
 
-void Application::bufferData(void)
+void Application::setupBuffers(void)
 {
+    TRACE_SCOPE("setupBuffers");
     this->shader = Shader("shaders/vertexShader.glsl", "shaders/fragmentShader.glsl");
     this->shader.use();
 
-    glGenVertexArrays(1, &this->vertexArray);
-    glGenBuffers(1, &this->vertexBuffer);
-
-    std::vector<Vertex> data;
-    this->formatData(&data);
-
-    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
-    if(data.size() > 0)
-        glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(Vertex), &data.at(0), GL_STATIC_DRAW);
-    else
-        std::cout << "Error, triangles were not generated, no data to render.\n";
-
-    glBindVertexArray(this->vertexArray);
-    // Position attributes of triangulation data
-    // Takes up 3 floats: x, y, and z.
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Color attributes of triangulation data
-    // Takes up 3 floats: r, g, and b.
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // created once, a new triangulation only replaces the contents of the buffers
+    for(MeshRenderer& renderer : this->renderers)
+        renderer.create();
 
     /* uncomment this to see wire frames of triangles */
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -165,18 +159,44 @@ void Application::bufferData(void)
     glfwSwapInterval(1);
 }
 
-void Application::formatData(std::vector<Vertex>* data) const
+void Application::uploadBuild(void)
 {
-    std::array<float, 3>  color;
-    const float Z = 0.0f;
-
-    for(std::vector<Triangle>::const_iterator tri = this->triangulation.cbegin(); tri != this->triangulation.cend(); tri++)
+    MeshRenderer& hidden = this->renderers[1 - this->drawn];
+    if(this->uploading == nullptr)
     {
-        color = {std::abs(randomValue()), std::abs(randomValue()), std::abs(randomValue())};
-        data->emplace_back(tri->nodesArray.at(0).x, tri->nodesArray.at(0).y, Z, color.at(0), color.at(1), color.at(2));
-        data->emplace_back(tri->nodesArray.at(1).x, tri->nodesArray.at(1).y, Z, color.at(0), color.at(1), color.at(2));
-        data->emplace_back(tri->nodesArray.at(2).x, tri->nodesArray.at(2).y, Z, color.at(0), color.at(1), color.at(2));
+        this->uploading = this->triangulator.finished();
+        if(this->uploading == nullptr)
+            return;
+        // new storage for the hidden buffers, the ones drawn are left alone
+        this->uploadedVertices = 0;
+        this->uploadedFaces = 0;
+        hidden.reserve(this->uploading->mesh.vertices.size(), this->uploading->indices.size());
     }
+
+    TRACE_SCOPE("upload");
+    std::span<const Node> vertices = this->uploading->mesh.vertices;
+    std::span<const MeshRenderer::Indices> faces = this->uploading->indices;
+    std::size_t budget = UPLOAD_SLICE;
+    std::size_t n = std::min(vertices.size() - this->uploadedVertices, budget / sizeof(Node));
+    hidden.setVertices(this->uploadedVertices, vertices.subspan(this->uploadedVertices, n));
+    this->uploadedVertices += n;
+    budget -= n * sizeof(Node);
+    n = std::min(faces.size() - this->uploadedFaces, budget / sizeof(MeshRenderer::Indices));
+    hidden.setFaces(this->uploadedFaces, faces.subspan(this->uploadedFaces, n));
+    this->uploadedFaces += n;
+    if(this->uploadedVertices < vertices.size() || this->uploadedFaces < faces.size())
+        return;
+
+    // the buffers and the mesh they show come to the front together, the mesh going back
+    // to the worker is no longer edited or tracked
+    this->renderers[this->drawn].track(nullptr);
+    this->drawn ^= 1;
+    this->shader.setInt("seed", static_cast<int>(this->uploading->seed));
+    this->uploading = nullptr;
+    this->triangulator.swap();
+    this->renderers[this->drawn].track(&this->triangulator.front().mesh);
+    if(this->publishing)
+        this->publisher.attach(&this->triangulator.front().mesh);
 }
 
 void Application::render(void)
@@ -184,15 +204,75 @@ void Application::render(void)
     glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    if (glfwGetKey(this->window, GLFW_KEY_C))
+        this->engine = Mesh::CAVITY_ENGINE;
+    if (glfwGetKey(this->window, GLFW_KEY_F))
+        this->engine = Mesh::FLIP_ENGINE;
+
+    // the front mesh is the one on screen, the worker only ever writes the back one
+    Mesh& mesh = this->triangulator.front().mesh;
+    // a click edits once, holding the button does not repeat it every frame
+    bool inserting = wentDown(glfwGetMouseButton(this->window, GLFW_MOUSE_BUTTON_LEFT), &this->insertHeld);
+    bool removing = wentDown(glfwGetMouseButton(this->window, GLFW_MOUSE_BUTTON_RIGHT), &this->removeHeld);
+    if (inserting || removing)
+    {
+        double cursorX, cursorY;
+        int width, height;
+        glfwGetCursorPos(this->window, &cursorX, &cursorY);
+        glfwGetWindowSize(this->window, &width, &height);
+        Node cursor(static_cast<float>(2.0 * cursorX / width - 1.0), static_cast<float>(1.0 - 2.0 * cursorY / height));
+        // edits go to the mesh in place, the next update sends only the slots they touched
+        if (inserting)
+            mesh.insert(cursor);
+        else
+        {
+            int vertex = mesh.nearest(cursor);
+            if (vertex != Mesh::NONE)
+                mesh.remove(vertex);
+        }
+    }
+
+    if (wentDown(glfwGetKey(this->window, GLFW_KEY_W), &this->writeHeld))
+    {
+        if (MeshFile::write("triangulation.mesh", mesh))
+            std::cout << "mesh written to triangulation.mesh\n";
+        MeshCodec codec;
+        if (codec.write("triangulation.meshz", mesh))
+            std::cout << "mesh written to triangulation.meshz\n";
+        else
+            std::cout << "Error, " << codec.getError() << '\n';
+    }
+
+    if (wentDown(glfwGetKey(this->window, GLFW_KEY_E), &this->exportHeld))
+    {
+        MeshExporter exporter;
+        for(const char* path : {"triangulation.obj", "triangulation.ply", "triangulation.stl", "triangulation.geojson"})
+        {
+            MeshExporter::Format format;
+            if(MeshExporter::formatOf(path, &format) && exporter.write(path, format, mesh))
+                std::cout << "mesh exported to " << path << '\n';
+            else
+                std::cout << "Error, " << exporter.getError() << '\n';
+        }
+    }
+
+#ifdef TRIANGULATION_TRACE
+    if (wentDown(glfwGetKey(this->window, GLFW_KEY_T), &this->traceHeld) && Tracer::instance().dump("trace.json"))
+        std::cout << "timeline written to trace.json\n";
+#endif
+
+    // holding the key keeps superseding the build, the last one shows once it is let go
     if (glfwGetKey(this->window, GLFW_KEY_R))
     {
-        this->triangulation.clear();
-        this->nodes.clear();
-        this->generateTriangulation();
-        this->bufferData();
+        this->workload.seed++;
+        this->requestTriangulation();
     }
+    this->uploadBuild();
 
-    glDrawArrays(GL_TRIANGLES, 0, this->triangulation.size() * 3);
+    this->renderers[this->drawn].update();
+    this->renderers[this->drawn].draw();
+    // serves the full copies replicas that just opened ask for
+    this->publisher.commit();
 
     glfwSwapBuffers(this->window);
     glfwPollEvents();
@@ -2,20 +2,34 @@
 #define APPLICATION_H
 
 #include <ctime>
+#include <cmath>
+#include <algorithm>
 #include <array>
+#include <string_view>
 #include <vector>
 #include <random>
 #include <iostream>
 #include "C:\C++ Libraries\glad\include\glad\glad.h"
 
 #include "node.h"
+#include "mesh.h"
 #include "vertex.h"
 #include "shader.h"
+#include "stats.h"
+#include "trace.h"
 #include "segment.h"
 #include "segment.h"
 #include "triangle.h"
 #include "callbacks.h"
 #include "utilities.h"
+#include "workload.h"
+#include "pointreader.h"
+#include "meshfile.h"
+#include "meshring.h"
+#include "meshexporter.h"
+#include "meshcodec.h"
+#include "backgroundtriangulator.h"
+#include "meshrenderer.h"
 
 class Application
 {
@@ -23,21 +37,44 @@ public:
     explicit Application(GLuint screenWidth, GLuint screenHeight, const char* appTitle, GLFWframebuffersizefun fbsf);
 
     void start(void);
+    /// triangulates the points of a text, binary or mesh file (see PointReader) instead of generated
+    /// ones; a mesh file holding triangles is shown as stored
+    bool loadPoints(const char* path);
 
 private:
-    void generateTriangulation(void);
-    void formatData(std::vector<Vertex>* data) const;
-    void bufferData(void);
+    /// queues a new triangulation on the background worker, superseding the one under way
+    void requestTriangulation(void);
+    void setupBuffers(void);
+    /// streams a finished build into the hidden renderer a slice per frame and shows it once complete
+    void uploadBuild(void);
     void render(void);
 
+    /// bytes sent to the GPU per frame, so a large build does not stall the frame it arrives in
+    static const std::size_t UPLOAD_SLICE = 8 << 20;
+
     GLFWwindow* window;
     Shader shader;
-    unsigned int vertexBuffer;
-    unsigned int vertexArray;
+    MeshRenderer renderers[2];     // the one drawn and the one a build streams into
+    int drawn = 0;
+    const BackgroundTriangulator::Buffer* uploading = nullptr;
+    std::size_t uploadedVertices = 0; // slots of the build in uploading sent so far
+    std::size_t uploadedFaces = 0;
 
     const int MAX_NODES = 99;
-    std::vector<Triangle> triangulation;
+    WorkloadGenerator generator;
+    Workload workload;
+    bool pointsLoaded = false;
     std::vector<Node> nodes;
+    MeshFile meshFile; // a loaded .mesh file, its points and triangles are used from the mapping
+    Mesh::Engine engine = Mesh::CAVITY_ENGINE;
+    BackgroundTriangulator triangulator;
+    MeshPublisher publisher; // replicates the front mesh to renderer and analytics processes
+    bool publishing = false;
+    // keys and buttons down in the last frame, their actions run once per press
+    bool traceHeld = false;
+    bool writeHeld = false;
+    bool exportHeld = false;
+    bool insertHeld = false, removeHeld = false;
 };
 
 #endif // APPLICATION_H
@@ -0,0 +1,86 @@
+#include "backgroundtriangulator.h"
+
+#include "trace.h"
+
+BackgroundTriangulator::BackgroundTriangulator(void)
+{
+    this->worker = std::thread(&BackgroundTriangulator::workerLoop, this);
+}
+
+BackgroundTriangulator::~BackgroundTriangulator()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        this->cancel.store(true, std::memory_order_relaxed);
+    }
+    this->wake.notify_one();
+    this->worker.join();
+}
+
+void BackgroundTriangulator::request(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending = std::move(job);
+        this->requested++;
+        this->done = false;
+        // the build under way, if any, is superseded
+        this->cancel.store(true, std::memory_order_relaxed);
+    }
+    this->wake.notify_one();
+}
+
+BackgroundTriangulator::Buffer* BackgroundTriangulator::finished(void)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->done ? &this->buffers[1 - this->frontIndex] : nullptr;
+}
+
+void BackgroundTriangulator::swap(void)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if(this->done)
+    {
+        this->frontIndex ^= 1;
+        this->done = false;
+    }
+}
+
+bool BackgroundTriangulator::isBuilding(void)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->running || this->pending != nullptr;
+}
+
+void BackgroundTriangulator::workerLoop(void)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    for(;;)
+    {
+        this->wake.wait(lock, [this]() { return this->stopping || this->pending != nullptr; });
+        if(this->stopping)
+            return;
+        Job job = std::move(this->pending);
+        this->pending = nullptr;
+        std::uint64_t generation = this->requested;
+        // the back buffer is free, done was cleared by the request that queued the job
+        Buffer* back = &this->buffers[1 - this->frontIndex];
+        this->cancel.store(false, std::memory_order_relaxed);
+        this->running = true;
+        lock.unlock();
+
+        bool complete;
+        {
+            TRACE_SCOPE("backgroundBuild");
+            complete = job(back, this->cancel);
+        }
+
+        lock.lock();
+        this->running = false;
+        if(complete && generation == this->requested)
+            this->done = true;
+        else
+            this->cancelled.fetch_add(1, std::memory_order_relaxed);
+    }
+}
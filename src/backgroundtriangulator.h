@@ -0,0 +1,85 @@
+#ifndef BACKGROUNDTRIANGULATOR_H
+#define BACKGROUNDTRIANGULATOR_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+
+/** Builds triangulations on a worker thread into a back buffer while the front one is drawn.
+* request() hands the worker a job and cancels the one it supersedes, which Mesh::insertBatch
+* notices within CANCEL_INTERVAL nodes. Once the latest job has finished, finished() returns the
+* back buffer, which the worker then leaves alone so the caller can upload it at its own pace;
+* swap() makes it the front buffer. Both buffers keep their memory from build to build. Only
+* one thread, the renderer, calls the methods; only the worker runs jobs. */
+class BackgroundTriangulator
+{
+public:
+    /// everything a build produces, up to the index triples of its face slots for drawing
+    class Buffer
+    {
+    public:
+        std::uint64_t seed = 0;
+        std::vector<Node> nodes;
+        Mesh mesh;
+        std::vector<std::array<std::uint32_t, 3>> indices; // see MeshRenderer::format
+    };
+
+    /// fills back, checking cancel between steps
+    /// @return false if it gave up because cancel was set
+    typedef std::function<bool(Buffer* back, const std::atomic<bool>& cancel)> Job;
+
+    BackgroundTriangulator(void);
+    ~BackgroundTriangulator();
+
+    BackgroundTriangulator(const BackgroundTriangulator&) = delete;
+    BackgroundTriangulator& operator = (const BackgroundTriangulator&) = delete;
+
+    /// queues job on the worker, cancelling the build under way; a back buffer returned by
+    /// finished() goes back to the worker and must not be used any more
+    void request(Job job);
+    /// @return the back buffer holding the latest requested build once it is done, else nullptr
+    Buffer* finished(void);
+    /// makes the finished back buffer the front one
+    void swap(void);
+
+    inline Buffer& front(void) noexcept
+    {
+        return this->buffers[this->frontIndex];
+    }
+
+    /// @return true while a requested build has not finished
+    bool isBuilding(void);
+
+    /// @return the builds given up because a newer request superseded them
+    inline std::uint64_t getCancelled(void) const noexcept
+    {
+        return this->cancelled.load(std::memory_order_relaxed);
+    }
+
+private:
+    void workerLoop(void);
+
+    Buffer buffers[2];
+    int frontIndex = 0;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    Job pending;                   // the latest job not started yet
+    std::uint64_t requested = 0;   // jobs requested so far, the last one is the one that counts
+    std::atomic<bool> cancel{false};
+    bool running = false;          // the worker is inside a job
+    bool done = false;             // the back buffer holds the latest build and belongs to the caller
+    bool stopping = false;
+    std::atomic<std::uint64_t> cancelled{0};
+};
+
+#endif // BACKGROUNDTRIANGULATOR_H
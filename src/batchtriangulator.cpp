@@ -0,0 +1,87 @@
+#include "batchtriangulator.h"
+
+#include <algorithm>
+
+#include "smalltriangulation.h"
+#include "trace.h"
+
+BatchTriangulator::BatchTriangulator(unsigned int threadCount)
+    : pool(threadCount), scratch(pool.size())
+{
+}
+
+void BatchTriangulator::triangulateSet(std::span<const Node> nodes, Scratch* scratch)
+{
+    TRACE_SCOPE("set");
+    if(nodes.size() < 3)
+        return;
+
+    if(nodes.size() <= static_cast<std::size_t>(SMALL_KERNEL_LIMIT))
+    {
+        std::array<std::array<int, 3>, 2 * SMALL_KERNEL_LIMIT> triangles;
+        int count = triangulateSmall(nodes, triangles.data());
+        scratch->triangles.insert(scratch->triangles.end(), triangles.begin(), triangles.begin() + count);
+        return;
+    }
+
+    Node lo = nodes[0], hi = nodes[0];
+    for(const Node& n : nodes)
+    {
+        lo = Node(std::min(lo.x, n.x), std::min(lo.y, n.y));
+        hi = Node(std::max(hi.x, n.x), std::max(hi.y, n.y));
+    }
+    scratch->mesh.reset(lo, hi);
+    scratch->mesh.insertBatch(nodes, &scratch->handles, &scratch->order, &scratch->keys);
+    const std::vector<int>& handles = scratch->handles;
+
+    scratch->local.assign(scratch->mesh.vertices.size(), Mesh::NONE);
+    for(std::size_t i = 0; i < handles.size(); i++)
+    {
+        if(handles[i] != Mesh::NONE && scratch->local[handles[i]] == Mesh::NONE)
+            scratch->local[handles[i]] = static_cast<int>(i);
+    }
+
+    scratch->faces.clear();
+    scratch->mesh.getTriangles(&scratch->faces);
+    for(const std::array<int, 3>& f : scratch->faces)
+        scratch->triangles.push_back({scratch->local[f[0]], scratch->local[f[1]], scratch->local[f[2]]});
+}
+
+void BatchTriangulator::triangulate(std::span<const Node> nodes, std::span<const std::size_t> offsets, MeshBatch* out)
+{
+    std::size_t sets = offsets.empty() ? 0 : offsets.size() - 1;
+    this->counts.assign(sets, 0);
+    this->position.assign(sets, 0);
+    this->owner.assign(sets, 0);
+    for(Scratch& s : this->scratch)
+        s.triangles.clear();
+
+    // small sets are cheap, hand them out in chunks to keep the stealing overhead low
+    this->pool.parallelFor(sets, 64, [&](std::size_t begin, std::size_t end, unsigned int worker)
+    {
+        Scratch& s = this->scratch[worker];
+        for(std::size_t set = begin; set < end; set++)
+        {
+            std::size_t first = s.triangles.size();
+            this->triangulateSet(nodes.subspan(offsets[set], offsets[set + 1] - offsets[set]), &s);
+            this->counts[set] = s.triangles.size() - first;
+            this->position[set] = first;
+            this->owner[set] = worker;
+        }
+    });
+
+    out->offsets.resize(sets + 1);
+    out->offsets[0] = 0;
+    for(std::size_t set = 0; set < sets; set++)
+        out->offsets[set + 1] = out->offsets[set] + this->counts[set];
+    out->triangles.resize(out->offsets[sets]);
+
+    this->pool.parallelFor(sets, 256, [&](std::size_t begin, std::size_t end, unsigned int)
+    {
+        for(std::size_t set = begin; set < end; set++)
+        {
+            const std::vector<std::array<int, 3>>& source = this->scratch[this->owner[set]].triangles;
+            std::copy_n(source.begin() + this->position[set], this->counts[set], out->triangles.begin() + out->offsets[set]);
+        }
+    });
+}
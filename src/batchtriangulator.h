@@ -0,0 +1,71 @@
+#ifndef BATCHTRIANGULATOR_H
+#define BATCHTRIANGULATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+#include "threadpool.h"
+
+/** Triangles of many independent point sets packed into one buffer.
+* The triangles of set s are triangles[offsets[s]] .. triangles[offsets[s + 1] - 1],
+* each an index triple into the nodes of that set. */
+class MeshBatch
+{
+public:
+    std::vector<std::array<int, 3>> triangles;
+    std::vector<std::size_t> offsets;
+
+    inline std::size_t setCount(void) const noexcept
+    {
+        return this->offsets.empty() ? 0 : this->offsets.size() - 1;
+    }
+
+    inline std::span<const std::array<int, 3>> operator [] (std::size_t set) const noexcept
+    {
+        return std::span<const std::array<int, 3>>(this->triangles.data() + this->offsets[set], this->offsets[set + 1] - this->offsets[set]);
+    }
+};
+
+/** Triangulates many small independent point sets across a thread pool.
+* Sets of up to SMALL_KERNEL_LIMIT nodes go to the fixed-capacity kernels of
+* smalltriangulation.h, larger ones to a Mesh. Every worker keeps its own mesh
+* and sort, handle and face buffers between sets, so once they have grown to the
+* largest set a set in general position costs no allocation; near-degenerate ones
+* still do when the predicates fall back to exact expansions. Results are gathered
+* into one contiguous MeshBatch. */
+class BatchTriangulator
+{
+public:
+    explicit BatchTriangulator(unsigned int threadCount = std::thread::hardware_concurrency());
+
+    /// the nodes of set s are nodes[offsets[s]] .. nodes[offsets[s + 1] - 1]
+    void triangulate(std::span<const Node> nodes, std::span<const std::size_t> offsets, MeshBatch* out);
+
+private:
+    class alignas(64) Scratch
+    {
+    public:
+        Mesh mesh;
+        std::vector<int> handles;                   // mesh vertex handle of every node of the set
+        std::vector<int> order;                     // insertBatch's Hilbert sort
+        std::vector<std::uint32_t> keys;
+        std::vector<int> local;                     // mesh vertex handle -> index in the set
+        std::vector<std::array<int, 3>> faces;
+        std::vector<std::array<int, 3>> triangles;  // every set this worker produced, back to back
+    };
+
+    void triangulateSet(std::span<const Node> nodes, Scratch* scratch);
+
+    ThreadPool pool;
+    std::vector<Scratch> scratch;
+    std::vector<std::size_t> counts;   // triangles of each set
+    std::vector<std::size_t> position; // where each set starts in its worker's buffer
+    std::vector<unsigned int> owner;   // the worker that produced each set
+};
+
+#endif // BATCHTRIANGULATOR_H
@@ -0,0 +1,203 @@
+#include "conflictgraph.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+
+void ConflictGraph::reset(int pointCount)
+{
+    this->facePoints.assign(this->mesh->faces.size(), std::vector<int>());
+    this->faceGeneration.assign(this->mesh->faces.size(), 0);
+    this->pointFaces.assign(pointCount, std::vector<Conflict>());
+    this->conflictCount.assign(pointCount, 0);
+    this->inserted.assign(pointCount, false);
+    this->pointMark.assign(pointCount, 0);
+    this->markStamp = 0;
+}
+
+bool ConflictGraph::isValid(const Conflict& c) const noexcept
+{
+    return this->mesh->isAlive(c.face) && this->faceGeneration[c.face] == c.generation;
+}
+
+void ConflictGraph::addConflict(int point, int face)
+{
+    this->facePoints[face].push_back(point);
+    this->conflictCount[point]++;
+
+    std::vector<Conflict>& list = this->pointFaces[point];
+    list.push_back(Conflict{face, this->faceGeneration[face]});
+    // drop dead entries once they dominate the list
+    if(static_cast<int>(list.size()) > 2 * this->conflictCount[point] + 8)
+    {
+        list.erase(std::remove_if(list.begin(), list.end(), [this](const Conflict& c) { return !this->isValid(c); }), list.end());
+    }
+}
+
+void ConflictGraph::killFace(int face, std::vector<int>* points)
+{
+    *points = std::move(this->facePoints[face]);
+    this->facePoints[face].clear();
+    this->faceGeneration[face]++;
+    for(int point : *points)
+        this->conflictCount[point]--;
+}
+
+int ConflictGraph::firstConflict(int point)
+{
+    for(const Conflict& c : this->pointFaces[point])
+    {
+        if(this->isValid(c))
+            return c.face;
+    }
+    return Mesh::NONE;
+}
+
+std::vector<int> ConflictGraph::build(Mesh* mesh, const std::vector<Node>& nodes, Order order, unsigned int seed)
+{
+    int count = static_cast<int>(nodes.size());
+    std::vector<int> handles(count, Mesh::NONE);
+
+    mesh->clear();
+    this->mesh = mesh;
+    this->reset(count);
+
+    // every node conflicts with the super-triangle
+    std::vector<int> pending(count);
+    int superFace = mesh->getLastFace();
+    for(int i = 0; i < count; i++)
+    {
+        this->addConflict(i, superFace);
+        pending[i] = i;
+    }
+
+    std::shuffle(pending.begin(), pending.end(), std::mt19937(seed));
+
+    // cheapest-first runs inside rounds of doubling size over the random order, a pure
+    // greedy order would keep the large conflict lists of the outer faces alive forever
+    typedef std::pair<int, int> Entry; // (cavity size, point)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> cheapest;
+    std::vector<bool> queued(count, false);
+    std::size_t roundEnd = 0;
+
+    std::vector<std::vector<int>> oldPoints;
+    std::vector<int> cavitySlot;
+    std::size_t next = 0;
+
+    while(true)
+    {
+        int point;
+        if(order == RANDOM_ORDER)
+        {
+            if(next == pending.size())
+                break;
+            point = pending[next++];
+        }
+        else
+        {
+            if(cheapest.empty())
+            {
+                if(roundEnd == pending.size())
+                    break;
+                std::size_t roundBegin = roundEnd;
+                roundEnd = std::min(pending.size(), std::max<std::size_t>(2 * roundEnd, 1));
+                for(std::size_t k = roundBegin; k < roundEnd; k++)
+                {
+                    queued[pending[k]] = true;
+                    cheapest.emplace(this->conflictCount[pending[k]], pending[k]);
+                }
+                continue;
+            }
+            Entry top = cheapest.top();
+            cheapest.pop();
+            point = top.second;
+            if(this->inserted[point])
+                continue;
+            if(top.first != this->conflictCount[point])
+            {
+                cheapest.emplace(this->conflictCount[point], point);
+                continue;
+            }
+        }
+        this->inserted[point] = true;
+
+        const Node& n = nodes[point];
+        int face = this->firstConflict(point);
+        if(face == Mesh::NONE)
+        {
+            // only a node already in the mesh conflicts with nothing
+            face = mesh->locate(n);
+            for(int i = 0; i < 3; i++)
+            {
+                if(mesh->vertices[mesh->faces[face].v[i]] == n)
+                    handles[point] = mesh->faces[face].v[i];
+            }
+            continue;
+        }
+
+        mesh->findCavity(n, face);
+
+        // take the conflict lists of the cavity before its slots are recycled by the fan
+        const std::vector<int>& cavity = mesh->getCavity();
+        if(oldPoints.size() < cavity.size())
+            oldPoints.resize(cavity.size());
+        if(cavitySlot.size() < mesh->faces.size())
+            cavitySlot.resize(mesh->faces.size());
+        for(std::size_t c = 0; c < cavity.size(); c++)
+        {
+            this->killFace(cavity[c], &oldPoints[c]);
+            cavitySlot[cavity[c]] = static_cast<int>(c);
+        }
+
+        handles[point] = mesh->fillCavity(n);
+        this->pointFaces[point].clear();
+        if(this->facePoints.size() < mesh->faces.size())
+        {
+            this->facePoints.resize(mesh->faces.size());
+            this->faceGeneration.resize(mesh->faces.size(), 0);
+        }
+
+        // a point conflicts with a new face only if it conflicted with one of the two faces sharing its base edge
+        for(const Mesh::BoundaryEdge& e : mesh->getBoundary())
+        {
+            unsigned int edgeStamp = ++this->markStamp;
+
+            for(int side = 0; side < 2; side++)
+            {
+                if(side == 1 && e.outside == Mesh::NONE)
+                    break;
+                const std::vector<int>& candidates = side == 0 ? oldPoints[cavitySlot[e.inside]] : this->facePoints[e.outside];
+                for(std::size_t k = 0; k < candidates.size(); k++)
+                {
+                    int q = candidates[k];
+                    if(this->inserted[q] || this->pointMark[q] == edgeStamp)
+                        continue;
+                    this->pointMark[q] = edgeStamp;
+                    if(mesh->inCircle(e.created, nodes[q]) > 0.0)
+                        this->addConflict(q, e.created);
+                }
+            }
+        }
+
+        // every queued point of the cavity changed its cavity size
+        if(order == CHEAPEST_FIRST)
+        {
+            unsigned int touchedStamp = ++this->markStamp;
+            for(std::size_t c = 0; c < cavity.size(); c++)
+            {
+                for(int q : oldPoints[c])
+                {
+                    if(this->inserted[q] || !queued[q] || this->pointMark[q] == touchedStamp)
+                        continue;
+                    this->pointMark[q] = touchedStamp;
+                    cheapest.emplace(this->conflictCount[q], q);
+                }
+            }
+        }
+    }
+
+    this->mesh = nullptr;
+    return handles;
+}
@@ -0,0 +1,52 @@
+#ifndef CONFLICTGRAPH_H
+#define CONFLICTGRAPH_H
+
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+
+/** Randomized incremental construction driven by a conflict graph.
+* Every uninserted point keeps the list of faces whose circumcircle contains it,
+* and every face the list of points in conflict with it. The cavity of the next
+* point is therefore known without any point location, and after each insertion
+* only the points of the destroyed faces (and of their outer neighbours) are
+* tested against the new fan, giving O(n log n) expected time for random order. */
+class ConflictGraph
+{
+public:
+    enum Order
+    {
+        RANDOM_ORDER,   // the order the expected bounds are proven for
+        CHEAPEST_FIRST  // random rounds of doubling size, smallest cavity first within a round
+    };
+
+    /// clears mesh and triangulates nodes into it
+    /// @return the vertex handle of every node in input order
+    std::vector<int> build(Mesh* mesh, const std::vector<Node>& nodes, Order order = RANDOM_ORDER, unsigned int seed = 0);
+
+private:
+    class Conflict
+    {
+    public:
+        int face;
+        unsigned int generation;
+    };
+
+    void reset(int pointCount);
+    void addConflict(int point, int face);
+    void killFace(int face, std::vector<int>* points);
+    bool isValid(const Conflict& c) const noexcept;
+    int firstConflict(int point);
+
+    const Mesh* mesh = nullptr;
+    std::vector<std::vector<int>> facePoints;       // uninserted points in conflict with each face slot
+    std::vector<unsigned int> faceGeneration;       // bumped each time a face slot dies
+    std::vector<std::vector<Conflict>> pointFaces;  // faces in conflict with each point, may hold dead entries
+    std::vector<int> conflictCount;                 // live entries of pointFaces, i.e. the cavity size
+    std::vector<bool> inserted;
+    std::vector<unsigned int> pointMark;
+    unsigned int markStamp = 0;
+};
+
+#endif // CONFLICTGRAPH_H
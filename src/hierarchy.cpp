@@ -0,0 +1,119 @@
+#include "hierarchy.h"
+
+#include "utilities.h"
+
+DelaunayHierarchy::DelaunayHierarchy(const Node& minCorner, const Node& maxCorner, unsigned int seed)
+    : levels(MAX_LEVELS, Mesh(minCorner, maxCorner)), down(MAX_LEVELS), up(MAX_LEVELS), rng(seed)
+{
+    this->clear();
+}
+
+void DelaunayHierarchy::clear(void)
+{
+    for(int k = 0; k < MAX_LEVELS; k++)
+    {
+        this->levels[k].clear();
+        // the super vertices are shared by every level
+        this->down[k] = {0, 1, 2};
+        this->up[k] = {0, 1, 2};
+    }
+}
+
+int DelaunayHierarchy::randomLevel(void)
+{
+    int level = 0;
+    while(level < MAX_LEVELS - 1 && this->rng() % RATIO == 0)
+        level++;
+    return level;
+}
+
+int DelaunayHierarchy::nearestVertex(const Mesh& mesh, int face, const Node& n) const
+{
+    const Mesh::Face& f = mesh.faces[face];
+    int nearest = f.v[0];
+    double best = squaredDistance(mesh.vertices[f.v[0]], n);
+    for(int i = 1; i < 3; i++)
+    {
+        double d = squaredDistance(mesh.vertices[f.v[i]], n);
+        if(d < best)
+        {
+            best = d;
+            nearest = f.v[i];
+        }
+    }
+    return nearest;
+}
+
+void DelaunayHierarchy::locateAll(const Node& n, std::vector<int>* faces)
+{
+    faces->assign(MAX_LEVELS, Mesh::NONE);
+
+    int hint = this->levels.back().getLastFace();
+    for(int k = MAX_LEVELS - 1; k >= 0; k--)
+    {
+        int face = this->levels[k].locate(n, hint);
+        (*faces)[k] = face;
+        if(face == Mesh::NONE)
+            return;
+        if(k > 0)
+        {
+            int vertex = this->down[k][this->nearestVertex(this->levels[k], face, n)];
+            hint = this->levels[k - 1].vertexFace[vertex];
+        }
+    }
+}
+
+int DelaunayHierarchy::locate(const Node& n)
+{
+    this->locateAll(n, &this->located);
+    return this->located.front();
+}
+
+int DelaunayHierarchy::insert(const Node& n)
+{
+    this->locateAll(n, &this->located);
+    if(this->located.front() == Mesh::NONE)
+        return Mesh::NONE;
+
+    // an equal node is a corner of the face holding n, a new vertex never is, even in a recycled slot
+    Mesh& mesh = this->base();
+    const Mesh::Face face = mesh.faces[this->located.front()];
+    int vertex = mesh.insert(n, this->located.front());
+    if(vertex == Mesh::NONE || vertex == face.v[0] || vertex == face.v[1] || vertex == face.v[2])
+        return vertex; // already present at every level it belongs to
+    this->up[0].resize(mesh.vertices.size(), Mesh::NONE);
+    this->up[0][vertex] = Mesh::NONE;
+
+    // the links are indexed by handle and a recycled slot may hold those of a removed vertex
+    int level = this->randomLevel();
+    int below = vertex;
+    for(int k = 1; k <= level; k++)
+    {
+        int copy = this->levels[k].insert(n, this->located[k]);
+        this->down[k].resize(this->levels[k].vertices.size(), Mesh::NONE);
+        this->up[k].resize(this->levels[k].vertices.size(), Mesh::NONE);
+        this->down[k][copy] = below;
+        this->up[k][copy] = Mesh::NONE;
+        this->up[k - 1][below] = copy;
+        below = copy;
+    }
+    return vertex;
+}
+
+bool DelaunayHierarchy::remove(int vertex)
+{
+    if(!this->base().remove(vertex))
+        return false;
+
+    int current = vertex;
+    for(int k = 0; k < MAX_LEVELS - 1; k++)
+    {
+        int copy = this->up[k][current];
+        this->up[k][current] = Mesh::NONE;
+        if(copy == Mesh::NONE)
+            break;
+        this->levels[k + 1].remove(copy);
+        current = copy;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include <random>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+
+/** Delaunay hierarchy (Devillers, "The Delaunay Hierarchy", 2002).
+* Level 0 is the full triangulation; every vertex of level k is also inserted in
+* level k + 1 with probability 1 / RATIO. Locating a node walks each sparse level
+* and seeds the walk below with the nearest vertex found, giving O(log n)
+* expected location for random-order queries. */
+class DelaunayHierarchy
+{
+public:
+    DelaunayHierarchy() : DelaunayHierarchy(Node(-1.0f, -1.0f), Node(1.0f, 1.0f)) {}
+    DelaunayHierarchy(const Node& minCorner, const Node& maxCorner, unsigned int seed = 0);
+
+    /// @return the vertex handle of n in the base mesh, see Mesh::insert
+    int insert(const Node& n);
+    /// removes a base vertex from every level it appears in
+    bool remove(int vertex);
+    /// @return the base face containing n, or Mesh::NONE
+    int locate(const Node& n);
+    void clear(void);
+
+    /// selects the insertion engine of every level
+    inline void setEngine(Mesh::Engine engine) noexcept
+    {
+        for(Mesh& level : this->levels)
+            level.setEngine(engine);
+    }
+
+    inline Mesh& base(void) noexcept
+    {
+        return this->levels.front();
+    }
+
+    inline const Mesh& base(void) const noexcept
+    {
+        return this->levels.front();
+    }
+
+    inline int levelCount(void) const noexcept
+    {
+        return static_cast<int>(this->levels.size());
+    }
+
+private:
+    friend class Snapshot;
+
+    static const int RATIO = 30;
+    static const int MAX_LEVELS = 5;
+
+    int randomLevel(void);
+    /// fills faces[k] with the face containing n at every level k
+    void locateAll(const Node& n, std::vector<int>* faces);
+    int nearestVertex(const Mesh& mesh, int face, const Node& n) const;
+
+    std::vector<Mesh> levels;
+    std::vector<std::vector<int>> down; // down[k][v]: copy of level k vertex v in level k - 1
+    std::vector<std::vector<int>> up;   // up[k][v]: copy of level k vertex v in level k + 1, or NONE
+    std::vector<int> located;
+    std::mt19937 rng;
+};
+
+#endif // HIERARCHY_H
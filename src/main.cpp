@@ -1,8 +1,11 @@
 #include "application.h"
 
-int main()
+int main(int argc, char** argv)
 {
     Application mainApp(500, 250, "Bowyer Watson Algorithm", framebuffer_size_callback);
+    // an optional point file, e.g. points.xyz or points.bin
+    if(argc > 1)
+        mainApp.loadPoints(argv[1]);
     mainApp.start();
     return 0;
 }
@@ -0,0 +1,800 @@
+#include "mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+#include "spatialsort.h"
+#include "stats.h"
+#include "trace.h"
+#include "superpredicates.h"
+#include "utilities.h"
+
+const int Mesh::NONE;
+
+double Mesh::orient(int a, int b, const Node& n) const
+{
+    if(!this->isSuperVertex(a) && !this->isSuperVertex(b))
+        return orient2d(this->vertices[a], this->vertices[b], n);
+    return symbolicOrient(this->point(a), this->point(b), SymbolicPoint{&n, NONE});
+}
+
+double Mesh::orient(int a, int b, int c) const
+{
+    if(!this->isSuperVertex(a) && !this->isSuperVertex(b) && !this->isSuperVertex(c))
+        return orient2d(this->vertices[a], this->vertices[b], this->vertices[c]);
+    return symbolicOrient(this->point(a), this->point(b), this->point(c));
+}
+
+double Mesh::inCircle(int a, int b, int c, const Node& n) const
+{
+    if(!this->isSuperVertex(a) && !this->isSuperVertex(b) && !this->isSuperVertex(c))
+        return ::inCircle(this->vertices[a], this->vertices[b], this->vertices[c], n);
+    return symbolicInCircle(this->point(a), this->point(b), this->point(c), SymbolicPoint{&n, NONE});
+}
+
+double Mesh::inCircle(int a, int b, int c, int d) const
+{
+    if(!this->isSuperVertex(a) && !this->isSuperVertex(b) && !this->isSuperVertex(c) && !this->isSuperVertex(d))
+        return ::inCircle(this->vertices[a], this->vertices[b], this->vertices[c], this->vertices[d]);
+    return symbolicInCircle(this->point(a), this->point(b), this->point(c), this->point(d));
+}
+
+SymbolicPoint Mesh::point(int vertex) const
+{
+    if(this->isSuperVertex(vertex))
+        return SymbolicPoint{nullptr, vertex};
+    return SymbolicPoint{&this->vertices[vertex], NONE};
+}
+
+Mesh::Mesh(const Node& minCorner, const Node& maxCorner)
+{
+    this->reset(minCorner, maxCorner);
+}
+
+void Mesh::reset(const Node& minCorner, const Node& maxCorner)
+{
+    float cx = (minCorner.x + maxCorner.x) / 2.0f;
+    float cy = (minCorner.y + maxCorner.y) / 2.0f;
+    float d  = std::max(std::max(maxCorner.x - minCorner.x, maxCorner.y - minCorner.y), 1e-3f);
+
+    // the super vertices are symbolic, these coordinates only serve distance heuristics
+    this->vertices = {Node(cx - 20.0f * d, cy - 10.0f * d), Node(cx + 20.0f * d, cy - 10.0f * d), Node(cx, cy + 20.0f * d)};
+    this->clear();
+}
+
+void Mesh::clear(void)
+{
+    this->vertices.resize(3);
+    this->faces.clear();
+    this->freeFaces.clear();
+    this->freeVertices.clear();
+    this->faceMark.clear();
+    this->markStamp = 0;
+
+    this->faces.push_back(Face{{0, 1, 2}, {NONE, NONE, NONE}});
+    this->vertexFace.assign(3, 0);
+    this->lastFace = 0;
+    for(MeshJournal* journal : this->journals)
+    {
+        journal->reset();
+        journal->cleared = true;
+    }
+}
+
+int Mesh::newFace(int a, int b, int c)
+{
+    int face;
+    if(!this->freeFaces.empty())
+    {
+        face = this->freeFaces.back();
+        this->freeFaces.pop_back();
+    }
+    else
+    {
+        face = static_cast<int>(this->faces.size());
+        this->faces.emplace_back();
+    }
+    STATS_ADD(facesAllocated, 1);
+    this->faces[face] = Face{{a, b, c}, {NONE, NONE, NONE}};
+    for(MeshJournal* journal : this->journals)
+        journal->faces.push_back(face);
+    return face;
+}
+
+int Mesh::newVertex(const Node& n)
+{
+    int vertex;
+    if(!this->freeVertices.empty())
+    {
+        vertex = this->freeVertices.back();
+        this->freeVertices.pop_back();
+        this->vertices[vertex] = n;
+    }
+    else
+    {
+        vertex = static_cast<int>(this->vertices.size());
+        this->vertices.push_back(n);
+        this->vertexFace.push_back(NONE);
+    }
+    for(MeshJournal* journal : this->journals)
+        journal->vertices.push_back(vertex);
+    return vertex;
+}
+
+void Mesh::freeFace(int face)
+{
+    this->faces[face].v = {NONE, NONE, NONE};
+    this->freeFaces.push_back(face);
+    for(MeshJournal* journal : this->journals)
+        journal->faces.push_back(face);
+    STATS_ADD(facesFreed, 1);
+}
+
+void Mesh::linkFaces(int face, int edge, int other, int otherEdge)
+{
+    this->faces[face].adj[edge] = other;
+    if(other != NONE)
+        this->faces[other].adj[otherEdge] = face;
+}
+
+void Mesh::detach(int face)
+{
+    const Face f = this->faces[face];
+    for(int i = 0; i < 3; i++)
+    {
+        this->replaceNeighbour(f.adj[i], face, NONE);
+        // keep pointing the vertex at a face still there, the two neighbours around v[i] share it
+        if(this->vertexFace[f.v[i]] == face)
+            this->vertexFace[f.v[i]] = f.adj[(i + 1) % 3] != NONE ? f.adj[(i + 1) % 3] : f.adj[(i + 2) % 3];
+    }
+    this->freeFace(face);
+    if(this->lastFace == face)
+        this->lastFace = NONE;
+}
+
+void Mesh::releaseVertex(int vertex)
+{
+    this->vertexFace[vertex] = NONE;
+    this->freeVertices.push_back(vertex);
+    for(MeshJournal* journal : this->journals)
+        journal->vertices.push_back(vertex);
+}
+
+int Mesh::anyFace(void) const
+{
+    if(this->isAlive(this->lastFace))
+        return this->lastFace;
+    for(int f = 0; f < static_cast<int>(this->faces.size()); f++)
+    {
+        if(this->isAlive(f))
+            return f;
+    }
+    return NONE;
+}
+
+int Mesh::locate(const Node& n, int hint) const
+{
+    STATS_PHASE(LOCATE);
+    TRACE_DETAIL("locate");
+    STATS_ADD(locations, 1);
+    int face = this->isAlive(hint) ? hint : this->anyFace();
+    int previous = NONE;
+    unsigned int step = 0;
+
+    // visibility walk: cross any edge that separates the face from n
+    while(face != NONE)
+    {
+        const Face& f = this->faces[face];
+        int next = face;
+        for(int k = 0; k < 3; k++)
+        {
+            // rotate the first edge tested so the walk cannot cycle on degenerate input
+            int i = (k + step) % 3;
+            if(f.adj[i] == previous && previous != NONE)
+                continue;
+            if(this->orient(f.v[(i + 1) % 3], f.v[(i + 2) % 3], n) < 0.0)
+            {
+                next = f.adj[i];
+                break;
+            }
+        }
+        STATS_ADD(walkSteps, 1);
+        if(next == face)
+            return face;
+        previous = face;
+        face = next;
+        step++;
+    }
+    return NONE;
+}
+
+int Mesh::nearest(const Node& n, int hint) const
+{
+    int face = this->locate(n, hint);
+    if(face == NONE)
+        return NONE;
+
+    int vertex = NONE;
+    double best = 0.0;
+    for(int v : this->faces[face].v)
+    {
+        if(this->isSuperVertex(v))
+            continue;
+        double d = squaredDistance(this->vertices[v], n);
+        if(vertex == NONE || d < best)
+        {
+            vertex = v;
+            best = d;
+        }
+    }
+    if(vertex == NONE)
+        return NONE;
+
+    // a vertex that is not the nearest always has a Delaunay neighbour closer to n
+    for(bool moved = true; moved; )
+    {
+        moved = false;
+        int first = this->vertexFace[vertex];
+        int star = first;
+        do
+        {
+            const Face& f = this->faces[star];
+            int i = this->indexOf(star, vertex);
+            int neighbour = f.v[(i + 1) % 3];
+            if(!this->isSuperVertex(neighbour))
+            {
+                double d = squaredDistance(this->vertices[neighbour], n);
+                if(d < best)
+                {
+                    vertex = neighbour;
+                    best = d;
+                    moved = true;
+                    break;
+                }
+            }
+            star = f.adj[(i + 1) % 3];
+        }
+        while(star != first && star != NONE);
+    }
+    return vertex;
+}
+
+int Mesh::insert(const Node& n, int hint)
+{
+    int face = this->locate(n, hint != NONE ? hint : this->lastFace);
+    if(face == NONE)
+        return NONE;
+
+    for(int i = 0; i < 3; i++)
+    {
+        if(this->vertices[this->faces[face].v[i]] == n)
+            return this->faces[face].v[i];
+    }
+
+    if(this->engine == FLIP_ENGINE)
+        return this->insertByFlips(n, face);
+    this->findCavity(n, face);
+    return this->fillCavity(n);
+}
+
+std::vector<int> Mesh::insertBatch(std::span<const Node> nodes, const std::atomic<bool>* cancel)
+{
+    std::vector<int> handles, order;
+    std::vector<std::uint32_t> keys;
+    this->insertBatch(nodes, &handles, &order, &keys, cancel);
+    return handles;
+}
+
+void Mesh::insertBatch(std::span<const Node> nodes, std::vector<int>* handleBuffer, std::vector<int>* order,
+                       std::vector<std::uint32_t>* keys, const std::atomic<bool>* cancel)
+{
+    TRACE_SCOPE("insertBatch");
+    std::vector<int>& handles = *handleBuffer;
+    handles.assign(nodes.size(), NONE);
+    {
+        STATS_PHASE(SORT);
+        TRACE_SCOPE("sort");
+        hilbertOrder(nodes, order, keys);
+    }
+
+    // a planar triangulation has about two faces per vertex
+    this->vertices.reserve(this->vertices.size() + nodes.size());
+    this->vertexFace.reserve(this->vertexFace.size() + nodes.size());
+    this->faces.reserve(this->faces.size() + 2 * nodes.size());
+
+    int previous = NONE;
+    std::size_t inserted = 0;
+    for(int i : *order)
+    {
+        if(cancel != nullptr && ++inserted % CANCEL_INTERVAL == 0 && cancel->load(std::memory_order_relaxed))
+            break;
+        // sorting put equal nodes next to each other, existing vertices are caught by insert()
+        if(previous != NONE && nodes[i] == nodes[previous])
+            handles[i] = handles[previous];
+        else
+            handles[i] = this->insert(nodes[i], this->lastFace);
+        previous = i;
+    }
+}
+
+/// key of the directed edge a -> b
+static inline std::uint64_t edgeKey(int a, int b) noexcept
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(a)) << 32) | static_cast<std::uint32_t>(b);
+}
+
+bool Mesh::assign(std::span<const Node> nodes, std::span<const std::array<int, 3>> triangles,
+                  std::span<const std::array<int, 3>> adjacency)
+{
+    TRACE_SCOPE("assign");
+    const int nodeCount = static_cast<int>(nodes.size());
+    const int triangleCount = static_cast<int>(triangles.size());
+    if(triangles.empty() || (!adjacency.empty() && adjacency.size() != triangles.size()))
+        return false;
+    for(const Node& n : nodes)
+    {
+        if(!std::isfinite(n.x) || !std::isfinite(n.y))
+            return false;
+    }
+
+    // 1 for a node some triangle uses, 2 for one on the boundary
+    std::vector<unsigned char> used(nodes.size(), 0);
+    for(const std::array<int, 3>& t : triangles)
+    {
+        for(int v : t)
+        {
+            if(v < 0 || v >= nodeCount)
+                return false;
+            used[v] = 1;
+        }
+        if(orient2d(nodes[t[0]], nodes[t[1]], nodes[t[2]]) <= 0.0)
+            return false;
+    }
+    if(std::find(used.begin(), used.end(), 0) != used.end())
+        return false;
+
+    std::vector<std::array<int, 3>> links(adjacency.begin(), adjacency.end());
+    if(links.empty())
+    {
+        // edge i of a triangle runs from v[i + 1] to v[i + 2], its neighbour holds it reversed
+        std::unordered_map<std::uint64_t, int> edges;
+        edges.reserve(3 * triangles.size());
+        for(int t = 0; t < triangleCount; t++)
+        {
+            for(int i = 0; i < 3; i++)
+            {
+                if(!edges.emplace(edgeKey(triangles[t][(i + 1) % 3], triangles[t][(i + 2) % 3]), 3 * t + i).second)
+                    return false;
+            }
+        }
+        links.resize(triangles.size());
+        for(int t = 0; t < triangleCount; t++)
+        {
+            for(int i = 0; i < 3; i++)
+            {
+                auto twin = edges.find(edgeKey(triangles[t][(i + 2) % 3], triangles[t][(i + 1) % 3]));
+                links[t][i] = twin == edges.end() ? NONE : twin->second / 3;
+            }
+        }
+    }
+
+    // every link points back across the same edge and every interior edge is Delaunay
+    std::unordered_map<std::uint64_t, int> boundary; // edges without a neighbour, to 3 t + i
+    for(int t = 0; t < triangleCount; t++)
+    {
+        const std::array<int, 3>& v = triangles[t];
+        for(int i = 0; i < 3; i++)
+        {
+            int a = v[(i + 1) % 3], b = v[(i + 2) % 3], other = links[t][i];
+            if(other == NONE)
+            {
+                used[a] = used[b] = 2;
+                if(!boundary.emplace(edgeKey(a, b), 3 * t + i).second)
+                    return false;
+                continue;
+            }
+            if(other < 0 || other >= triangleCount)
+                return false;
+            const std::array<int, 3>& w = triangles[other];
+            int j = w[0] == a ? 1 : w[1] == a ? 2 : w[2] == a ? 0 : NONE;
+            if(j == NONE || w[(j + 1) % 3] != b || links[other][j] != t)
+                return false;
+            if(t < other && ::inCircle(nodes[v[0]], nodes[v[1]], nodes[v[2]], nodes[w[j]]) > 0.0)
+                return false;
+        }
+    }
+
+    // the super faces around the hull are those of the boundary nodes triangulated alone
+    std::vector<Node> hullNodes;
+    std::vector<int> hullIndex;
+    for(int v = 0; v < nodeCount; v++)
+    {
+        if(used[v] == 2)
+        {
+            hullNodes.push_back(nodes[v]);
+            hullIndex.push_back(v);
+        }
+    }
+    Mesh hull;
+    std::vector<int> handles = hull.insertBatch(hullNodes);
+    std::vector<int> vertexOf(hull.vertices.size(), NONE);
+    vertexOf[0] = 0;
+    vertexOf[1] = 1;
+    vertexOf[2] = 2;
+    for(std::size_t k = 0; k < handles.size(); k++)
+    {
+        if(handles[k] == NONE || vertexOf[handles[k]] != NONE)
+            return false;
+        vertexOf[handles[k]] = hullIndex[k] + 3;
+    }
+
+    // the stored triangles keep their index, the super faces follow them
+    std::vector<int> faceOf(hull.faces.size(), NONE);
+    int faceCount = triangleCount;
+    for(int f = 0; f < static_cast<int>(hull.faces.size()); f++)
+    {
+        if(hull.isAlive(f) && hull.isSuperFace(f))
+            faceOf[f] = faceCount++;
+    }
+    std::vector<Face> built(faceCount);
+    for(int t = 0; t < triangleCount; t++)
+        built[t] = Face{{triangles[t][0] + 3, triangles[t][1] + 3, triangles[t][2] + 3}, links[t]};
+    std::size_t matched = 0;
+    for(int f = 0; f < static_cast<int>(hull.faces.size()); f++)
+    {
+        if(faceOf[f] == NONE)
+            continue;
+        const Face& source = hull.faces[f];
+        Face& face = built[faceOf[f]];
+        for(int i = 0; i < 3; i++)
+            face.v[i] = vertexOf[source.v[i]];
+        for(int i = 0; i < 3; i++)
+        {
+            int other = source.adj[i];
+            if(other == NONE || faceOf[other] != NONE)
+            {
+                face.adj[i] = other == NONE ? NONE : faceOf[other];
+                continue;
+            }
+            // a hull edge a -> b seen from outside, the stored triangle inside runs b -> a
+            int a = face.v[(i + 1) % 3] - 3, b = face.v[(i + 2) % 3] - 3;
+            auto inside = boundary.find(edgeKey(b, a));
+            if(inside == boundary.end())
+                return false;
+            face.adj[i] = inside->second / 3;
+            built[inside->second / 3].adj[inside->second % 3] = faceOf[f];
+            matched++;
+        }
+    }
+    // a boundary edge left over bounds a hole or a concave part
+    if(matched != boundary.size())
+        return false;
+
+    this->vertices.resize(3);
+    this->vertices.insert(this->vertices.end(), nodes.begin(), nodes.end());
+    this->faces = std::move(built);
+    this->vertexFace.assign(this->vertices.size(), NONE);
+    for(int f = 0; f < faceCount; f++)
+    {
+        for(int v : this->faces[f].v)
+            this->vertexFace[v] = f;
+    }
+    this->freeFaces.clear();
+    this->freeVertices.clear();
+    this->faceMark.clear();
+    this->markStamp = 0;
+    this->lastFace = 0;
+    for(MeshJournal* journal : this->journals)
+    {
+        journal->reset();
+        journal->cleared = true;
+    }
+    return true;
+}
+
+void Mesh::replaceNeighbour(int face, int oldNeighbour, int newNeighbour)
+{
+    if(face == NONE)
+        return;
+    std::array<int, 3>& adj = this->faces[face].adj;
+    for(int i = 0; i < 3; i++)
+    {
+        if(adj[i] == oldNeighbour)
+            adj[i] = newNeighbour;
+    }
+}
+
+void Mesh::setFace(int face, int a, int b, int c, int adjA, int adjB, int adjC)
+{
+    this->faces[face] = Face{{a, b, c}, {adjA, adjB, adjC}};
+    for(MeshJournal* journal : this->journals)
+        journal->faces.push_back(face);
+    this->vertexFace[a] = face;
+    this->vertexFace[b] = face;
+    this->vertexFace[c] = face;
+}
+
+int Mesh::insertByFlips(const Node& n, int face)
+{
+    STATS_PHASE(RETRIANGULATE);
+    TRACE_DETAIL("flip");
+    int p = this->newVertex(n);
+
+    // find whether n lies on an edge of the containing face
+    const Face f = this->faces[face];
+    int onEdge = NONE;
+    for(int i = 0; i < 3; i++)
+    {
+        if(this->orient(f.v[(i + 1) % 3], f.v[(i + 2) % 3], n) == 0.0)
+            onEdge = i;
+    }
+
+    // every face touching p keeps it as v[0], so the edge to legalize is always adj[0]
+    this->stack.clear();
+    if(onEdge == NONE)
+    {
+        int a = f.v[0], b = f.v[1], c = f.v[2];
+        int f0 = face, f1 = this->newFace(p, b, c), f2 = this->newFace(p, c, a);
+        this->setFace(f0, p, a, b, f.adj[2], f1, f2);
+        this->setFace(f1, p, b, c, f.adj[0], f2, f0);
+        this->setFace(f2, p, c, a, f.adj[1], f0, f1);
+        this->replaceNeighbour(f.adj[0], face, f1);
+        this->replaceNeighbour(f.adj[1], face, f2);
+        this->stack = {f0, f1, f2};
+    }
+    else
+    {
+        // split both faces sharing the edge a -> b into two
+        int a = f.v[(onEdge + 1) % 3], b = f.v[(onEdge + 2) % 3], c = f.v[onEdge];
+        int fa = f.adj[(onEdge + 1) % 3], fb = f.adj[(onEdge + 2) % 3];
+        int g = f.adj[onEdge];
+
+        int f1 = face, f2 = this->newFace(p, c, a);
+        int g1 = NONE, g2 = NONE;
+        if(g != NONE)
+        {
+            const Face h = this->faces[g];
+            int j = (this->indexOf(g, a) + 1) % 3; // h.v[j] is the vertex opposite the edge
+            int d = h.v[j];
+            int ga = h.adj[(j + 2) % 3], gb = h.adj[(j + 1) % 3];
+
+            g1 = g;
+            g2 = this->newFace(p, a, d);
+            this->setFace(g1, p, d, b, ga, f1, g2);
+            this->setFace(g2, p, a, d, gb, g1, f2);
+            this->replaceNeighbour(gb, g, g2);
+        }
+        this->setFace(f1, p, b, c, fa, f2, g1);
+        this->setFace(f2, p, c, a, fb, g2, f1);
+        this->replaceNeighbour(fb, face, f2);
+
+        this->stack = {f1, f2};
+        if(g != NONE)
+        {
+            this->stack.push_back(g1);
+            this->stack.push_back(g2);
+        }
+    }
+
+    this->legalize();
+    this->lastFace = this->vertexFace[p];
+    return p;
+}
+
+void Mesh::flip(int face)
+{
+    // face = (p, x, y) and its neighbour g = (d, y, x) across x - y become (p, x, d) and (p, d, y)
+    STATS_ADD(flips, 1);
+    const Face f = this->faces[face];
+    int g = f.adj[0];
+    const Face h = this->faces[g];
+    int j = (this->indexOf(g, f.v[1]) + 1) % 3;
+
+    int p = f.v[0], x = f.v[1], y = f.v[2], d = h.v[j];
+    int fx = f.adj[1], fy = f.adj[2];
+    int gx = h.adj[(j + 2) % 3], gy = h.adj[(j + 1) % 3];
+
+    this->setFace(face, p, x, d, gy, g, fy);
+    this->setFace(g, p, d, y, gx, fx, face);
+    this->replaceNeighbour(gy, g, face);
+    this->replaceNeighbour(fx, face, g);
+}
+
+void Mesh::legalize(void)
+{
+    while(!this->stack.empty())
+    {
+        int face = this->stack.back();
+        this->stack.pop_back();
+
+        const Face& f = this->faces[face];
+        int g = f.adj[0];
+        if(g == NONE)
+            continue;
+        const Face& h = this->faces[g];
+        int d = h.v[(this->indexOf(g, f.v[1]) + 1) % 3];
+        if(this->inCircle(f.v[0], f.v[1], f.v[2], d) > 0.0)
+        {
+            this->flip(face);
+            this->stack.push_back(face);
+            this->stack.push_back(g);
+        }
+    }
+}
+
+void Mesh::findCavity(const Node& n, int face)
+{
+    STATS_PHASE(CAVITY);
+    TRACE_DETAIL("cavity");
+    if(this->faceMark.size() < this->faces.size())
+        this->faceMark.resize(this->faces.size(), 0);
+    if(++this->markStamp == 0)
+    {
+        std::fill(this->faceMark.begin(), this->faceMark.end(), 0);
+        this->markStamp = 1;
+    }
+
+    this->cavity.clear();
+    this->boundary.clear();
+    this->stack.assign(1, face);
+    this->faceMark[face] = this->markStamp;
+
+    // badTriangles := faces whose circumcircle contains n, grown from the located face
+    while(!this->stack.empty())
+    {
+        int current = this->stack.back();
+        this->stack.pop_back();
+        this->cavity.push_back(current);
+
+        const Face& f = this->faces[current];
+        for(int i = 0; i < 3; i++)
+        {
+            int other = f.adj[i];
+            if(other != NONE && this->faceMark[other] == this->markStamp)
+                continue;
+            if(other != NONE)
+            {
+                if(this->inCircle(other, n) > 0.0)
+                {
+                    this->faceMark[other] = this->markStamp;
+                    this->stack.push_back(other);
+                    continue;
+                }
+            }
+            // polygon := edges of the cavity not shared with another bad face
+            this->boundary.push_back(BoundaryEdge{f.v[(i + 1) % 3], f.v[(i + 2) % 3], current, other, NONE});
+        }
+    }
+}
+
+int Mesh::fillCavity(const Node& n)
+{
+    STATS_PHASE(RETRIANGULATE);
+    TRACE_DETAIL("retriangulate");
+    STATS_ADD(cavities, 1);
+    STATS_ADD(boundaryEdges, this->boundary.size());
+    STATS_CAVITY(this->cavity.size());
+
+    int vertex = this->newVertex(n);
+
+    for(int bad : this->cavity)
+        this->freeFace(bad);
+
+    // form a triangle from each boundary edge to the new vertex
+    for(BoundaryEdge& e : this->boundary)
+    {
+        e.created = this->newFace(e.a, e.b, vertex);
+        if(e.outside != NONE)
+            this->linkFaces(e.created, 2, e.outside, (this->indexOf(e.outside, e.a) + 1) % 3);
+        this->vertexFace[e.a] = e.created;
+    }
+    // the boundary is a simple cycle, so each new face starts at a distinct vertex
+    for(const BoundaryEdge& e : this->boundary)
+        this->linkFaces(e.created, 0, this->vertexFace[e.b], 1);
+
+    this->vertexFace[vertex] = this->boundary.front().created;
+    this->lastFace = this->vertexFace[vertex];
+    return vertex;
+}
+
+bool Mesh::remove(int vertex)
+{
+    if(this->isSuperVertex(vertex) || !this->isVertexAlive(vertex))
+        return false;
+
+    // walk the star counter-clockwise, collecting the link polygon and its outer neighbours
+    class Link
+    {
+    public:
+        int face, edge;
+    };
+    std::vector<int> polygon;
+    std::vector<Link> outer;
+
+    int first = this->vertexFace[vertex];
+    int face = first;
+    do
+    {
+        int i = this->indexOf(face, vertex);
+        const Face& f = this->faces[face];
+        int a = f.v[(i + 1) % 3];
+        int outside = f.adj[i];
+        polygon.push_back(a);
+        outer.push_back(Link{outside, outside == NONE ? NONE : (this->indexOf(outside, a) + 1) % 3});
+        int next = f.adj[(i + 1) % 3];
+        this->freeFace(face);
+        face = next;
+    }
+    while(face != first);
+
+    // fill the hole by clipping Delaunay ears: convex and with no polygon vertex in their circumcircle
+    int created;
+    while(polygon.size() > 3)
+    {
+        int size = static_cast<int>(polygon.size());
+        int ear = NONE;
+        for(int i = 0; i < size && ear == NONE; i++)
+        {
+            int a = polygon[i], b = polygon[(i + 1) % size], c = polygon[(i + 2) % size];
+            if(this->orient(a, b, c) <= 0.0)
+                continue;
+
+            bool isEmpty = true;
+            for(int j = 3; j < size && isEmpty; j++)
+                isEmpty = this->inCircle(a, b, c, polygon[(i + j) % size]) <= 0.0;
+            if(isEmpty)
+                ear = i;
+        }
+        if(ear == NONE)
+            ear = 0; // unreachable with exact predicates
+
+        int i1 = (ear + 1) % size, i2 = (ear + 2) % size;
+        created = this->newFace(polygon[ear], polygon[i1], polygon[i2]);
+        this->linkFaces(created, 2, outer[ear].face, outer[ear].edge);
+        this->linkFaces(created, 0, outer[i1].face, outer[i1].edge);
+        for(int i = 0; i < 3; i++)
+            this->vertexFace[this->faces[created].v[i]] = created;
+
+        outer[ear] = Link{created, 1};
+        polygon.erase(polygon.begin() + i1);
+        outer.erase(outer.begin() + i1);
+    }
+
+    created = this->newFace(polygon[0], polygon[1], polygon[2]);
+    this->linkFaces(created, 2, outer[0].face, outer[0].edge);
+    this->linkFaces(created, 0, outer[1].face, outer[1].edge);
+    this->linkFaces(created, 1, outer[2].face, outer[2].edge);
+    for(int i = 0; i < 3; i++)
+        this->vertexFace[polygon[i]] = created;
+
+    this->releaseVertex(vertex);
+    this->lastFace = created;
+    return true;
+}
+
+void Mesh::getTriangles(std::vector<Triangle>* out) const
+{
+    STATS_PHASE(EXTRACT);
+    TRACE_SCOPE("extract");
+    for(int f = 0; f < static_cast<int>(this->faces.size()); f++)
+    {
+        if(!this->isAlive(f) || this->isSuperFace(f))
+            continue;
+        const Face& face = this->faces[f];
+        out->emplace_back(this->vertices[face.v[0]], this->vertices[face.v[1]], this->vertices[face.v[2]]);
+    }
+}
+
+void Mesh::getTriangles(std::vector<std::array<int, 3>>* out) const
+{
+    STATS_PHASE(EXTRACT);
+    TRACE_SCOPE("extract");
+    for(int f = 0; f < static_cast<int>(this->faces.size()); f++)
+    {
+        if(!this->isAlive(f) || this->isSuperFace(f))
+            continue;
+        out->push_back(this->faces[f].v);
+    }
+}
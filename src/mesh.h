@@ -0,0 +1,238 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "node.h"
+#include "triangle.h"
+#include "predicates.h"
+
+class SymbolicPoint;
+
+/** Handles an update of a Mesh touched, for readers mirroring it (see Mesh::addJournal).
+* Every reader has a journal of its own; it takes the current state of every handle listed
+* and then empties the lists. */
+class MeshJournal
+{
+public:
+    std::vector<int> faces;    // created, rewritten or freed since the last reader, may repeat
+    std::vector<int> vertices; // created, released, or recycled for a new node
+    bool cleared = false;      // clear() or reset() ran, no handle from before survives
+
+    inline void reset(void) noexcept
+    {
+        this->faces.clear();
+        this->vertices.clear();
+        this->cleared = false;
+    }
+};
+
+/** A dynamic Delaunay triangulation stored as index triples with adjacency.
+* The first three vertices form a super-triangle infinitely far away, so every
+* inserted node always lies inside some face and the faces not touching it are
+* exactly the Delaunay triangulation of the nodes. Faces are kept in slots that
+* are recycled on deletion; vertex and face handles stay valid until removed. */
+class Mesh
+{
+public:
+    static const int NONE = -1;
+    static const std::size_t CANCEL_INTERVAL = 1024;
+
+    /// how insert() restores the Delaunay property around a new vertex
+    enum Engine
+    {
+        CAVITY_ENGINE, // Bowyer-Watson: delete the conflicting faces and fan the hole
+        FLIP_ENGINE    // Lawson: split the containing face (or edge) and flip illegal edges
+    };
+
+    class Face
+    {
+    public:
+        std::array<int, 3> v;   // vertex handles in counter-clockwise order
+        std::array<int, 3> adj; // adj[i] is the face across the edge opposite v[i]
+    };
+
+    /// an edge a -> b of a cavity, with the faces on each side and the face replacing it
+    class BoundaryEdge
+    {
+    public:
+        int a, b, inside, outside, created;
+    };
+
+public:
+    Mesh() : Mesh(Node(-1.0f, -1.0f), Node(1.0f, 1.0f)) {}
+    /// builds an empty triangulation able to hold nodes inside the given bounds
+    Mesh(const Node& minCorner, const Node& maxCorner);
+
+    /// inserts a node, walking from hint (or the last touched face)
+    /// @return the new vertex handle, the existing one for duplicates or NONE if outside
+    int insert(const Node& n, int hint = NONE);
+    /// inserts a batch along a Hilbert curve so each walk starts next to its target; once
+    /// *cancel is set it stops within CANCEL_INTERVAL nodes, leaving a valid partial mesh
+    /// @return the vertex handle of every node in input order, duplicates share one handle,
+    /// nodes a cancelled batch did not reach keep NONE
+    std::vector<int> insertBatch(std::span<const Node> nodes, const std::atomic<bool>* cancel = nullptr);
+    /// the same into handles, sorting in order and keys; buffers a caller keeps from batch to
+    /// batch make a batch into a mesh of the same capacity allocate nothing
+    void insertBatch(std::span<const Node> nodes, std::vector<int>* handles, std::vector<int>* order,
+                     std::vector<std::uint32_t>* keys, const std::atomic<bool>* cancel = nullptr);
+    /// replaces the triangulation by a stored one, such as a MeshFile holds, without triangulating
+    /// again: triangles are counter-clockwise index triples into nodes that use every node, meet edge
+    /// to edge and are locally Delaunay over the convex hull; adjacency follows Face::adj and is
+    /// found by matching edges when empty. Node i becomes vertex i + 3.
+    /// @return false, leaving the mesh as it was, if the triangles are not such a triangulation
+    bool assign(std::span<const Node> nodes, std::span<const std::array<int, 3>> triangles,
+                std::span<const std::array<int, 3>> adjacency = {});
+    /// removes a vertex and re-triangulates its star, super vertices cannot be removed;
+    /// the slot of the vertex goes to the next new vertex
+    bool remove(int vertex);
+    /// @return the face containing n
+    int locate(const Node& n, int hint = NONE) const;
+    /// walks the Delaunay graph downhill from the face containing n, which ends at the nearest vertex
+    /// @return the finite vertex nearest to n, or NONE while the triangulation is empty
+    int nearest(const Node& n, int hint = NONE) const;
+    /// collects every face whose circumcircle contains n, growing from a face known to conflict with it
+    void findCavity(const Node& n, int face);
+    /// adds n as a vertex and replaces the last cavity found with a fan of faces around it
+    /// @return the new vertex handle; getBoundary() then holds the created faces
+    int fillCavity(const Node& n);
+    /// inserts n into face by splitting it in place and flipping until Delaunay again
+    /// @return the new vertex handle
+    int insertByFlips(const Node& n, int face);
+    /// unlinks a face without filling the hole, so its neighbours see a boundary there; only
+    /// for faces no later insertion can conflict with, the streaming triangulator's finalized ones
+    void detach(int face);
+    /// hands the slot of a vertex no face uses any more to the next new vertex
+    void releaseVertex(int vertex);
+    /// empties the triangulation, keeping the super-triangle and allocated memory
+    void clear(void);
+    /// empties the triangulation and fits a new super-triangle around the given bounds
+    void reset(const Node& minCorner, const Node& maxCorner);
+
+    /// appends every face that does not touch the super-triangle
+    void getTriangles(std::vector<Triangle>* out) const;
+    void getTriangles(std::vector<std::array<int, 3>>* out) const;
+
+    /// orientation of vertices a, b and node n, see orient2d
+    double orient(int a, int b, const Node& n) const;
+    /// in-circle test of node n against face, see inCircle
+    inline double inCircle(int face, const Node& n) const
+    {
+        const Face& f = this->faces[face];
+        return this->inCircle(f.v[0], f.v[1], f.v[2], n);
+    }
+
+    inline bool isAlive(int face) const noexcept
+    {
+        return face >= 0 && face < static_cast<int>(this->faces.size()) && this->faces[face].v[0] != NONE;
+    }
+
+    inline bool isSuperVertex(int vertex) const noexcept
+    {
+        return vertex < 3;
+    }
+
+    inline bool isSuperFace(int face) const noexcept
+    {
+        const Face& f = this->faces[face];
+        return this->isSuperVertex(f.v[0]) || this->isSuperVertex(f.v[1]) || this->isSuperVertex(f.v[2]);
+    }
+
+    inline bool isVertexAlive(int vertex) const noexcept
+    {
+        return vertex >= 0 && vertex < static_cast<int>(this->vertices.size()) && this->vertexFace[vertex] != NONE;
+    }
+
+    /// @return the index of vertex in face, or NONE
+    inline int indexOf(int face, int vertex) const noexcept
+    {
+        const Face& f = this->faces[face];
+        return f.v[0] == vertex ? 0 : f.v[1] == vertex ? 1 : f.v[2] == vertex ? 2 : NONE;
+    }
+
+    /// @return the number of faces currently in use, including super faces
+    inline int faceCount(void) const noexcept
+    {
+        return static_cast<int>(this->faces.size() - this->freeFaces.size());
+    }
+
+    inline const std::vector<int>& getCavity(void) const noexcept
+    {
+        return this->cavity;
+    }
+
+    inline const std::vector<BoundaryEdge>& getBoundary(void) const noexcept
+    {
+        return this->boundary;
+    }
+
+    inline void setEngine(Engine value) noexcept
+    {
+        this->engine = value;
+    }
+
+    inline Engine getEngine(void) const noexcept
+    {
+        return this->engine;
+    }
+
+    /// records every face and vertex later updates touch into journal as well
+    inline void addJournal(MeshJournal* journal)
+    {
+        this->journals.push_back(journal);
+    }
+
+    /// stops recording into journal
+    inline void removeJournal(MeshJournal* journal)
+    {
+        std::erase(this->journals, journal);
+    }
+
+    /// @return the last face touched by an update, a good starting point for walks
+    inline int getLastFace(void) const noexcept
+    {
+        return this->lastFace;
+    }
+
+public:
+    std::vector<Node> vertices;
+    std::vector<Face> faces;
+    std::vector<int> vertexFace; // one face incident to each vertex, NONE once removed
+
+private:
+    friend class Snapshot;
+
+    SymbolicPoint point(int vertex) const;
+    double orient(int a, int b, int c) const;
+    double inCircle(int a, int b, int c, const Node& n) const;
+    double inCircle(int a, int b, int c, int d) const;
+
+    int newVertex(const Node& n);
+    int newFace(int a, int b, int c);
+    void freeFace(int face);
+    void linkFaces(int face, int edge, int other, int otherEdge);
+    int anyFace(void) const;
+    void replaceNeighbour(int face, int oldNeighbour, int newNeighbour);
+    void setFace(int face, int a, int b, int c, int adjA, int adjB, int adjC);
+    void flip(int face);
+    void legalize(void);
+
+    std::vector<int> freeFaces;
+    std::vector<int> freeVertices;
+    int lastFace = NONE;
+    Engine engine = CAVITY_ENGINE;
+    std::vector<MeshJournal*> journals;
+
+    // scratch kept between calls to avoid reallocating on every insertion
+    std::vector<int> cavity;
+    std::vector<int> stack;
+    std::vector<BoundaryEdge> boundary;
+    std::vector<unsigned int> faceMark;
+    unsigned int markStamp = 0;
+};
+
+#endif // MESH_H
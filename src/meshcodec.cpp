@@ -0,0 +1,1129 @@
+#include "meshcodec.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "trace.h"
+
+/// the kind of every triangle in the order of the walk, the letters of Edgebreaker
+enum Symbol : std::uint8_t
+{
+    CREATE, // C, the tip is a vertex reached for the first time
+    LEFT,   // L, the edge on the left is shared with the region walked so far
+    RIGHT,  // R, the edge on the right is
+    SPLIT,  // S, neither is but the tip was reached before, the walk forks
+    END,    // E, both are, the branch ends
+    START   // the triangle a component starts from, not coded
+};
+
+/// markers in the opposite table while decoding
+static const int FREE = -1;  // an edge of the decoded region waiting for the triangle across it
+static const int GLUE = -2;  // an edge a symbol said is shared with a triangle decoded before
+static const int UNSET = -3; // a gate whose triangle comes later
+
+/// corners are numbered in threes, so an int holds every corner of the largest mesh
+static const std::size_t MAX_TRIANGLES = std::numeric_limits<int>::max() / 3;
+
+static inline int nextCorner(int c) noexcept
+{
+    return c % 3 == 2 ? c - 2 : c + 1;
+}
+
+static inline int prevCorner(int c) noexcept
+{
+    return c % 3 == 0 ? c + 2 : c - 1;
+}
+
+static inline std::uint32_t zigzag(std::int32_t value) noexcept
+{
+    return (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31);
+}
+
+static inline std::int32_t unzigzag(std::uint32_t value) noexcept
+{
+    return static_cast<std::int32_t>(value >> 1) ^ -static_cast<std::int32_t>(value & 1);
+}
+
+/// parallelogram prediction of the vertex across the edge (a, b) of the triangle (a, b, o);
+/// dummy vertices have no position and are passed as null
+static inline std::array<std::int32_t, 2> predict(const std::array<std::int32_t, 2>* a, const std::array<std::int32_t, 2>* b,
+                                                  const std::array<std::int32_t, 2>* o, std::int32_t top) noexcept
+{
+    if(a == nullptr || b == nullptr)
+    {
+        // the edge ends at the dummy of a boundary, its other end is the nearest guess
+        if(a == nullptr && b == nullptr)
+            return {0, 0};
+        return a != nullptr ? *a : *b;
+    }
+    std::array<std::int32_t, 2> guess;
+    for(int i = 0; i < 2; i++)
+    {
+        std::int64_t value = o != nullptr ? std::int64_t((*a)[i]) + (*b)[i] - (*o)[i] : (std::int64_t((*a)[i]) + (*b)[i]) / 2;
+        guess[i] = static_cast<std::int32_t>(std::clamp<std::int64_t>(value, 0, top));
+    }
+    return guess;
+}
+
+// ---------------------------------------------------------------------------------------
+// entropy coding
+
+/// probabilities of a 0 are kept in 1/2048ths and move 1/32 of the way to every bit coded
+static const std::uint32_t PROBABILITY_BITS = 11;
+static const std::uint16_t PROBABILITY_HALF = 1 << (PROBABILITY_BITS - 1);
+static const int ADAPTATION_SHIFT = 5;
+static const std::uint32_t RANGE_TOP = 1u << 24;
+
+/// binary range coder in the manner of LZMA, carries are held back in a run of 0xFF bytes
+class RangeEncoder
+{
+public:
+    explicit RangeEncoder(std::vector<unsigned char>* out) : out(out)
+    {
+    }
+
+    inline void bit(std::uint16_t& probability, unsigned int bit)
+    {
+        std::uint32_t bound = (this->range >> PROBABILITY_BITS) * probability;
+        if(bit == 0)
+        {
+            this->range = bound;
+            probability += ((1u << PROBABILITY_BITS) - probability) >> ADAPTATION_SHIFT;
+        }
+        else
+        {
+            this->low += bound;
+            this->range -= bound;
+            probability -= probability >> ADAPTATION_SHIFT;
+        }
+        if(this->range < RANGE_TOP)
+        {
+            this->range <<= 8;
+            this->shiftLow();
+        }
+    }
+
+    /// count bits of value at even odds, the highest first
+    inline void direct(std::uint32_t value, int count)
+    {
+        while(count-- > 0)
+        {
+            this->range >>= 1;
+            if((value >> count) & 1)
+                this->low += this->range;
+            if(this->range < RANGE_TOP)
+            {
+                this->range <<= 8;
+                this->shiftLow();
+            }
+        }
+    }
+
+    void finish(void)
+    {
+        for(int i = 0; i < 5; i++)
+            this->shiftLow();
+    }
+
+private:
+    void shiftLow(void)
+    {
+        if(static_cast<std::uint32_t>(this->low) < 0xFF000000u || (this->low >> 32) != 0)
+        {
+            unsigned char carry = static_cast<unsigned char>(this->low >> 32);
+            unsigned char pending = this->cache;
+            do
+            {
+                this->out->push_back(static_cast<unsigned char>(pending + carry));
+                pending = 0xFF;
+            }
+            while(--this->cacheSize != 0);
+            this->cache = static_cast<unsigned char>(this->low >> 24);
+        }
+        this->cacheSize++;
+        this->low = (this->low & 0x00FFFFFF) << 8;
+    }
+
+    std::vector<unsigned char>* out;
+    std::uint64_t low = 0;
+    std::uint32_t range = 0xFFFFFFFF;
+    unsigned char cache = 0;
+    std::uint64_t cacheSize = 1;
+};
+
+class RangeDecoder
+{
+public:
+    /// reading past the end yields zeros and marks the stream as cut short, the encoder
+    /// flushes exactly the bytes a decoder reads
+    explicit RangeDecoder(std::span<const unsigned char> in) : in(in)
+    {
+        for(int i = 0; i < 5; i++)
+            this->code = (this->code << 8) | this->byte();
+    }
+
+    inline unsigned int bit(std::uint16_t& probability)
+    {
+        std::uint32_t bound = (this->range >> PROBABILITY_BITS) * probability;
+        unsigned int bit;
+        if(this->code < bound)
+        {
+            this->range = bound;
+            probability += ((1u << PROBABILITY_BITS) - probability) >> ADAPTATION_SHIFT;
+            bit = 0;
+        }
+        else
+        {
+            this->code -= bound;
+            this->range -= bound;
+            probability -= probability >> ADAPTATION_SHIFT;
+            bit = 1;
+        }
+        if(this->range < RANGE_TOP)
+        {
+            this->range <<= 8;
+            this->code = (this->code << 8) | this->byte();
+        }
+        return bit;
+    }
+
+    inline std::uint32_t direct(int count)
+    {
+        std::uint32_t value = 0;
+        while(count-- > 0)
+        {
+            this->range >>= 1;
+            // all ones when the code is below the half, so nothing is taken off and the bit is 0
+            std::uint32_t below = 0 - ((this->code - this->range) >> 31);
+            this->code -= this->range & ~below;
+            value = (value << 1) | (1 + below);
+            if(this->range < RANGE_TOP)
+            {
+                this->range <<= 8;
+                this->code = (this->code << 8) | this->byte();
+            }
+        }
+        return value;
+    }
+
+    inline bool isOverrun(void) const noexcept
+    {
+        return this->overrun;
+    }
+
+private:
+    inline std::uint32_t byte(void) noexcept
+    {
+        if(this->position < this->in.size())
+            return this->in[this->position++];
+        this->overrun = true;
+        return 0;
+    }
+
+    std::span<const unsigned char> in;
+    std::size_t position = 0;
+    bool overrun = false;
+    std::uint32_t code = 0;
+    std::uint32_t range = 0xFFFFFFFF;
+};
+
+/// the adaptive probabilities of both streams
+class Models
+{
+public:
+    Models(void)
+    {
+        for(auto& tree : this->symbols)
+            std::fill(std::begin(tree), std::end(tree), PROBABILITY_HALF);
+        for(int axis = 0; axis < 2; axis++)
+        {
+            std::fill(std::begin(this->lengths[axis]), std::end(this->lengths[axis]), PROBABILITY_HALF);
+            std::fill(std::begin(this->leading[axis]), std::end(this->leading[axis]), PROBABILITY_HALF);
+        }
+    }
+
+    std::uint16_t symbols[START + 1][8];  // a bit tree over the symbol, the previous symbol as context
+    std::uint16_t flag = PROBABILITY_HALF;
+    std::uint16_t lengths[2][32];         // a bit tree over the bit length of a residual, per axis
+    std::uint16_t leading[2][32];         // the bit below the leading one, per axis and length
+    int previous = START;
+};
+
+/** Residuals are coded as their bit length through a model, the bit below the leading one
+* through a model per length, and the rest at even odds, where they about are. */
+class EntropyWriter
+{
+public:
+    explicit EntropyWriter(std::vector<unsigned char>* out) : coder(out)
+    {
+    }
+
+    inline void symbol(int symbol)
+    {
+        this->tree(this->models.symbols[this->models.previous], 3, static_cast<unsigned int>(symbol));
+        this->models.previous = symbol;
+    }
+
+    inline void flag(bool value)
+    {
+        this->coder.bit(this->models.flag, value);
+    }
+
+    inline void value(std::uint32_t value, int axis)
+    {
+        int length = std::bit_width(value);
+        this->tree(this->models.lengths[axis], 5, static_cast<unsigned int>(length));
+        if(length > 1)
+            this->coder.bit(this->models.leading[axis][length], (value >> (length - 2)) & 1);
+        if(length > 2)
+            this->coder.direct(value, length - 2);
+    }
+
+    inline void raw(std::uint32_t value, int count)
+    {
+        this->coder.direct(value, count);
+    }
+
+    void finish(void)
+    {
+        this->coder.finish();
+    }
+
+private:
+    template <std::size_t N>
+    inline void tree(std::uint16_t (&probabilities)[N], int depth, unsigned int value)
+    {
+        unsigned int node = 1;
+        for(int i = depth - 1; i >= 0; i--)
+        {
+            unsigned int bit = (value >> i) & 1;
+            this->coder.bit(probabilities[node], bit);
+            node = (node << 1) | bit;
+        }
+    }
+
+    RangeEncoder coder;
+    Models models;
+};
+
+class EntropyReader
+{
+public:
+    explicit EntropyReader(std::span<const unsigned char> in) : coder(in)
+    {
+    }
+
+    inline int symbol(void)
+    {
+        int symbol = static_cast<int>(this->tree(this->models.symbols[this->models.previous], 3));
+        // a corrupt stream may spell a symbol past END, the caller rejects it
+        this->models.previous = std::min(symbol, static_cast<int>(START));
+        return symbol;
+    }
+
+    inline bool flag(void)
+    {
+        return this->coder.bit(this->models.flag) != 0;
+    }
+
+    inline std::uint32_t value(int axis)
+    {
+        int length = static_cast<int>(this->tree(this->models.lengths[axis], 5));
+        if(length <= 1)
+            return static_cast<std::uint32_t>(length);
+        std::uint32_t value = 2 | this->coder.bit(this->models.leading[axis][length]);
+        if(length > 2)
+            value = (value << (length - 2)) | this->coder.direct(length - 2);
+        return value;
+    }
+
+    inline std::uint32_t raw(int count)
+    {
+        return this->coder.direct(count);
+    }
+
+    inline bool isOverrun(void) const noexcept
+    {
+        return this->coder.isOverrun();
+    }
+
+private:
+    template <std::size_t N>
+    inline unsigned int tree(std::uint16_t (&probabilities)[N], int depth)
+    {
+        unsigned int node = 1;
+        for(int i = 0; i < depth; i++)
+            node = (node << 1) | this->coder.bit(probabilities[node]);
+        return node - (1u << depth);
+    }
+
+    RangeDecoder coder;
+    Models models;
+};
+
+/** Without entropy coding: C as a 0 bit and the other symbols as 1 and two bits, residuals as
+* five bits of length and the bits below the leading one, packed from the lowest bit up. */
+class PlainWriter
+{
+public:
+    explicit PlainWriter(std::vector<unsigned char>* out) : out(out)
+    {
+    }
+
+    inline void symbol(int symbol)
+    {
+        if(symbol == CREATE)
+            this->put(0, 1);
+        else
+            this->put(1 | static_cast<std::uint32_t>(symbol - 1) << 1, 3);
+    }
+
+    inline void flag(bool value)
+    {
+        this->put(value, 1);
+    }
+
+    inline void value(std::uint32_t value, int axis)
+    {
+        (void)axis;
+        int length = std::bit_width(value);
+        this->put(static_cast<std::uint32_t>(length), 5);
+        if(length > 1)
+            this->put(value & ((1u << (length - 1)) - 1), length - 1);
+    }
+
+    inline void raw(std::uint32_t value, int count)
+    {
+        this->put(value, count);
+    }
+
+    void finish(void)
+    {
+        if(this->used > 0)
+            this->out->push_back(static_cast<unsigned char>(this->bits));
+    }
+
+private:
+    inline void put(std::uint32_t value, int count)
+    {
+        this->bits |= static_cast<std::uint64_t>(value) << this->used;
+        this->used += count;
+        while(this->used >= 8)
+        {
+            this->out->push_back(static_cast<unsigned char>(this->bits));
+            this->bits >>= 8;
+            this->used -= 8;
+        }
+    }
+
+    std::vector<unsigned char>* out;
+    std::uint64_t bits = 0;
+    int used = 0;
+};
+
+class PlainReader
+{
+public:
+    explicit PlainReader(std::span<const unsigned char> in) : in(in)
+    {
+    }
+
+    inline int symbol(void)
+    {
+        if(this->get(1) == 0)
+            return CREATE;
+        return 1 + static_cast<int>(this->get(2));
+    }
+
+    inline bool flag(void)
+    {
+        return this->get(1) != 0;
+    }
+
+    inline std::uint32_t value(int axis)
+    {
+        (void)axis;
+        int length = static_cast<int>(this->get(5));
+        if(length <= 1)
+            return static_cast<std::uint32_t>(length);
+        return (1u << (length - 1)) | this->get(length - 1);
+    }
+
+    inline std::uint32_t raw(int count)
+    {
+        return this->get(count);
+    }
+
+    /// @return true if a value ran past the end, the writer pads only its last byte
+    inline bool isOverrun(void) const noexcept
+    {
+        return this->overrun;
+    }
+
+private:
+    inline std::uint32_t get(int count)
+    {
+        while(this->used < count)
+        {
+            std::uint64_t byte = 0;
+            if(this->position < this->in.size())
+                byte = this->in[this->position++];
+            else
+                this->overrun = true;
+            this->bits |= byte << this->used;
+            this->used += 8;
+        }
+        std::uint32_t value = static_cast<std::uint32_t>(this->bits & ((std::uint64_t(1) << count) - 1));
+        this->bits >>= count;
+        this->used -= count;
+        return value;
+    }
+
+    std::span<const unsigned char> in;
+    std::size_t position = 0;
+    std::uint64_t bits = 0;
+    int used = 0;
+    bool overrun = false;
+};
+
+// ---------------------------------------------------------------------------------------
+// encoding
+
+MeshCodec::MeshCodec(int bits, bool entropy) : bits(std::clamp(bits, 1, MAX_BITS)), entropy(entropy)
+{
+}
+
+bool MeshCodec::fail(const std::string& message)
+{
+    this->error = message;
+    return false;
+}
+
+bool MeshCodec::buildCorners(std::size_t vertexCount, std::span<const MeshFile::Triple> triangles)
+{
+    if(triangles.size() > MAX_TRIANGLES / 2)
+        return this->fail("too many triangles to encode");
+    std::size_t cornerCount = 3 * triangles.size();
+    this->corners.resize(cornerCount);
+    for(std::size_t t = 0; t < triangles.size(); t++)
+    {
+        const MeshFile::Triple& triangle = triangles[t];
+        for(int i = 0; i < 3; i++)
+        {
+            if(triangle[i] < 0 || static_cast<std::size_t>(triangle[i]) >= vertexCount)
+                return this->fail("triangle " + std::to_string(t) + " has a vertex index out of range");
+            this->corners[3 * t + i] = triangle[i];
+        }
+        if(triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+            return this->fail("triangle " + std::to_string(t) + " repeats a vertex");
+    }
+
+    // the edges leaving every vertex, sorted by the vertex they end at; the edge facing
+    // corner c runs from the vertex of next(c) to that of prev(c)
+    std::vector<int> first(vertexCount + 1, 0);
+    for(std::size_t c = 0; c < cornerCount; c++)
+        first[this->corners[nextCorner(static_cast<int>(c))] + 1]++;
+    for(std::size_t v = 0; v < vertexCount; v++)
+        first[v + 1] += first[v];
+    std::vector<std::pair<int, int>> edges(cornerCount);
+    std::vector<int> fill(first.begin(), first.end() - 1);
+    for(std::size_t c = 0; c < cornerCount; c++)
+    {
+        int corner = static_cast<int>(c);
+        edges[fill[this->corners[nextCorner(corner)]]++] = {this->corners[prevCorner(corner)], corner};
+    }
+    for(std::size_t v = 0; v < vertexCount; v++)
+    {
+        auto begin = edges.begin() + first[v], end = edges.begin() + first[v + 1];
+        std::sort(begin, end);
+        for(auto e = begin; e + 1 < end; e++)
+        {
+            if(e->first == (e + 1)->first)
+                return this->fail("edge " + std::to_string(v) + "-" + std::to_string(e->first)
+                                  + " is used twice in one direction, the triangles are not an oriented manifold");
+        }
+    }
+
+    // the twin of the edge from a to b leaves b towards a
+    this->opposite.assign(cornerCount, FREE);
+    for(std::size_t c = 0; c < cornerCount; c++)
+    {
+        int a = this->corners[nextCorner(static_cast<int>(c))], b = this->corners[prevCorner(static_cast<int>(c))];
+        auto begin = edges.begin() + first[b], end = edges.begin() + first[b + 1];
+        auto twin = std::lower_bound(begin, end, std::make_pair(a, std::numeric_limits<int>::min()));
+        if(twin != end && twin->first == a)
+            this->opposite[c] = twin->second;
+    }
+    return true;
+}
+
+bool MeshCodec::closeBoundaries(std::size_t vertexCount)
+{
+    // the boundary edge leaving every vertex, a vertex with two is pinched between loops
+    std::size_t cornerCount = this->corners.size();
+    std::vector<int> leaving(vertexCount, FREE);
+    for(std::size_t c = 0; c < cornerCount; c++)
+    {
+        if(this->opposite[c] != FREE)
+            continue;
+        int from = this->corners[nextCorner(static_cast<int>(c))];
+        if(leaving[from] != FREE)
+            return this->fail("vertex " + std::to_string(from) + " is pinched between boundaries");
+        leaving[from] = static_cast<int>(c);
+    }
+
+    // every loop gets a dummy vertex and a triangle joining it to each edge, (b, a, dummy)
+    // for the edge from a to b, so every component becomes a closed surface
+    this->loops = 0;
+    for(std::size_t c = 0; c < cornerCount; c++)
+    {
+        if(this->opposite[c] != FREE)
+            continue;
+        int dummy = static_cast<int>(vertexCount + this->loops++);
+        int begin = static_cast<int>(this->corners.size() / 3);
+        int edge = static_cast<int>(c);
+        do
+        {
+            if(this->corners.size() / 3 >= MAX_TRIANGLES)
+                return this->fail("too many triangles to encode");
+            int a = this->corners[nextCorner(edge)], b = this->corners[prevCorner(edge)];
+            int t = static_cast<int>(this->corners.size() / 3);
+            this->corners.insert(this->corners.end(), {b, a, dummy});
+            this->opposite.insert(this->opposite.end(), {UNSET, UNSET, edge});
+            this->opposite[edge] = 3 * t + 2;
+            edge = leaving[b];
+            if(edge < 0 || (this->opposite[edge] != FREE && edge != static_cast<int>(c)))
+                return this->fail("vertex " + std::to_string(b) + " is pinched between boundaries");
+        }
+        while(edge != static_cast<int>(c));
+
+        // neighbouring triangles of the loop share the edge to the dummy
+        int end = static_cast<int>(this->corners.size() / 3);
+        for(int t = begin; t < end; t++)
+        {
+            int before = t > begin ? t - 1 : end - 1, after = t + 1 < end ? t + 1 : begin;
+            this->opposite[3 * t] = 3 * before + 1;
+            this->opposite[3 * t + 1] = 3 * after;
+        }
+    }
+
+    // around every vertex the triangles have to form a single fan
+    std::size_t surfaceVertices = vertexCount + this->loops;
+    std::vector<int> count(surfaceVertices, 0), some(surfaceVertices, -1);
+    for(std::size_t c = 0; c < this->corners.size(); c++)
+    {
+        count[this->corners[c]]++;
+        some[this->corners[c]] = static_cast<int>(c);
+    }
+    for(std::size_t v = 0; v < surfaceVertices; v++)
+    {
+        if(some[v] < 0)
+            continue;
+        int fan = 0, c = some[v];
+        do
+        {
+            c = nextCorner(this->opposite[nextCorner(c)]);
+            fan++;
+        }
+        while(c != some[v]);
+        if(fan != count[v])
+            return this->fail("vertex " + std::to_string(v) + " joins separate fans of triangles");
+    }
+    return true;
+}
+
+bool MeshCodec::traverse(std::size_t vertexCount)
+{
+    std::size_t triangleCount = this->corners.size() / 3;
+    std::vector<std::uint8_t> visited(triangleCount, 0);
+    std::vector<std::uint8_t> marked(vertexCount + this->loops, 0);
+    this->symbols.clear();
+    this->predictions.clear();
+    this->components = 0;
+
+    std::vector<int> gates;
+    for(std::size_t start = 0; start < triangleCount; start++)
+    {
+        if(visited[start])
+            continue;
+        // the first triangle of a component goes whole, the walk enters its neighbour across corner 3 start
+        this->components++;
+        visited[start] = 1;
+        for(int c = 3 * static_cast<int>(start); c < 3 * static_cast<int>(start) + 3; c++)
+        {
+            marked[this->corners[c]] = 1;
+            this->predictions.push_back({this->corners[c], -1, -1, -1});
+        }
+        gates.push_back(this->opposite[3 * start]);
+        while(!gates.empty())
+        {
+            // c is the tip of the triangle being walked, facing the edge the walk came in by
+            int c = gates.back();
+            gates.pop_back();
+            for(;;)
+            {
+                if(visited[c / 3])
+                    return this->fail("the triangles form a surface with handles");
+                visited[c / 3] = 1;
+                int right = this->opposite[nextCorner(c)], left = this->opposite[prevCorner(c)];
+                if(!marked[this->corners[c]])
+                {
+                    marked[this->corners[c]] = 1;
+                    this->symbols.push_back(CREATE);
+                    this->predictions.push_back({this->corners[c], this->corners[nextCorner(c)], this->corners[prevCorner(c)],
+                                                 this->corners[this->opposite[c]]});
+                    c = right;
+                    continue;
+                }
+                bool rightDone = visited[right / 3], leftDone = visited[left / 3];
+                if(rightDone && leftDone)
+                {
+                    this->symbols.push_back(END);
+                    break;
+                }
+                if(rightDone)
+                {
+                    this->symbols.push_back(RIGHT);
+                    c = left;
+                }
+                else if(leftDone)
+                {
+                    this->symbols.push_back(LEFT);
+                    c = right;
+                }
+                else
+                {
+                    // the right branch first, the left one when it ends
+                    this->symbols.push_back(SPLIT);
+                    gates.push_back(left);
+                    c = right;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Writer>
+void MeshCodec::writeStreams(std::vector<unsigned char>* out, MeshCodecHeader* header, std::size_t vertexCount)
+{
+    {
+        Writer connectivity(out);
+        for(std::uint8_t symbol : this->symbols)
+            connectivity.symbol(symbol);
+        connectivity.finish();
+    }
+    header->connectivityBytes = out->size() - sizeof(MeshCodecHeader);
+
+    Writer geometry(out);
+    std::int32_t top = static_cast<std::int32_t>((1u << this->bits) - 1);
+    auto cell = [&](int v) -> const Cell*
+    {
+        return static_cast<std::size_t>(v) < vertexCount ? &this->cells[v] : nullptr;
+    };
+    for(const Prediction& prediction : this->predictions)
+    {
+        const Cell* position = cell(prediction.vertex);
+        geometry.flag(position == nullptr);
+        if(position == nullptr)
+            continue;
+        if(prediction.a < 0)
+        {
+            geometry.raw(static_cast<std::uint32_t>((*position)[0]), this->bits);
+            geometry.raw(static_cast<std::uint32_t>((*position)[1]), this->bits);
+            continue;
+        }
+        Cell guess = predict(cell(prediction.a), cell(prediction.b), cell(prediction.opposite), top);
+        geometry.value(zigzag((*position)[0] - guess[0]), 0);
+        geometry.value(zigzag((*position)[1] - guess[1]), 1);
+    }
+    geometry.finish();
+}
+
+bool MeshCodec::encode(const Mesh& mesh, std::vector<unsigned char>* out)
+{
+    std::vector<Node> vertices;
+    std::vector<MeshFile::Triple> triangles;
+    MeshFile::compact(mesh, &vertices, &triangles);
+    return this->encode(vertices, triangles, out);
+}
+
+bool MeshCodec::encode(std::span<const Node> vertices, std::span<const MeshFile::Triple> triangles, std::vector<unsigned char>* out)
+{
+    TRACE_SCOPE("encodeMesh");
+    this->error.clear();
+    out->clear();
+    this->order.assign(vertices.size(), -1);
+    if constexpr(std::endian::native != std::endian::little)
+        return this->fail("meshes are only encoded on little-endian hosts");
+    if(vertices.size() > MAX_TRIANGLES)
+        return this->fail("too many vertices to encode");
+    {
+        TRACE_SCOPE("connectivity");
+        if(!this->buildCorners(vertices.size(), triangles) || !this->closeBoundaries(vertices.size()) || !this->traverse(vertices.size()))
+            return false;
+    }
+
+    MeshCodecHeader header{};
+    std::memcpy(header.magic, MeshCodecHeader::MAGIC, sizeof(header.magic));
+    header.version = MeshCodecHeader::VERSION;
+    header.flags = this->entropy ? MeshCodecHeader::ENTROPY_CODED : 0;
+    header.bits = static_cast<std::uint32_t>(this->bits);
+    header.components = static_cast<std::uint32_t>(this->components);
+    header.vertexCount = this->predictions.size();
+    header.triangleCount = this->corners.size() / 3;
+
+    // the grid spans the vertices in use, numbered in the order the decoder meets them
+    float minimum[2] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float maximum[2] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+    int used = 0;
+    for(const Prediction& prediction : this->predictions)
+    {
+        if(static_cast<std::size_t>(prediction.vertex) >= vertices.size())
+            continue;
+        const Node& n = vertices[prediction.vertex];
+        minimum[0] = std::min(minimum[0], n.x);
+        minimum[1] = std::min(minimum[1], n.y);
+        maximum[0] = std::max(maximum[0], n.x);
+        maximum[1] = std::max(maximum[1], n.y);
+        this->order[prediction.vertex] = used++;
+    }
+    for(int axis = 0; axis < 2 && used > 0; axis++)
+    {
+        header.minimum[axis] = minimum[axis];
+        header.maximum[axis] = maximum[axis];
+    }
+    double top = static_cast<double>((1u << this->bits) - 1);
+    double step[2] = {(double(header.maximum[0]) - header.minimum[0]) / top, (double(header.maximum[1]) - header.minimum[1]) / top};
+    this->cells.resize(vertices.size());
+    for(std::size_t v = 0; v < vertices.size(); v++)
+    {
+        if(this->order[v] < 0)
+            continue;
+        const float coordinates[2] = {vertices[v].x, vertices[v].y};
+        for(int axis = 0; axis < 2; axis++)
+        {
+            double q = step[axis] > 0.0 ? std::round((coordinates[axis] - double(header.minimum[axis])) / step[axis]) : 0.0;
+            this->cells[v][axis] = static_cast<std::int32_t>(std::clamp(q, 0.0, top));
+        }
+    }
+
+    {
+        TRACE_SCOPE("streams");
+        out->resize(sizeof(MeshCodecHeader));
+        if(this->entropy)
+            this->writeStreams<EntropyWriter>(out, &header, vertices.size());
+        else
+            this->writeStreams<PlainWriter>(out, &header, vertices.size());
+    }
+    std::memcpy(out->data(), &header, sizeof(header));
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+// decoding
+
+bool MeshCodec::zip(int c)
+{
+    // the edge facing c was left to glue; turning around the vertex of prev(c), away from it,
+    // through the edges known so far leads to the free edge it closes the fan with
+    std::size_t limit = this->opposite.size();
+    for(;;)
+    {
+        int a = prevCorner(c);
+        std::size_t steps = 0;
+        while(this->opposite[prevCorner(a)] >= 0)
+        {
+            a = prevCorner(this->opposite[prevCorner(a)]);
+            if(++steps > limit)
+                return false;
+        }
+        int b = prevCorner(a);
+        if(this->opposite[b] != FREE)
+            return true;
+        this->opposite[c] = b;
+        this->opposite[b] = c;
+
+        // the zipper moves on to the other end of the edge, where two more may now meet
+        int x = nextCorner(c), start = x;
+        steps = 0;
+        while(this->opposite[nextCorner(x)] >= 0)
+        {
+            x = nextCorner(this->opposite[nextCorner(x)]);
+            if(x == start)
+                return true;
+            if(++steps > limit)
+                return false;
+        }
+        if(this->opposite[nextCorner(x)] != GLUE)
+            return true;
+        c = nextCorner(x);
+    }
+}
+
+template <typename Reader>
+bool MeshCodec::readSymbols(const MeshCodecHeader& header, Reader& reader)
+{
+    std::size_t triangleCount = header.triangleCount;
+    this->corners.assign(3 * triangleCount, -1);
+    this->opposite.assign(3 * triangleCount, UNSET);
+    this->symbols.assign(triangleCount, START);
+    std::size_t triangle = 0;
+    int vertex = 0;
+    std::vector<int> gates;
+    for(std::uint32_t component = 0; component < header.components; component++)
+    {
+        if(triangle == triangleCount)
+            return this->fail("corrupt connectivity, more components than triangles");
+        int first = 3 * static_cast<int>(triangle++);
+        for(int c = first; c < first + 3; c++)
+            this->corners[c] = vertex++;
+        this->opposite[first + 1] = FREE;
+        this->opposite[first + 2] = FREE;
+        gates.push_back(first);
+        while(!gates.empty())
+        {
+            // the gate is the corner facing the edge the next triangle is attached to
+            int gate = gates.back();
+            gates.pop_back();
+            for(;;)
+            {
+                if(triangle == triangleCount || this->opposite[gate] != UNSET)
+                    return this->fail("corrupt connectivity, the walk leaves the surface");
+                int c = 3 * static_cast<int>(triangle);
+                this->opposite[c] = gate;
+                this->opposite[gate] = c;
+                int symbol = reader.symbol();
+                this->symbols[triangle++] = static_cast<std::uint8_t>(symbol);
+                if(symbol == CREATE)
+                {
+                    this->corners[c] = vertex++;
+                    this->opposite[prevCorner(c)] = FREE;
+                    gate = nextCorner(c);
+                }
+                else if(symbol == LEFT)
+                {
+                    this->opposite[prevCorner(c)] = GLUE;
+                    if(!this->zip(prevCorner(c)))
+                        return this->fail("corrupt connectivity, a fan does not close");
+                    gate = nextCorner(c);
+                }
+                else if(symbol == RIGHT)
+                {
+                    // glued later, when the zipper comes by
+                    this->opposite[nextCorner(c)] = GLUE;
+                    gate = prevCorner(c);
+                }
+                else if(symbol == SPLIT)
+                {
+                    gates.push_back(prevCorner(c));
+                    gate = nextCorner(c);
+                }
+                else if(symbol == END)
+                {
+                    this->opposite[nextCorner(c)] = GLUE;
+                    this->opposite[prevCorner(c)] = GLUE;
+                    if(!this->zip(prevCorner(c)))
+                        return this->fail("corrupt connectivity, a fan does not close");
+                    break;
+                }
+                else
+                    return this->fail("corrupt connectivity, invalid symbol");
+            }
+        }
+    }
+    if(triangle != triangleCount || static_cast<std::uint64_t>(vertex) != header.vertexCount)
+        return this->fail("corrupt connectivity, the counts do not match the header");
+    for(int o : this->opposite)
+    {
+        if(o < 0)
+            return this->fail("corrupt connectivity, the surface does not close");
+    }
+    return true;
+}
+
+bool MeshCodec::nameVertices(void)
+{
+    // a vertex got its number at the corner that created it, the corners around it take it over
+    std::size_t triangleCount = this->symbols.size();
+    for(std::size_t t = 0; t < triangleCount; t++)
+    {
+        int first = 3 * static_cast<int>(t);
+        int last = this->symbols[t] == START ? first + 2 : this->symbols[t] == CREATE ? first : first - 1;
+        for(int c = first; c <= last; c++)
+        {
+            for(int x = nextCorner(this->opposite[nextCorner(c)]); x != c; x = nextCorner(this->opposite[nextCorner(x)]))
+            {
+                if(this->corners[x] >= 0)
+                    return this->fail("corrupt connectivity, a vertex is created twice");
+                this->corners[x] = this->corners[c];
+            }
+        }
+    }
+    for(int v : this->corners)
+    {
+        if(v < 0)
+            return this->fail("corrupt connectivity, a vertex is never created");
+    }
+    return true;
+}
+
+template <typename Reader>
+bool MeshCodec::readGeometry(const MeshCodecHeader& header, Reader& reader, std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles)
+{
+    std::size_t vertexCount = header.vertexCount;
+    std::vector<int> index(vertexCount, -1);
+    this->cells.assign(vertexCount, Cell{0, 0});
+    int bits = static_cast<int>(header.bits);
+    std::int32_t top = static_cast<std::int32_t>((1u << bits) - 1);
+    double step[2] = {(double(header.maximum[0]) - header.minimum[0]) / top, (double(header.maximum[1]) - header.minimum[1]) / top};
+    auto cell = [&](int v) -> const Cell*
+    {
+        return index[v] >= 0 ? &this->cells[v] : nullptr;
+    };
+
+    // vertices come in the order they were created, the same as their numbers
+    vertices->reserve(vertexCount);
+    for(std::size_t t = 0; t < this->symbols.size(); t++)
+    {
+        int first = 3 * static_cast<int>(t);
+        int last = this->symbols[t] == START ? first + 2 : this->symbols[t] == CREATE ? first : first - 1;
+        for(int c = first; c <= last; c++)
+        {
+            int v = this->corners[c];
+            if(reader.flag())
+                continue;
+            Cell& position = this->cells[v];
+            if(this->symbols[t] == START)
+            {
+                position[0] = static_cast<std::int32_t>(reader.raw(bits));
+                position[1] = static_cast<std::int32_t>(reader.raw(bits));
+            }
+            else
+            {
+                Cell guess = predict(cell(this->corners[nextCorner(c)]), cell(this->corners[prevCorner(c)]),
+                                     cell(this->corners[this->opposite[c]]), top);
+                for(int axis = 0; axis < 2; axis++)
+                {
+                    std::int64_t value = std::int64_t(guess[axis]) + unzigzag(reader.value(axis));
+                    if(value < 0 || value > top)
+                        return this->fail("corrupt geometry, a vertex is off the grid");
+                    position[axis] = static_cast<std::int32_t>(value);
+                }
+            }
+            index[v] = static_cast<int>(vertices->size());
+            vertices->push_back(Node(static_cast<float>(header.minimum[0] + position[0] * step[0]),
+                                     static_cast<float>(header.minimum[1] + position[1] * step[1])));
+        }
+    }
+
+    // the triangles of the dummy vertices close the boundaries and are dropped
+    triangles->reserve(this->symbols.size());
+    for(std::size_t c = 0; c < this->corners.size(); c += 3)
+    {
+        int a = index[this->corners[c]], b = index[this->corners[c + 1]], d = index[this->corners[c + 2]];
+        if(a >= 0 && b >= 0 && d >= 0)
+            triangles->push_back({a, b, d});
+    }
+    return true;
+}
+
+template <typename Reader>
+bool MeshCodec::decodeStreams(const MeshCodecHeader& header, std::span<const unsigned char> streams,
+                              std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles)
+{
+    {
+        TRACE_SCOPE("connectivity");
+        Reader connectivity(streams.first(header.connectivityBytes));
+        if(!this->readSymbols(header, connectivity))
+            return false;
+        if(connectivity.isOverrun())
+            return this->fail("connectivity stream cut short");
+        if(!this->nameVertices())
+            return false;
+    }
+    TRACE_SCOPE("geometry");
+    Reader geometry(streams.subspan(header.connectivityBytes));
+    if(!this->readGeometry(header, geometry, vertices, triangles))
+        return false;
+    if(geometry.isOverrun())
+    {
+        vertices->clear();
+        triangles->clear();
+        return this->fail("geometry stream cut short");
+    }
+    return true;
+}
+
+bool MeshCodec::decode(std::span<const unsigned char> data, std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles)
+{
+    TRACE_SCOPE("decodeMesh");
+    this->error.clear();
+    vertices->clear();
+    triangles->clear();
+    if constexpr(std::endian::native != std::endian::little)
+        return this->fail("meshes are only decoded on little-endian hosts");
+    MeshCodecHeader header;
+    if(data.size() < sizeof(header))
+        return this->fail("too short for an encoded mesh");
+    std::memcpy(&header, data.data(), sizeof(header));
+    if(std::memcmp(header.magic, MeshCodecHeader::MAGIC, sizeof(header.magic)) != 0)
+        return this->fail("not an encoded mesh");
+    if(header.version != MeshCodecHeader::VERSION)
+        return this->fail("unsupported encoding version " + std::to_string(header.version));
+    // a symbol takes a few hundredths of a bit at the very least, more triangles than this
+    // are a corrupt count that would only make the tables huge
+    std::span<const unsigned char> streams = data.subspan(sizeof(header));
+    if(header.bits < 1 || header.bits > MAX_BITS || header.connectivityBytes > streams.size()
+       || header.triangleCount > MAX_TRIANGLES || header.triangleCount > 256 * std::uint64_t(data.size())
+       || header.vertexCount > 3 * header.triangleCount || header.components > header.triangleCount)
+        return this->fail("corrupt header");
+
+    if(header.flags & MeshCodecHeader::ENTROPY_CODED)
+        return this->decodeStreams<EntropyReader>(header, streams, vertices, triangles);
+    return this->decodeStreams<PlainReader>(header, streams, vertices, triangles);
+}
+
+// ---------------------------------------------------------------------------------------
+// files
+
+bool MeshCodec::write(const char* path, const Mesh& mesh)
+{
+    std::vector<unsigned char> bytes;
+    if(!this->encode(mesh, &bytes))
+        return false;
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return this->fail(std::string("could not create ") + path);
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = std::fclose(file) == 0 && ok;
+    if(!ok)
+        return this->fail(std::string("could not write ") + path);
+    return true;
+}
+
+bool MeshCodec::read(const char* path, std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles)
+{
+    std::FILE* file = std::fopen(path, "rb");
+    if(file == nullptr)
+        return this->fail(std::string("could not open ") + path);
+    std::vector<unsigned char> bytes;
+    std::size_t size = 0;
+    do
+    {
+        bytes.resize(size + (1 << 20));
+        size += std::fread(bytes.data() + size, 1, bytes.size() - size, file);
+    }
+    while(size == bytes.size());
+    bool ok = !std::ferror(file);
+    std::fclose(file);
+    if(!ok)
+        return this->fail(std::string("could not read ") + path);
+    bytes.resize(size);
+    return this->decode(bytes, vertices, triangles);
+}
@@ -0,0 +1,136 @@
+#ifndef MESHCODEC_H
+#define MESHCODEC_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+#include "meshfile.h"
+
+/** Fixed 64 byte header of an encoded mesh, followed by the connectivity stream of
+* connectivityBytes and the geometry stream up to the end. The counts are those of the
+* closed surface the codec works on, dummy vertices and their triangles included. */
+class MeshCodecHeader
+{
+public:
+    static constexpr char MAGIC[8] = {'D', 'E', 'L', 'A', 'U', 'N', 'A', 'Z'};
+    static const std::uint32_t VERSION = 1;
+    static const std::uint32_t ENTROPY_CODED = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t bits;        // quantization bits per coordinate
+    std::uint32_t components;  // connected pieces, each started from a triangle sent whole
+    std::uint64_t vertexCount;
+    std::uint64_t triangleCount;
+    std::uint64_t connectivityBytes;
+    float minimum[2];          // bounding box the coordinates are quantized over
+    float maximum[2];
+};
+
+static_assert(sizeof(MeshCodecHeader) == 64, "the header is part of the encoding");
+
+/** Compressed encoding of a triangulation for storage and transfer, a few bytes per triangle.
+* Connectivity is coded with Edgebreaker: every boundary loop is closed by a dummy vertex
+* joined to its edges, making each component a closed surface, and a depth first walk over
+* it spells one of five symbols per triangle, C for a vertex reached for the first time and
+* L, R, S or E for how the triangle meets the region already walked. The decoder wraps the
+* triangles in the same order and zips the boundary edges the symbols say are shared, then
+* names the vertices, in linear time. Coordinates are quantized to bits per axis over the
+* bounding box and every vertex is predicted from the parallelogram of the triangle it was
+* reached from, so only the small residuals are stored. With entropy coding, the default,
+* symbols, residual lengths and flags go through an adaptive binary range coder with the
+* previous symbol as context, typically 1.5 bits of connectivity per triangle; without it
+* everything is bit-packed with fixed prefix codes, which decodes somewhat faster.
+* The triangles have to form an oriented manifold whose components are spheres or disks,
+* possibly with holes, as every triangulation of a point set does. Vertices come back in
+* the order of the walk, see getOrder(), and within half a quantization step of where they
+* were; vertices no triangle uses are dropped. */
+class MeshCodec
+{
+public:
+    static constexpr int DEFAULT_BITS = 20;
+    static constexpr int MAX_BITS = 30;
+
+    /// bits per coordinate in [1, MAX_BITS]
+    explicit MeshCodec(int bits = DEFAULT_BITS, bool entropy = true);
+
+    /// replaces the contents of out
+    /// @return false with getError() set if the triangles are not an oriented manifold of that kind
+    bool encode(std::span<const Node> vertices, std::span<const MeshFile::Triple> triangles, std::vector<unsigned char>* out);
+    /// encodes the finite faces of a mesh, dropping the super-triangle and removed vertices
+    bool encode(const Mesh& mesh, std::vector<unsigned char>* out);
+    /// replaces the contents of vertices and triangles
+    /// @return false with getError() set if data is not a valid encoding
+    bool decode(std::span<const unsigned char> data, std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles);
+
+    /// encodes a mesh into a file
+    bool write(const char* path, const Mesh& mesh);
+    /// decodes a file written by write()
+    bool read(const char* path, std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles);
+
+    /// @return for every vertex of the last encode its index in the decoded mesh, -1 if it is dropped
+    inline const std::vector<int>& getOrder(void) const noexcept
+    {
+        return this->order;
+    }
+
+    inline int getBits(void) const noexcept
+    {
+        return this->bits;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    typedef std::array<std::int32_t, 2> Cell;
+
+    /// a vertex in the order of the walk and the vertices predicting it, -1 for none
+    class Prediction
+    {
+    public:
+        int vertex;
+        int a, b;     // the ends of the edge the walk crossed
+        int opposite; // the third vertex of the triangle the walk came from
+    };
+
+    bool buildCorners(std::size_t vertexCount, std::span<const MeshFile::Triple> triangles);
+    bool closeBoundaries(std::size_t vertexCount);
+    bool traverse(std::size_t vertexCount);
+    template <typename Writer>
+    void writeStreams(std::vector<unsigned char>* out, MeshCodecHeader* header, std::size_t vertexCount);
+
+    template <typename Reader>
+    bool readSymbols(const MeshCodecHeader& header, Reader& reader);
+    bool zip(int c);
+    bool nameVertices(void);
+    template <typename Reader>
+    bool readGeometry(const MeshCodecHeader& header, Reader& reader, std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles);
+    template <typename Reader>
+    bool decodeStreams(const MeshCodecHeader& header, std::span<const unsigned char> streams,
+                       std::vector<Node>* vertices, std::vector<MeshFile::Triple>* triangles);
+    bool fail(const std::string& message);
+
+    int bits;
+    bool entropy;
+    std::vector<int> corners;         // vertex of every corner, triangle t owns corners 3t to 3t + 2
+    std::vector<int> opposite;        // corner across the edge facing every corner
+    std::vector<std::uint8_t> symbols;
+    std::vector<Prediction> predictions;
+    std::vector<Cell> cells;
+    std::vector<int> order;
+    std::size_t loops = 0;            // boundary loops closed, one dummy vertex each
+    std::size_t components = 0;
+    std::string error;
+};
+
+#endif // MESHCODEC_H
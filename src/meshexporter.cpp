@@ -0,0 +1,262 @@
+#include "meshexporter.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <future>
+
+#include "threadpool.h"
+#include "trace.h"
+
+/// rounds in flight hold this many chunks per worker, enough to keep every worker busy
+static const std::size_t CHUNKS_PER_WORKER = 4;
+
+/// copies a literal, the terminating zero left out
+template <std::size_t N>
+static inline char* put(char* out, const char (&text)[N]) noexcept
+{
+    std::memcpy(out, text, N - 1);
+    return out + N - 1;
+}
+
+template <typename T>
+static inline char* putValue(char* out, const T& value) noexcept
+{
+    std::memcpy(out, &value, sizeof(T));
+    return out + sizeof(T);
+}
+
+/// shortest text that reads back as the same value, at most MAX_NUMBER characters
+static const std::size_t MAX_NUMBER = 16;
+
+template <typename T>
+static inline char* putNumber(char* out, T value) noexcept
+{
+    return std::to_chars(out, out + MAX_NUMBER, value).ptr;
+}
+
+/// room for the text of a vertex, x and y with a comma between
+static const std::size_t COORDINATE_SLOT = 2 * MAX_NUMBER;
+
+MeshExporter::MeshExporter(ThreadPool* pool) : pool(pool)
+{
+}
+
+bool MeshExporter::fail(const std::string& message)
+{
+    this->error = message;
+    return false;
+}
+
+const char* MeshExporter::formatName(Format format) noexcept
+{
+    static const char* const NAMES[] = {"obj", "ply", "stl", "geojson"};
+    return NAMES[format];
+}
+
+bool MeshExporter::formatOf(const char* path, Format* format)
+{
+    const char* dot = std::strrchr(path, '.');
+    if(dot == nullptr)
+        return false;
+    std::string extension = dot + 1;
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if(extension == "obj")
+        *format = OBJ;
+    else if(extension == "ply")
+        *format = PLY;
+    else if(extension == "stl")
+        *format = STL;
+    else if(extension == "geojson" || extension == "json")
+        *format = GEOJSON;
+    else
+        return false;
+    return true;
+}
+
+bool MeshExporter::writeText(std::FILE* file, const char* text)
+{
+    std::size_t length = std::strlen(text);
+    this->bytes += length;
+    return std::fwrite(text, 1, length, file) == length;
+}
+
+template <typename Item>
+bool MeshExporter::emit(std::FILE* file, std::size_t count, std::size_t itemBytes, Item item)
+{
+    std::size_t chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::size_t perRound = (this->pool != nullptr ? this->pool->size() : 1) * CHUNKS_PER_WORKER;
+    for(std::vector<Chunk>& round : this->rounds)
+        round.resize(std::max(round.size(), perRound));
+
+    std::future<bool> writing;
+    int current = 0;
+    for(std::size_t first = 0; first < chunks; first += perRound, current ^= 1)
+    {
+        std::size_t n = std::min(perRound, chunks - first);
+        std::vector<Chunk>& round = this->rounds[current];
+        auto format = [&](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for(std::size_t c = begin; c < end; c++)
+            {
+                std::size_t low = (first + c) * CHUNK_SIZE, high = std::min(count, low + CHUNK_SIZE);
+                // grown once to the largest chunk, then reused without clearing
+                Chunk& chunk = round[c];
+                if(chunk.bytes.size() < (high - low) * itemBytes)
+                    chunk.bytes.resize((high - low) * itemBytes);
+                char* out = chunk.bytes.data();
+                for(std::size_t i = low; i < high; i++)
+                    out = item(i, out);
+                chunk.size = static_cast<std::size_t>(out - chunk.bytes.data());
+            }
+        };
+        {
+            TRACE_SCOPE("format");
+            if(this->pool != nullptr)
+                this->pool->parallelFor(n, 1, format);
+            else
+                format(0, n, 0);
+        }
+
+        // the previous round has to be out before its buffers are formatted into again
+        if(writing.valid() && !writing.get())
+            return false;
+        writing = std::async(std::launch::async, [this, file, &round, n]()
+        {
+            TRACE_SCOPE("write");
+            for(std::size_t c = 0; c < n; c++)
+            {
+                if(std::fwrite(round[c].bytes.data(), 1, round[c].size, file) != round[c].size)
+                    return false;
+                this->bytes += round[c].size;
+            }
+            return true;
+        });
+    }
+    return !writing.valid() || writing.get();
+}
+
+bool MeshExporter::write(const char* path, Format format, const Mesh& mesh)
+{
+    std::vector<Node> vertices;
+    std::vector<MeshFile::Triple> triangles;
+    MeshFile::compact(mesh, &vertices, &triangles);
+    return this->write(path, format, vertices, triangles);
+}
+
+bool MeshExporter::write(const char* path, Format format, std::span<const Node> vertices, std::span<const MeshFile::Triple> triangles)
+{
+    TRACE_SCOPE("exportMesh");
+    this->error.clear();
+    this->bytes = 0;
+    if((format == PLY || format == STL) && std::endian::native != std::endian::little)
+        return this->fail("binary formats are only written on little-endian hosts");
+
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return this->fail(std::string("could not create ") + path);
+    // every write is a whole chunk, stdio buffering would only copy it once more
+    std::setvbuf(file, nullptr, _IONBF, 0);
+
+    bool ok = true;
+    switch(format)
+    {
+    case OBJ:
+        ok = this->writeText(file, "# Delaunay triangulation\n");
+        ok = ok && this->emit(file, vertices.size(), 2 * MAX_NUMBER + 8, [&](std::size_t i, char* out)
+        {
+            out = putNumber(put(out, "v "), vertices[i].x);
+            out = putNumber(put(out, " "), vertices[i].y);
+            return put(out, " 0\n");
+        });
+        ok = ok && this->emit(file, triangles.size(), 3 * MAX_NUMBER + 8, [&](std::size_t i, char* out)
+        {
+            out = putNumber(put(out, "f "), triangles[i][0] + 1);
+            out = putNumber(put(out, " "), triangles[i][1] + 1);
+            out = putNumber(put(out, " "), triangles[i][2] + 1);
+            return put(out, "\n");
+        });
+        break;
+    case PLY:
+    {
+        std::string header = "ply\nformat binary_little_endian 1.0\nelement vertex " + std::to_string(vertices.size())
+                           + "\nproperty float x\nproperty float y\nproperty float z\nelement face " + std::to_string(triangles.size())
+                           + "\nproperty list uchar int vertex_indices\nend_header\n";
+        ok = this->writeText(file, header.c_str());
+        ok = ok && this->emit(file, vertices.size(), 3 * sizeof(float), [&](std::size_t i, char* out)
+        {
+            const float xyz[3] = {vertices[i].x, vertices[i].y, 0.0f};
+            return putValue(out, xyz);
+        });
+        ok = ok && this->emit(file, triangles.size(), 1 + sizeof(MeshFile::Triple), [&](std::size_t i, char* out)
+        {
+            *out++ = 3;
+            return putValue(out, triangles[i]);
+        });
+        break;
+    }
+    case STL:
+    {
+        char header[80] = {};
+        std::memcpy(header, "binary STL, Delaunay triangulation", 34);
+        std::uint32_t count = static_cast<std::uint32_t>(triangles.size());
+        ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header) && std::fwrite(&count, sizeof(count), 1, file) == 1;
+        this->bytes += sizeof(header) + sizeof(count);
+        ok = ok && this->emit(file, triangles.size(), 12 * sizeof(float) + sizeof(std::uint16_t), [&](std::size_t i, char* out)
+        {
+            // counter-clockwise in the plane, so the normal is +z
+            const Node& a = vertices[triangles[i][0]];
+            const Node& b = vertices[triangles[i][1]];
+            const Node& c = vertices[triangles[i][2]];
+            const float facet[12] = {0.0f, 0.0f, 1.0f, a.x, a.y, 0.0f, b.x, b.y, 0.0f, c.x, c.y, 0.0f};
+            const std::uint16_t attributes = 0;
+            return putValue(putValue(out, facet), attributes);
+        });
+        break;
+    }
+    case GEOJSON:
+    {
+        // every vertex is a corner of about six triangles, its coordinates are formatted once
+        std::vector<char> coordinates(vertices.size() * COORDINATE_SLOT);
+        std::vector<std::uint8_t> lengths(vertices.size());
+        auto format = [&](std::size_t begin, std::size_t end, unsigned int)
+        {
+            for(std::size_t i = begin; i < end; i++)
+            {
+                char* slot = coordinates.data() + i * COORDINATE_SLOT;
+                char* out = putNumber(slot, vertices[i].x);
+                out = putNumber(put(out, ","), vertices[i].y);
+                lengths[i] = static_cast<std::uint8_t>(out - slot);
+            }
+        };
+        if(this->pool != nullptr)
+            this->pool->parallelFor(vertices.size(), CHUNK_SIZE, format);
+        else
+            format(0, vertices.size(), 0);
+
+        ok = this->writeText(file, "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{},"
+                                   "\"geometry\":{\"type\":\"MultiPolygon\",\"coordinates\":[\n");
+        ok = ok && this->emit(file, triangles.size(), 4 * COORDINATE_SLOT + 32, [&](std::size_t i, char* out)
+        {
+            out = i == 0 ? put(out, "[[") : put(out, ",\n[[");
+            for(int k = 0; k <= 3; k++)
+            {
+                // the ring ends where it starts
+                int v = triangles[i][k % 3];
+                out = k == 0 ? put(out, "[") : put(out, ",[");
+                std::memcpy(out, coordinates.data() + std::size_t(v) * COORDINATE_SLOT, lengths[v]);
+                out = put(out + lengths[v], "]");
+            }
+            return put(out, "]]");
+        });
+        ok = ok && this->writeText(file, "\n]}}]}\n");
+        break;
+    }
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if(!ok)
+        return this->fail(std::string("could not write ") + path);
+    return true;
+}
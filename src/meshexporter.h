@@ -0,0 +1,79 @@
+#ifndef MESHEXPORTER_H
+#define MESHEXPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+#include "meshfile.h"
+
+class ThreadPool;
+
+/** Writes a triangulation in formats other tools read.
+*   OBJ      text, a v line per vertex with z = 0 and an f line per triangle, 1-based
+*   PLY      binary little-endian, float x y z vertices and uchar-counted int32 faces
+*   STL      binary, 80 byte header, a +z normal and three corners per triangle
+*   GEOJSON  one Feature holding a MultiPolygon, a closed counter-clockwise ring per triangle
+* The output is cut into chunks of CHUNK_SIZE vertices or triangles, which the workers of
+* the pool format in parallel, numbers with std::to_chars in their shortest round-trip
+* form, into buffers reused from round to round. A round of chunks goes to the file in
+* order on a writer thread while the workers format the next one, so a large export runs
+* at the speed of the disk rather than of the formatting. */
+class MeshExporter
+{
+public:
+    enum Format {OBJ, PLY, STL, GEOJSON};
+
+    static const std::size_t CHUNK_SIZE = 1 << 15;
+
+    /// formats on the calling thread alone without a pool
+    explicit MeshExporter(ThreadPool* pool = nullptr);
+
+    /// @return false with getError() set if the file could not be written
+    bool write(const char* path, Format format, std::span<const Node> vertices, std::span<const MeshFile::Triple> triangles);
+    /// writes the finite faces of a mesh, dropping the super-triangle and removed vertices
+    bool write(const char* path, Format format, const Mesh& mesh);
+
+    /// @return the format named by the extension of path: .obj, .ply, .stl, .geojson or .json
+    static bool formatOf(const char* path, Format* format);
+    static const char* formatName(Format format) noexcept;
+
+    /// @return the size of the last file written
+    inline std::uint64_t getBytes(void) const noexcept
+    {
+        return this->bytes;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    /// a formatted chunk, bytes only grows so a round reuses the memory of the one before
+    class Chunk
+    {
+    public:
+        std::vector<char> bytes;
+        std::size_t size = 0;
+    };
+
+    /// appends the output of item(i, out) for every i in [0, count) to the file, chunk by chunk;
+    /// item writes at most itemBytes at out and returns the end of what it wrote
+    template <typename Item>
+    bool emit(std::FILE* file, std::size_t count, std::size_t itemBytes, Item item);
+    bool writeText(std::FILE* file, const char* text);
+    bool fail(const std::string& message);
+
+    ThreadPool* pool;
+    std::vector<Chunk> rounds[2]; // the round being formatted and the round being written
+    std::uint64_t bytes = 0;
+    std::string error;
+};
+
+#endif // MESHEXPORTER_H
@@ -0,0 +1,239 @@
+#include "meshfile.h"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "predicates.h"
+#include "trace.h"
+
+static_assert(sizeof(Node) == 2 * sizeof(float), "vertices are used in place as Node arrays");
+static_assert(sizeof(MeshFile::Triple) == 3 * sizeof(std::int32_t), "triangles are used in place as index triples");
+
+static inline std::uint64_t alignUp(std::uint64_t offset) noexcept
+{
+    return (offset + MeshFileHeader::ALIGNMENT - 1) / MeshFileHeader::ALIGNMENT * MeshFileHeader::ALIGNMENT;
+}
+
+/// writes bytes, then zeros up to the next aligned offset
+static bool writePadded(std::FILE* file, const void* bytes, std::uint64_t count, std::uint64_t* offset)
+{
+    static const char ZEROS[MeshFileHeader::ALIGNMENT] = {};
+    if(count > 0 && std::fwrite(bytes, 1, count, file) != count)
+        return false;
+    std::uint64_t padding = alignUp(*offset + count) - *offset - count;
+    *offset += count + padding;
+    return std::fwrite(ZEROS, 1, padding, file) == padding;
+}
+
+MeshFile::~MeshFile()
+{
+    this->close();
+}
+
+bool MeshFile::fail(const std::string& message)
+{
+    this->close();
+    this->error = message;
+    return false;
+}
+
+bool MeshFile::open(const char* path)
+{
+    TRACE_SCOPE("openMeshFile");
+    this->close();
+    this->error.clear();
+    if constexpr(std::endian::native != std::endian::little)
+        return this->fail("mesh files can only be used in place on little-endian hosts");
+
+#if defined(_WIN32)
+    this->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(this->file == INVALID_HANDLE_VALUE)
+    {
+        this->file = nullptr;
+        return this->fail(std::string("could not open ") + path);
+    }
+    LARGE_INTEGER length;
+    if(!GetFileSizeEx(this->file, &length) || length.QuadPart < static_cast<LONGLONG>(sizeof(MeshFileHeader)))
+        return this->fail(std::string(path) + " is too short for a mesh file");
+    this->size = static_cast<std::size_t>(length.QuadPart);
+    this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(this->mapping == nullptr)
+        return this->fail(std::string("could not map ") + path);
+    this->data = static_cast<const unsigned char*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    if(this->data == nullptr)
+        return this->fail(std::string("could not map ") + path);
+#else
+    int descriptor = ::open(path, O_RDONLY);
+    if(descriptor < 0)
+        return this->fail(std::string("could not open ") + path);
+    struct stat status;
+    if(fstat(descriptor, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(MeshFileHeader)))
+    {
+        ::close(descriptor);
+        return this->fail(std::string(path) + " is too short for a mesh file");
+    }
+    this->size = static_cast<std::size_t>(status.st_size);
+    void* address = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor); // the mapping keeps the file open
+    if(address == MAP_FAILED)
+        return this->fail(std::string("could not map ") + path);
+    this->data = static_cast<const unsigned char*>(address);
+#endif
+
+    // only the header is read, every array it points at must lie inside the file
+    const MeshFileHeader* h = reinterpret_cast<const MeshFileHeader*>(this->data);
+    if(std::memcmp(h->magic, MeshFileHeader::MAGIC, sizeof(h->magic)) != 0)
+        return this->fail(std::string(path) + " is not a mesh file");
+    if(h->version != MeshFileHeader::VERSION)
+        return this->fail(std::string(path) + " has unsupported version " + std::to_string(h->version));
+    if(h->fileSize != this->size)
+        return this->fail(std::string(path) + " is truncated");
+
+    auto fits = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t itemSize)
+    {
+        return offset % MeshFileHeader::ALIGNMENT == 0 && offset >= sizeof(MeshFileHeader) && offset <= this->size
+            && count <= (this->size - offset) / itemSize;
+    };
+    bool adjacent = (h->flags & MeshFileHeader::HAS_ADJACENCY) != 0;
+    if(!fits(h->vertexOffset, h->vertexCount, sizeof(Node)) || !fits(h->triangleOffset, h->triangleCount, sizeof(Triple))
+        || (adjacent && !fits(h->adjacencyOffset, h->triangleCount, sizeof(Triple))))
+        return this->fail(std::string(path) + " has arrays outside the file");
+
+    this->header = h;
+    return true;
+}
+
+void MeshFile::close(void)
+{
+#if defined(_WIN32)
+    if(this->data != nullptr)
+        UnmapViewOfFile(this->data);
+    if(this->mapping != nullptr)
+        CloseHandle(this->mapping);
+    if(this->file != nullptr)
+        CloseHandle(this->file);
+    this->mapping = nullptr;
+    this->file = nullptr;
+#else
+    if(this->data != nullptr)
+        munmap(const_cast<unsigned char*>(this->data), this->size);
+#endif
+    this->data = nullptr;
+    this->size = 0;
+    this->header = nullptr;
+}
+
+bool MeshFile::write(const char* path, std::span<const Node> vertices, std::span<const Triple> triangles,
+                     std::span<const Triple> adjacency)
+{
+    TRACE_SCOPE("writeMeshFile");
+    if constexpr(std::endian::native != std::endian::little)
+        return false;
+    if(!adjacency.empty() && adjacency.size() != triangles.size())
+        return false;
+
+    MeshFileHeader header = MeshFile::layout(vertices.size(), triangles.size(), !adjacency.empty());
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return false;
+    std::uint64_t offset = 0;
+    bool ok = writePadded(file, &header, sizeof(header), &offset)
+        && writePadded(file, vertices.data(), vertices.size_bytes(), &offset)
+        && writePadded(file, triangles.data(), triangles.size_bytes(), &offset)
+        && (adjacency.empty() || writePadded(file, adjacency.data(), adjacency.size_bytes(), &offset));
+    return std::fclose(file) == 0 && ok;
+}
+
+MeshFileHeader MeshFile::layout(std::uint64_t vertexCount, std::uint64_t triangleCount, bool adjacency)
+{
+    MeshFileHeader header{};
+    std::memcpy(header.magic, MeshFileHeader::MAGIC, sizeof(header.magic));
+    header.version = MeshFileHeader::VERSION;
+    header.flags = adjacency ? MeshFileHeader::HAS_ADJACENCY : 0;
+    header.vertexCount = vertexCount;
+    header.triangleCount = triangleCount;
+    header.vertexOffset = alignUp(sizeof(MeshFileHeader));
+    header.triangleOffset = alignUp(header.vertexOffset + vertexCount * sizeof(Node));
+    header.adjacencyOffset = adjacency ? alignUp(header.triangleOffset + triangleCount * sizeof(Triple)) : 0;
+    header.fileSize = adjacency ? alignUp(header.adjacencyOffset + triangleCount * sizeof(Triple))
+                                : alignUp(header.triangleOffset + triangleCount * sizeof(Triple));
+    return header;
+}
+
+void MeshFile::compact(const Mesh& mesh, std::vector<Node>* vertices, std::vector<Triple>* triangles, std::vector<Triple>* adjacency)
+{
+    // number the live vertices and finite faces densely, everything else maps to NONE
+    std::vector<int> vertexIndex(mesh.vertices.size(), Mesh::NONE);
+    std::vector<int> faceIndex(mesh.faces.size(), Mesh::NONE);
+    for(int v = 3; v < static_cast<int>(mesh.vertices.size()); v++)
+    {
+        if(!mesh.isVertexAlive(v))
+            continue;
+        vertexIndex[v] = static_cast<int>(vertices->size());
+        vertices->push_back(mesh.vertices[v]);
+    }
+    for(int f = 0; f < static_cast<int>(mesh.faces.size()); f++)
+    {
+        if(!mesh.isAlive(f) || mesh.isSuperFace(f))
+            continue;
+        faceIndex[f] = static_cast<int>(triangles->size());
+        const Mesh::Face& face = mesh.faces[f];
+        triangles->push_back({vertexIndex[face.v[0]], vertexIndex[face.v[1]], vertexIndex[face.v[2]]});
+    }
+    if(adjacency == nullptr)
+        return;
+    adjacency->reserve(adjacency->size() + triangles->size());
+    for(int f = 0; f < static_cast<int>(mesh.faces.size()); f++)
+    {
+        if(faceIndex[f] == Mesh::NONE)
+            continue;
+        const Mesh::Face& face = mesh.faces[f];
+        Triple links;
+        for(int i = 0; i < 3; i++)
+            links[i] = face.adj[i] == Mesh::NONE ? Mesh::NONE : faceIndex[face.adj[i]];
+        adjacency->push_back(links);
+    }
+}
+
+bool MeshFile::write(const char* path, const Mesh& mesh)
+{
+    std::vector<Node> vertices;
+    std::vector<Triple> triangles, adjacency;
+    MeshFile::compact(mesh, &vertices, &triangles, &adjacency);
+    return MeshFile::write(path, vertices, triangles, adjacency);
+}
+
+int MeshFile::locate(const Node& n, int hint) const
+{
+    std::span<const Node> vertex = this->vertices();
+    std::span<const Triple> triangle = this->triangles();
+    std::span<const Triple> neighbour = this->adjacency();
+    if(triangle.empty() || neighbour.empty())
+        return Mesh::NONE;
+
+    // a visibility walk, it cannot cycle on a Delaunay triangulation
+    int t = hint >= 0 && hint < static_cast<int>(triangle.size()) ? hint : 0;
+    while(true)
+    {
+        const Triple& f = triangle[t];
+        int i = 0;
+        while(i < 3 && orient2d(vertex[f[(i + 1) % 3]], vertex[f[(i + 2) % 3]], n) >= 0.0)
+            i++;
+        if(i == 3)
+            return t;
+        t = neighbour[t][i];
+        if(t == Mesh::NONE)
+            return Mesh::NONE;
+    }
+}
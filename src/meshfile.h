@@ -0,0 +1,129 @@
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+
+/** Fixed 64 byte header at the start of a mesh file.
+* Layout, all little-endian:
+*   header       64 bytes
+*   vertices     vertexCount   x 2 float32, x then y          at vertexOffset
+*   triangles    triangleCount x 3 int32, counter-clockwise  at triangleOffset
+*   adjacency    triangleCount x 3 int32                     at adjacencyOffset, 0 when absent
+* Every array starts on an ALIGNMENT byte boundary, so a mapping of the file can be used
+* as Node and index triple arrays as it is. adjacency[t][i] is the triangle across the edge
+* opposite triangles[t][i], or -1 on the hull, as in Mesh::Face. A file without
+* triangles is a plain point set. */
+class MeshFileHeader
+{
+public:
+    static constexpr char MAGIC[8] = {'D', 'E', 'L', 'A', 'U', 'N', 'A', 'Y'};
+    static const std::uint32_t VERSION = 1;
+    static const std::uint32_t HAS_ADJACENCY = 1;
+    static const std::size_t ALIGNMENT = 64;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t vertexCount;
+    std::uint64_t triangleCount;
+    std::uint64_t vertexOffset;
+    std::uint64_t triangleOffset;
+    std::uint64_t adjacencyOffset;
+    std::uint64_t fileSize;
+};
+
+static_assert(sizeof(MeshFileHeader) == 64, "the header is part of the file format");
+
+/** A read-only view of a mesh file mapped into memory.
+* open() maps the file and checks the header, which takes the same time for any size:
+* nothing is read or copied until the arrays are touched, and then the pages come
+* straight from the file cache. The indices are not checked, run a DelaunayVerifier
+* over the view when the file is not trusted. */
+class MeshFile
+{
+public:
+    typedef std::array<int, 3> Triple;
+
+    MeshFile(void) = default;
+    ~MeshFile();
+
+    MeshFile(const MeshFile&) = delete;
+    MeshFile& operator = (const MeshFile&) = delete;
+
+    /// @return false with getError() set if the file is missing or not a valid mesh file
+    bool open(const char* path);
+    void close(void);
+
+    /// writes a mesh file, adjacency may be empty
+    static bool write(const char* path, std::span<const Node> vertices, std::span<const Triple> triangles,
+                      std::span<const Triple> adjacency = {});
+    /// writes the finite faces of a mesh with their adjacency, dropping the super-triangle and removed vertices
+    static bool write(const char* path, const Mesh& mesh);
+    /// appends the live vertices and finite faces of a mesh numbered densely, and their adjacency if asked for
+    static void compact(const Mesh& mesh, std::vector<Node>* vertices, std::vector<Triple>* triangles,
+                        std::vector<Triple>* adjacency = nullptr);
+    /// @return the header of a file with these counts, every offset and the file size filled in
+    static MeshFileHeader layout(std::uint64_t vertexCount, std::uint64_t triangleCount, bool adjacency);
+
+    /// walks from the hint triangle towards n along the adjacency, which must be present
+    /// @return the triangle containing n, or Mesh::NONE if n is outside the hull
+    int locate(const Node& n, int hint = 0) const;
+
+    inline bool isOpen(void) const noexcept
+    {
+        return this->header != nullptr;
+    }
+
+    inline bool hasAdjacency(void) const noexcept
+    {
+        return this->header != nullptr && (this->header->flags & MeshFileHeader::HAS_ADJACENCY) != 0;
+    }
+
+    inline std::span<const Node> vertices(void) const noexcept
+    {
+        if(this->header == nullptr)
+            return {};
+        return std::span<const Node>(reinterpret_cast<const Node*>(this->data + this->header->vertexOffset), this->header->vertexCount);
+    }
+
+    inline std::span<const Triple> triangles(void) const noexcept
+    {
+        if(this->header == nullptr)
+            return {};
+        return std::span<const Triple>(reinterpret_cast<const Triple*>(this->data + this->header->triangleOffset), this->header->triangleCount);
+    }
+
+    inline std::span<const Triple> adjacency(void) const noexcept
+    {
+        if(!this->hasAdjacency())
+            return {};
+        return std::span<const Triple>(reinterpret_cast<const Triple*>(this->data + this->header->adjacencyOffset), this->header->triangleCount);
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    bool fail(const std::string& message);
+
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+    const MeshFileHeader* header = nullptr;
+#if defined(_WIN32)
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+    std::string error;
+};
+
+#endif // MESHFILE_H
@@ -0,0 +1,149 @@
+#include "meshrenderer.h"
+
+#include <algorithm>
+
+#include "trace.h"
+
+/// @return the capacity to allocate for count slots, with an eighth to spare for edits that
+/// add slots and at least half again what there was
+static std::size_t grow(std::size_t capacity, std::size_t count) noexcept
+{
+    return count <= capacity ? capacity : std::max(count + count / 8, capacity + capacity / 2);
+}
+
+/// sorts slots and calls upload(first, count) for every run of them at most MERGE_GAP apart
+template <typename Upload>
+static void forEachRun(std::vector<int>& slots, Upload upload)
+{
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    for(std::size_t i = 0; i < slots.size();)
+    {
+        std::size_t j = i + 1;
+        while(j < slots.size() && static_cast<std::size_t>(slots[j] - slots[j - 1]) <= MeshRenderer::MERGE_GAP)
+            j++;
+        upload(static_cast<std::size_t>(slots[i]), static_cast<std::size_t>(slots[j - 1] - slots[i] + 1));
+        i = j;
+    }
+}
+
+void MeshRenderer::create(void)
+{
+    glGenVertexArrays(1, &this->vertexArray);
+    glGenBuffers(1, &this->vertexBuffer);
+    glGenBuffers(1, &this->indexBuffer);
+
+    // the element buffer binding is part of the vertex array state
+    glBindVertexArray(this->vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->indexBuffer);
+    // Position attributes of the mesh vertices
+    // Takes up 2 floats: x and y.
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Node), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+void MeshRenderer::destroy(void)
+{
+    this->track(nullptr);
+    glDeleteBuffers(1, &this->indexBuffer);
+    glDeleteBuffers(1, &this->vertexBuffer);
+    glDeleteVertexArrays(1, &this->vertexArray);
+    this->vertexArray = this->vertexBuffer = this->indexBuffer = 0;
+    this->vertexCount = this->faceCount = 0;
+    this->vertexCapacity = this->faceCapacity = 0;
+}
+
+void MeshRenderer::reserve(std::size_t vertexCount, std::size_t faceCount)
+{
+    TRACE_SCOPE("reserveBuffers");
+    this->vertexCount = vertexCount;
+    this->faceCount = faceCount;
+    this->vertexCapacity = grow(this->vertexCapacity, vertexCount);
+    this->faceCapacity = grow(this->faceCapacity, faceCount);
+
+    // new storage of the same size orphans the old one, which the driver frees once drawn
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, this->vertexCapacity * sizeof(Node), nullptr, GL_DYNAMIC_DRAW);
+    glBindVertexArray(this->vertexArray);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->faceCapacity * sizeof(Indices), nullptr, GL_DYNAMIC_DRAW);
+    glBindVertexArray(0);
+}
+
+void MeshRenderer::setVertices(std::size_t first, std::span<const Node> vertices)
+{
+    if(vertices.empty())
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, this->vertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Node), vertices.size_bytes(), vertices.data());
+}
+
+void MeshRenderer::setFaces(std::size_t first, std::span<const Indices> faces)
+{
+    if(faces.empty())
+        return;
+    glBindVertexArray(this->vertexArray);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * sizeof(Indices), faces.size_bytes(), faces.data());
+    glBindVertexArray(0);
+}
+
+void MeshRenderer::draw(void) const
+{
+    glBindVertexArray(this->vertexArray);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * this->faceCount), GL_UNSIGNED_INT, (void*)0);
+}
+
+void MeshRenderer::format(const Mesh& mesh, std::vector<Indices>* out)
+{
+    TRACE_SCOPE("formatIndices");
+    out->resize(mesh.faces.size());
+    for(std::size_t face = 0; face < mesh.faces.size(); face++)
+        (*out)[face] = indicesOf(mesh, static_cast<int>(face));
+}
+
+void MeshRenderer::track(Mesh* mesh)
+{
+    if(this->mesh != nullptr)
+        this->mesh->removeJournal(&this->journal);
+    this->mesh = mesh;
+    this->journal.reset();
+    if(mesh != nullptr)
+        mesh->addJournal(&this->journal);
+}
+
+void MeshRenderer::update(void)
+{
+    MeshJournal& journal = this->journal;
+    if(this->mesh == nullptr || (!journal.cleared && journal.faces.empty() && journal.vertices.empty()))
+        return;
+
+    TRACE_SCOPE("updateBuffers");
+    const Mesh& mesh = *this->mesh;
+    if(journal.cleared || mesh.vertices.size() > this->vertexCapacity || mesh.faces.size() > this->faceCapacity)
+    {
+        // the storage is new, so all of it goes up
+        this->reserve(mesh.vertices.size(), mesh.faces.size());
+        this->setVertices(0, mesh.vertices);
+        format(mesh, &this->staging);
+        this->setFaces(0, this->staging);
+    }
+    else
+    {
+        // slots appended since fit the capacity and are in the journal like any other
+        this->vertexCount = mesh.vertices.size();
+        this->faceCount = mesh.faces.size();
+        forEachRun(journal.vertices, [&](std::size_t first, std::size_t count)
+        {
+            this->setVertices(first, std::span<const Node>(mesh.vertices).subspan(first, count));
+        });
+        forEachRun(journal.faces, [&](std::size_t first, std::size_t count)
+        {
+            this->staging.resize(count);
+            for(std::size_t i = 0; i < count; i++)
+                this->staging[i] = indicesOf(mesh, static_cast<int>(first + i));
+            this->setFaces(first, this->staging);
+        });
+    }
+    journal.reset();
+}
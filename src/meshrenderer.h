@@ -0,0 +1,102 @@
+#ifndef MESHRENDERER_H
+#define MESHRENDERER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "C:\C++ Libraries\glad\include\glad\glad.h"
+
+#include "node.h"
+#include "mesh.h"
+
+/** The GPU copy of a Mesh, drawn as indexed triangles.
+* The vertex buffer holds the vertex slots of the mesh as they are, two floats each, and the
+* index buffer three indices per face slot, so every vertex is stored once instead of once
+* per triangle using it and a slot of either keeps its place from upload to upload. Free and
+* super faces are written as the degenerate triangle 0 0 0, which draws nothing. The vertex
+* array and buffers are created once; reserve() orphans the storage for the next mesh, so
+* a new upload never waits for the GPU to finish drawing the previous one, and when it is too
+* small grows it by half again, or to an eighth more than the mesh needs. The fragment shader
+* colors every face slot from a hash of gl_PrimitiveID, which is why no color goes into the
+* buffers.
+* A renderer can also track a mesh edited in place: the mesh records the vertex and face
+* slots its updates touch in the journal of the renderer, and update() rewrites only those,
+* in runs of slots at most MERGE_GAP apart, so inserting a point costs the GPU a few dozen
+* bytes instead of a copy of the mesh. */
+class MeshRenderer
+{
+public:
+    typedef std::array<std::uint32_t, 3> Indices;
+
+    /// changed slots this close together go up in one call, the unchanged ones between included
+    static const std::size_t MERGE_GAP = 8;
+
+    MeshRenderer() = default;
+
+    MeshRenderer(const MeshRenderer&) = delete;
+    MeshRenderer& operator = (const MeshRenderer&) = delete;
+
+    /// creates the vertex array and buffers, needs a current context
+    void create(void);
+    /// deletes them, while the context is still current
+    void destroy(void);
+    /// sizes the buffers for a mesh of that many vertex and face slots, dropping their contents
+    void reserve(std::size_t vertexCount, std::size_t faceCount);
+    /// overwrites vertex slots from first on, which have to be within the reserved count
+    void setVertices(std::size_t first, std::span<const Node> vertices);
+    /// overwrites face slots from first on, which have to be within the reserved count
+    void setFaces(std::size_t first, std::span<const Indices> faces);
+    void draw(void) const;
+
+    /// makes mesh record what its updates touch for update(), nullptr stops tracking; the
+    /// buffers have to hold mesh as it is now
+    void track(Mesh* mesh);
+    /// uploads the slots the tracked mesh changed since the last call, all of them if it was
+    /// cleared or outgrew the buffers
+    void update(void);
+
+    /// @return what face slot face of mesh draws, 0 0 0 if nothing
+    static inline Indices indicesOf(const Mesh& mesh, int face) noexcept
+    {
+        const Mesh::Face& f = mesh.faces[face];
+        if(f.v[0] == Mesh::NONE || mesh.isSuperFace(face))
+            return {0, 0, 0};
+        return {static_cast<std::uint32_t>(f.v[0]), static_cast<std::uint32_t>(f.v[1]), static_cast<std::uint32_t>(f.v[2])};
+    }
+
+    /// replaces the contents of out with the indices of every face slot of mesh
+    static void format(const Mesh& mesh, std::vector<Indices>* out);
+
+    inline std::size_t getVertexCount(void) const noexcept
+    {
+        return this->vertexCount;
+    }
+
+    inline std::size_t getFaceCount(void) const noexcept
+    {
+        return this->faceCount;
+    }
+
+    /// @return the bytes of GPU memory the buffers hold
+    inline std::size_t getCapacityBytes(void) const noexcept
+    {
+        return this->vertexCapacity * sizeof(Node) + this->faceCapacity * sizeof(Indices);
+    }
+
+private:
+    Mesh* mesh = nullptr;          // the mesh tracked, if any
+    MeshJournal journal;
+    std::vector<Indices> staging;  // indices of the face slots going up
+    GLuint vertexArray = 0;
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer = 0;
+    std::size_t vertexCount = 0;
+    std::size_t faceCount = 0;
+    std::size_t vertexCapacity = 0; // slots the storage has room for
+    std::size_t faceCapacity = 0;
+};
+
+#endif // MESHRENDERER_H
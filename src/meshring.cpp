@@ -0,0 +1,461 @@
+#include "meshring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "trace.h"
+
+/// the start of a ring, the counters on cache lines of their own
+class RingHeader
+{
+public:
+    static constexpr char MAGIC[8] = {'M', 'E', 'S', 'H', 'R', 'I', 'N', 'G'};
+    static const std::uint32_t VERSION = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t capacity;
+    alignas(64) std::atomic<std::uint64_t> head;
+    alignas(64) std::atomic<std::uint64_t> resyncRequests;
+};
+
+class RingSlot
+{
+public:
+    /// the sequence while the writer is between the words and the sequence
+    static const std::uint64_t BUSY = ~std::uint64_t(0);
+
+    std::atomic<std::uint64_t> sequence; // position + 1 of the record held, 0 before the first
+    std::atomic<std::uint32_t> words[5];
+    std::uint32_t padding;
+};
+
+static const std::size_t SLOTS_OFFSET = sizeof(RingHeader);
+
+static_assert(SLOTS_OFFSET == 192 && sizeof(RingSlot) == 32, "the header and slots are shared between processes");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "atomics in shared memory must not hide a lock");
+
+SharedRing::~SharedRing()
+{
+    this->close();
+}
+
+bool SharedRing::fail(const std::string& message)
+{
+    this->close();
+    this->error = message;
+    return false;
+}
+
+bool SharedRing::create(const char* name, std::uint32_t capacity)
+{
+    this->close();
+    this->error.clear();
+    this->capacity = std::bit_ceil(std::max<std::uint32_t>(capacity, 2));
+    this->size = SLOTS_OFFSET + std::size_t(this->capacity) * sizeof(RingSlot);
+    if(!this->map(name, true))
+        return false;
+
+    // fresh memory reads as zero, every slot already says it holds nothing
+    RingHeader* header = new(this->data) RingHeader();
+    header->version = RingHeader::VERSION;
+    header->capacity = this->capacity;
+    header->head.store(0);
+    header->resyncRequests.store(0);
+    for(std::uint32_t i = 0; i < this->capacity; i++)
+        new(this->data + SLOTS_OFFSET + std::size_t(i) * sizeof(RingSlot)) RingSlot();
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, RingHeader::MAGIC, sizeof(header->magic));
+    this->owner = true;
+    return true;
+}
+
+bool SharedRing::open(const char* name)
+{
+    this->close();
+    this->error.clear();
+    if(!this->map(name, false))
+        return false;
+
+    const RingHeader* header = reinterpret_cast<const RingHeader*>(this->data);
+    if(this->size < SLOTS_OFFSET || std::memcmp(header->magic, RingHeader::MAGIC, sizeof(header->magic)) != 0)
+        return this->fail(std::string(name) + " is not a mesh ring, or not ready yet");
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(header->version != RingHeader::VERSION)
+        return this->fail(std::string(name) + " has unsupported version " + std::to_string(header->version));
+    if(!std::has_single_bit(header->capacity) || this->size < SLOTS_OFFSET + std::size_t(header->capacity) * sizeof(RingSlot))
+        return this->fail(std::string(name) + " is truncated");
+    this->capacity = header->capacity;
+    return true;
+}
+
+#if defined(_WIN32)
+
+bool SharedRing::map(const char* name, bool creating)
+{
+    // named mappings live as long as a handle does, there is nothing to unlink
+    this->name = std::string("Local\\") + (name[0] == '/' ? name + 1 : name);
+    if(creating)
+        this->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(std::uint64_t(this->size) >> 32),
+                                           static_cast<DWORD>(this->size), this->name.c_str());
+    else
+        this->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, this->name.c_str());
+    if(this->mapping == nullptr)
+        return this->fail(std::string("could not ") + (creating ? "create " : "open ") + name);
+    this->data = static_cast<unsigned char*>(MapViewOfFile(this->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    if(this->data == nullptr)
+        return this->fail(std::string("could not map ") + name);
+    if(!creating)
+    {
+        MEMORY_BASIC_INFORMATION region;
+        this->size = VirtualQuery(this->data, &region, sizeof(region)) != 0 ? region.RegionSize : 0;
+    }
+    return true;
+}
+
+void SharedRing::close(void)
+{
+    if(this->data != nullptr)
+        UnmapViewOfFile(this->data);
+    if(this->mapping != nullptr)
+        CloseHandle(this->mapping);
+    this->data = nullptr;
+    this->mapping = nullptr;
+    this->size = 0;
+    this->owner = false;
+}
+
+#else
+
+bool SharedRing::map(const char* name, bool creating)
+{
+    // POSIX names start with a slash
+    this->name = name[0] == '/' ? name : std::string("/") + name;
+    int descriptor;
+    if(creating)
+    {
+        shm_unlink(this->name.c_str());
+        descriptor = shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if(descriptor >= 0 && ftruncate(descriptor, static_cast<off_t>(this->size)) != 0)
+        {
+            ::close(descriptor);
+            shm_unlink(this->name.c_str());
+            return this->fail(std::string("could not size ") + name);
+        }
+    }
+    else
+    {
+        descriptor = shm_open(this->name.c_str(), O_RDWR, 0);
+        struct stat status;
+        if(descriptor >= 0 && fstat(descriptor, &status) != 0)
+            status.st_size = 0;
+        if(descriptor >= 0)
+            this->size = static_cast<std::size_t>(status.st_size);
+    }
+    if(descriptor < 0)
+        return this->fail(std::string("could not ") + (creating ? "create " : "open ") + name);
+    if(this->size == 0)
+    {
+        ::close(descriptor);
+        return this->fail(std::string(name) + " is empty");
+    }
+    void* address = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    ::close(descriptor); // the mapping keeps the memory
+    if(address == MAP_FAILED)
+    {
+        if(creating)
+            shm_unlink(this->name.c_str());
+        return this->fail(std::string("could not map ") + name);
+    }
+    this->data = static_cast<unsigned char*>(address);
+    return true;
+}
+
+void SharedRing::close(void)
+{
+    if(this->data != nullptr)
+        munmap(this->data, this->size);
+    // readers keep their mapping, the name only goes so no new reader finds a dead ring
+    if(this->owner)
+        shm_unlink(this->name.c_str());
+    this->data = nullptr;
+    this->size = 0;
+    this->owner = false;
+}
+
+#endif // _WIN32
+
+void SharedRing::write(std::uint64_t position, const MeshDelta& delta) noexcept
+{
+    RingSlot& slot = reinterpret_cast<RingSlot*>(this->data + SLOTS_OFFSET)[position & (this->capacity - 1)];
+    std::uint32_t words[5];
+    std::memcpy(words, &delta, sizeof(words));
+
+    // a reader copying the slot meanwhile sees BUSY or the new sequence when it checks again
+    slot.sequence.store(RingSlot::BUSY, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for(int i = 0; i < 5; i++)
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    slot.sequence.store(position + 1, std::memory_order_release);
+}
+
+void SharedRing::publish(std::uint64_t head) noexcept
+{
+    reinterpret_cast<RingHeader*>(this->data)->head.store(head, std::memory_order_release);
+}
+
+bool SharedRing::read(std::uint64_t position, MeshDelta* delta) const noexcept
+{
+    const RingSlot& slot = reinterpret_cast<const RingSlot*>(this->data + SLOTS_OFFSET)[position & (this->capacity - 1)];
+    if(slot.sequence.load(std::memory_order_acquire) != position + 1)
+        return false;
+    std::uint32_t words[5];
+    for(int i = 0; i < 5; i++)
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(slot.sequence.load(std::memory_order_relaxed) != position + 1)
+        return false;
+    std::memcpy(delta, words, sizeof(words));
+    return true;
+}
+
+std::uint64_t SharedRing::head(void) const noexcept
+{
+    return reinterpret_cast<const RingHeader*>(this->data)->head.load(std::memory_order_acquire);
+}
+
+void SharedRing::requestResync(void) noexcept
+{
+    reinterpret_cast<RingHeader*>(this->data)->resyncRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t SharedRing::resyncRequests(void) const noexcept
+{
+    return reinterpret_cast<const RingHeader*>(this->data)->resyncRequests.load(std::memory_order_relaxed);
+}
+
+MeshPublisher::~MeshPublisher()
+{
+    this->detach();
+}
+
+bool MeshPublisher::create(const char* name, std::uint32_t capacity)
+{
+    this->position = 0;
+    this->servedRequests = 0;
+    return this->ring.create(name, capacity);
+}
+
+void MeshPublisher::attach(Mesh* mesh)
+{
+    this->detach();
+    this->mesh = mesh;
+    this->journal.reset();
+    // nothing was sent of this mesh yet
+    this->journal.cleared = true;
+    mesh->addJournal(&this->journal);
+}
+
+void MeshPublisher::detach(void)
+{
+    if(this->mesh != nullptr)
+        this->mesh->removeJournal(&this->journal);
+    this->mesh = nullptr;
+}
+
+void MeshPublisher::publish(MeshDelta::Kind kind, int handle, std::uint32_t a, std::uint32_t b, std::uint32_t c)
+{
+    this->ring.write(this->position++, MeshDelta{kind, handle, {a, b, c}});
+    if(this->position % PUBLISH_INTERVAL == 0)
+        this->ring.publish(this->position);
+}
+
+void MeshPublisher::publishVertex(int vertex)
+{
+    const Node& n = this->mesh->vertices[vertex];
+    this->publish(MeshDelta::VERTEX, vertex, std::bit_cast<std::uint32_t>(n.x), std::bit_cast<std::uint32_t>(n.y));
+}
+
+void MeshPublisher::publishFace(int face)
+{
+    // replicas hold the triangulation only, super faces are gone as far as they know
+    if(!this->mesh->isAlive(face) || this->mesh->isSuperFace(face))
+    {
+        this->publish(MeshDelta::REMOVE_FACE, face);
+        return;
+    }
+    const Mesh::Face& f = this->mesh->faces[face];
+    this->publish(MeshDelta::FACE, face, static_cast<std::uint32_t>(f.v[0]), static_cast<std::uint32_t>(f.v[1]),
+                  static_cast<std::uint32_t>(f.v[2]));
+}
+
+void MeshPublisher::publishAll(void)
+{
+    TRACE_SCOPE("publishAll");
+    this->publish(MeshDelta::CLEAR, 0);
+    int vertices = static_cast<int>(this->mesh->vertices.size());
+    for(int v = 3; v < vertices; v++)
+    {
+        if(this->mesh->isVertexAlive(v))
+            this->publishVertex(v);
+    }
+    int faces = static_cast<int>(this->mesh->faces.size());
+    for(int face = 0; face < faces; face++)
+    {
+        if(this->mesh->isAlive(face) && !this->mesh->isSuperFace(face))
+            this->publishFace(face);
+    }
+    this->fullCopies++;
+}
+
+std::size_t MeshPublisher::commit(void)
+{
+    if(this->mesh == nullptr || !this->ring.isOpen())
+        return 0;
+    TRACE_SCOPE("commit");
+    std::uint64_t start = this->position;
+    std::uint64_t requests = this->ring.resyncRequests();
+    if(this->journal.cleared || requests != this->servedRequests)
+    {
+        this->servedRequests = requests;
+        this->publishAll();
+    }
+    else if(!this->journal.faces.empty() || !this->journal.vertices.empty())
+    {
+        // vertices first, the faces sent next may use them
+        for(int vertex : this->journal.vertices)
+            this->publishVertex(vertex);
+
+        if(this->mark.size() < this->mesh->faces.size())
+            this->mark.resize(this->mesh->faces.size(), 0);
+        if(++this->stamp == 0)
+        {
+            std::fill(this->mark.begin(), this->mark.end(), 0);
+            this->stamp = 1;
+        }
+        // a face touched many times is sent once, as it is now
+        for(int face : this->journal.faces)
+        {
+            if(this->mark[face] == this->stamp)
+                continue;
+            this->mark[face] = this->stamp;
+            this->publishFace(face);
+        }
+    }
+    else
+        return 0;
+
+    this->publish(MeshDelta::COMMIT, 0);
+    this->ring.publish(this->position);
+    this->journal.reset();
+    return static_cast<std::size_t>(this->position - start);
+}
+
+bool MeshReplica::open(const char* name)
+{
+    this->vertices.clear();
+    this->faces.clear();
+    this->triangleCount = 0;
+    this->version = 0;
+    if(!this->ring.open(name))
+        return false;
+    // whatever is in the ring already is a tail without its start
+    this->cursor = this->ring.head();
+    this->requestResync();
+    return true;
+}
+
+void MeshReplica::requestResync(void)
+{
+    this->waiting = true;
+    this->consistent = false;
+    this->resyncs++;
+    this->ring.requestResync();
+}
+
+std::size_t MeshReplica::poll(void)
+{
+    if(!this->ring.isOpen())
+        return 0;
+    TRACE_SCOPE("poll");
+    std::uint64_t head = this->ring.head();
+    std::size_t applied = 0;
+    while(this->cursor < head)
+    {
+        MeshDelta delta;
+        if(!this->ring.read(this->cursor, &delta))
+        {
+            // lapped, the records in between are gone and only a full copy helps
+            this->requestResync();
+            this->cursor = head;
+            break;
+        }
+        this->cursor++;
+        if(this->waiting && delta.kind != MeshDelta::CLEAR)
+            continue;
+        this->apply(delta);
+        applied++;
+    }
+    return applied;
+}
+
+void MeshReplica::apply(const MeshDelta& delta)
+{
+    std::size_t handle = static_cast<std::size_t>(delta.handle);
+    switch(delta.kind)
+    {
+    case MeshDelta::CLEAR:
+        this->vertices.clear();
+        this->faces.clear();
+        this->triangleCount = 0;
+        this->waiting = false;
+        this->consistent = false;
+        break;
+    case MeshDelta::VERTEX:
+        if(handle >= this->vertices.size())
+            this->vertices.resize(handle + 1, Node(0.0f, 0.0f));
+        this->vertices[handle] = Node(std::bit_cast<float>(delta.data[0]), std::bit_cast<float>(delta.data[1]));
+        this->consistent = false;
+        break;
+    case MeshDelta::FACE:
+    case MeshDelta::REMOVE_FACE:
+        if(handle >= this->faces.size())
+            this->faces.resize(handle + 1, {Mesh::NONE, Mesh::NONE, Mesh::NONE});
+        this->triangleCount -= this->faces[handle][0] != Mesh::NONE ? 1 : 0;
+        if(delta.kind == MeshDelta::FACE)
+        {
+            this->faces[handle] = {static_cast<int>(delta.data[0]), static_cast<int>(delta.data[1]), static_cast<int>(delta.data[2])};
+            this->triangleCount++;
+        }
+        else
+            this->faces[handle] = {Mesh::NONE, Mesh::NONE, Mesh::NONE};
+        this->consistent = false;
+        break;
+    case MeshDelta::COMMIT:
+        this->consistent = true;
+        this->version++;
+        break;
+    }
+}
+
+void MeshReplica::getTriangles(std::vector<std::array<int, 3>>* out) const
+{
+    for(const std::array<int, 3>& face : this->faces)
+    {
+        if(face[0] != Mesh::NONE)
+            out->push_back(face);
+    }
+}
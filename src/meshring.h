@@ -0,0 +1,231 @@
+#ifndef MESHRING_H
+#define MESHRING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+
+/// one record of a mesh ring, five 32-bit words
+class MeshDelta
+{
+public:
+    enum Kind : std::uint32_t
+    {
+        CLEAR = 1,   // drop everything, a full copy of the mesh follows
+        VERTEX,      // data holds the bits of x and y, a recycled handle overwrites the old vertex
+        FACE,        // data holds the counter-clockwise vertex handles, overwriting the slot
+        REMOVE_FACE, // the slot is empty or became a super face
+        COMMIT       // the records since the previous commit form one update of the mesh
+    };
+
+    std::uint32_t kind;
+    std::int32_t handle; // vertex or face handle
+    std::uint32_t data[3];
+};
+
+static_assert(sizeof(MeshDelta) == 5 * sizeof(std::uint32_t), "a delta fills the words of one ring slot");
+
+/** A ring of MeshDelta records in named shared memory, written by one process and read by any.
+* Layout: a 192 byte header with the capacity, the count of records published so far and a
+* counter replicas bump to ask for a full copy, each counter on a cache line of its own,
+* then capacity slots of 32 bytes. A slot carries the sequence number of its record next to
+* the words, stored after them, so a reader checks it before and after copying and knows
+* when the writer lapped it; neither side ever waits on the other, and a replica too slow
+* for the writer loses records rather than slowing it down. */
+class SharedRing
+{
+public:
+    SharedRing(void) = default;
+    ~SharedRing();
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator = (const SharedRing&) = delete;
+
+    /// creates the ring, replacing one of the same name whose readers keep their old copy
+    /// @return false with getError() set if the shared memory could not be created
+    bool create(const char* name, std::uint32_t capacity);
+    /// opens a ring another process created
+    bool open(const char* name);
+    void close(void);
+
+    /// stores a record, only the writer calls it
+    void write(std::uint64_t position, const MeshDelta& delta) noexcept;
+    /// makes the records before head visible to readers
+    void publish(std::uint64_t head) noexcept;
+    /// @return false if the record at position was overwritten or is not written yet
+    bool read(std::uint64_t position, MeshDelta* delta) const noexcept;
+    /// @return the count of records published
+    std::uint64_t head(void) const noexcept;
+
+    void requestResync(void) noexcept;
+    std::uint64_t resyncRequests(void) const noexcept;
+
+    inline bool isOpen(void) const noexcept
+    {
+        return this->data != nullptr;
+    }
+
+    inline std::uint32_t getCapacity(void) const noexcept
+    {
+        return this->capacity;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    bool map(const char* name, bool creating);
+    bool fail(const std::string& message);
+
+    unsigned char* data = nullptr;
+    std::size_t size = 0;
+    std::uint32_t capacity = 0;
+    std::string name;
+    bool owner = false;
+#if defined(_WIN32)
+    void* mapping = nullptr;
+#endif
+    std::string error;
+};
+
+/** Publishes every update of a Mesh to a SharedRing, so other processes keep a replica.
+* attach() makes the mesh record the faces and vertices its updates touch in a MeshJournal;
+* commit() sends the final state of each touched handle once, a VERTEX for new vertices
+* and a FACE or REMOVE_FACE per face, then a COMMIT. An insertion costs records in
+* proportion to its cavity instead of a copy of the whole mesh. After Mesh::clear() or
+* when a replica asks for it the commit sends a CLEAR and a full copy instead, which every
+* replica applies; commit() often, e.g. once a frame, so those requests are served even
+* while the mesh rests. Long commits are made visible every PUBLISH_INTERVAL records, so
+* replicas follow a copy larger than the ring as it is written; still, the ring should hold a
+* full copy, three records per vertex, or a slow replica may be lapped again while it catches up. */
+class MeshPublisher
+{
+public:
+    static const std::uint32_t DEFAULT_CAPACITY = 1 << 20;
+    static const std::uint64_t PUBLISH_INTERVAL = 1024;
+
+    MeshPublisher(void) = default;
+    ~MeshPublisher();
+
+    MeshPublisher(const MeshPublisher&) = delete;
+    MeshPublisher& operator = (const MeshPublisher&) = delete;
+
+    /// capacity is in records and rounded up to a power of two
+    bool create(const char* name, std::uint32_t capacity = DEFAULT_CAPACITY);
+    /// starts mirroring mesh, which replicas receive in full on the next commit
+    void attach(Mesh* mesh);
+    /// stops recording the attached mesh
+    void detach(void);
+    /// publishes what changed since the last commit
+    /// @return the records published, 0 when nothing changed
+    std::size_t commit(void);
+
+    /// @return the full copies sent, for Mesh::clear() or replica requests
+    inline std::uint64_t getFullCopies(void) const noexcept
+    {
+        return this->fullCopies;
+    }
+
+    inline std::uint64_t getPublished(void) const noexcept
+    {
+        return this->position;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->ring.getError();
+    }
+
+private:
+    void publish(MeshDelta::Kind kind, int handle, std::uint32_t a = 0, std::uint32_t b = 0, std::uint32_t c = 0);
+    void publishVertex(int vertex);
+    void publishFace(int face);
+    void publishAll(void);
+
+    SharedRing ring;
+    Mesh* mesh = nullptr;
+    MeshJournal journal;
+    std::uint64_t position = 0;       // records written
+    std::uint64_t servedRequests = 0; // replica requests answered by a full copy
+    std::uint64_t fullCopies = 0;
+    std::vector<unsigned int> mark;   // faces already sent by this commit
+    unsigned int stamp = 0;
+};
+
+/** A copy of a published mesh kept up to date from its SharedRing.
+* poll() applies the records published since the last call. A new replica, or one the
+* publisher lapped, asks for a full copy and skips records until its CLEAR arrives. Faces
+* are kept by publisher handle, an empty slot starts with Mesh::NONE, and vertices by handle;
+* both only hold what the mesh had at a commit once isConsistent() holds. A replica of a
+* publisher that restarted sees nothing new until it is opened again. */
+class MeshReplica
+{
+public:
+    bool open(const char* name);
+    /// @return the records applied
+    std::size_t poll(void);
+
+    /// appends the triangles of the replica, see Mesh::getTriangles
+    void getTriangles(std::vector<std::array<int, 3>>* out) const;
+
+    /// @return true if the replica ends at a commit of the publisher and is not waiting for a copy
+    inline bool isConsistent(void) const noexcept
+    {
+        return this->consistent;
+    }
+
+    /// @return the commits applied, a renderer redraws when it changes
+    inline std::uint64_t getVersion(void) const noexcept
+    {
+        return this->version;
+    }
+
+    inline const std::vector<Node>& getVertices(void) const noexcept
+    {
+        return this->vertices;
+    }
+
+    inline const std::vector<std::array<int, 3>>& getFaces(void) const noexcept
+    {
+        return this->faces;
+    }
+
+    inline std::size_t getTriangleCount(void) const noexcept
+    {
+        return this->triangleCount;
+    }
+
+    /// @return the full copies requested, after opening or being lapped
+    inline std::uint64_t getResyncs(void) const noexcept
+    {
+        return this->resyncs;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->ring.getError();
+    }
+
+private:
+    void requestResync(void);
+    void apply(const MeshDelta& delta);
+
+    SharedRing ring;
+    std::uint64_t cursor = 0;
+    bool waiting = true;
+    bool consistent = false;
+    std::uint64_t version = 0;
+    std::uint64_t resyncs = 0;
+    std::vector<Node> vertices;
+    std::vector<std::array<int, 3>> faces;
+    std::size_t triangleCount = 0;
+};
+
+#endif // MESHRING_H
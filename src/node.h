@@ -5,14 +5,14 @@ class Node
 {
 public:
     Node() = default;
-    Node(float x_, float y_) : x(x_), y(y_) {}
+    constexpr Node(float x_, float y_) : x(x_), y(y_) {}
 
-    inline friend bool operator == (const Node& p, const Node& q) noexcept
+    constexpr friend bool operator == (const Node& p, const Node& q) noexcept
     {
         return (p.x == q.x) && (p.y == q.y);
     }
 
-    inline friend bool operator != (const Node& p, const Node& q) noexcept
+    constexpr friend bool operator != (const Node& p, const Node& q) noexcept
     {
         return (p.x != q.x) || (p.y != q.y);
     }
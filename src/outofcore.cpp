@@ -0,0 +1,352 @@
+#include "outofcore.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <limits>
+
+#include "streamingtriangulator.h"
+#include "trace.h"
+
+static_assert(sizeof(Node) == 2 * sizeof(float), "input blocks are copied to the vertex array as they are");
+
+/// the smallest write buffer of a bucket row, below it spilling turns into many small writes
+static const std::size_t MIN_ROW_RECORDS = 4096;
+
+std::ostream& operator << (std::ostream& out, const IoPhase& phase)
+{
+    return out << phase.name << ": " << phase.bytesRead << " bytes read, " << phase.bytesWritten << " bytes written in "
+               << phase.seconds << " s";
+}
+
+/// measures a phase from construction to destruction
+class PhaseClock
+{
+public:
+    explicit PhaseClock(IoPhase* phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+
+    ~PhaseClock()
+    {
+        this->phase->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+    }
+
+private:
+    IoPhase* phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+static bool writeBytes(std::FILE* file, const void* bytes, std::size_t count, IoPhase* phase)
+{
+    phase->bytesWritten += count;
+    return count == 0 || std::fwrite(bytes, 1, count, file) == count;
+}
+
+static bool writeZeros(std::FILE* file, std::uint64_t count, IoPhase* phase)
+{
+    static const char ZEROS[MeshFileHeader::ALIGNMENT] = {};
+    for(; count > 0; count -= std::min<std::uint64_t>(count, sizeof(ZEROS)))
+    {
+        if(!writeBytes(file, ZEROS, static_cast<std::size_t>(std::min<std::uint64_t>(count, sizeof(ZEROS))), phase))
+            return false;
+    }
+    return true;
+}
+
+OutOfCoreTriangulator::OutOfCoreTriangulator(const std::filesystem::path& directory, int columns, int rows)
+    : directory(directory), columns(std::max(columns, 1)), rows(std::max(rows, 1))
+{
+}
+
+bool OutOfCoreTriangulator::run(const char* inputPath, const char* outputPath)
+{
+    Source source;
+    source.path = inputPath;
+    return this->run(source, outputPath);
+}
+
+bool OutOfCoreTriangulator::run(std::span<const Node> nodes, const char* outputPath)
+{
+    Source source;
+    source.nodes = nodes;
+    return this->run(source, outputPath);
+}
+
+bool OutOfCoreTriangulator::fail(const std::string& message)
+{
+    this->error = message;
+    return false;
+}
+
+std::filesystem::path OutOfCoreTriangulator::spillPath(int row) const
+{
+    return this->directory / ("row-" + std::to_string(row) + ".spill");
+}
+
+void OutOfCoreTriangulator::removeSpills(void)
+{
+    std::error_code code;
+    for(int row = 0; row < this->rows; row++)
+        std::filesystem::remove(this->spillPath(row), code);
+}
+
+template <typename Visit>
+bool OutOfCoreTriangulator::readBlocks(const Source& source, IoPhase* phase, Visit visit)
+{
+    const std::size_t blockNodes = BLOCK_SIZE / sizeof(Node);
+    if(source.path == nullptr)
+    {
+        // a mapped input is paged in by the same sequential pass
+        for(std::size_t first = 0; first < source.nodes.size(); first += blockNodes)
+        {
+            std::span<const Node> nodes = source.nodes.subspan(first, std::min(blockNodes, source.nodes.size() - first));
+            phase->bytesRead += nodes.size_bytes();
+            if(!visit(nodes, static_cast<std::uint64_t>(first)))
+                return false;
+        }
+        return true;
+    }
+
+    std::error_code code;
+    std::uintmax_t bytes = std::filesystem::file_size(source.path, code);
+    if(code)
+        return this->fail(std::string("could not open ") + source.path);
+    if(bytes % sizeof(Node) != 0)
+        return this->fail(std::string(source.path) + " does not hold whole x, y pairs");
+    std::FILE* file = std::fopen(source.path, "rb");
+    if(file == nullptr)
+        return this->fail(std::string("could not open ") + source.path);
+
+    this->block.resize(blockNodes);
+    std::uint64_t first = 0;
+    bool ok = true;
+    while(ok && first < bytes / sizeof(Node))
+    {
+        std::size_t got = std::fread(this->block.data(), sizeof(Node), blockNodes, file);
+        if(got == 0)
+        {
+            ok = this->fail(std::string("could not read ") + source.path);
+            break;
+        }
+        phase->bytesRead += got * sizeof(Node);
+        ok = visit(std::span<const Node>(this->block.data(), got), first);
+        first += got;
+    }
+    std::fclose(file);
+    std::vector<Node>().swap(this->block);
+    return ok;
+}
+
+bool OutOfCoreTriangulator::scan(const Source& source)
+{
+    TRACE_SCOPE("scan");
+    IoPhase& phase = this->phases.emplace_back();
+    phase.name = "scan";
+    PhaseClock clock(&phase);
+
+    float inf = std::numeric_limits<float>::infinity();
+    this->minCorner = Node(inf, inf);
+    this->maxCorner = Node(-inf, -inf);
+    this->count = 0;
+    bool ok = this->readBlocks(source, &phase, [&](std::span<const Node> nodes, std::uint64_t)
+    {
+        for(const Node& n : nodes)
+        {
+            if(!std::isfinite(n.x) || !std::isfinite(n.y))
+                continue;
+            this->minCorner = Node(std::min(this->minCorner.x, n.x), std::min(this->minCorner.y, n.y));
+            this->maxCorner = Node(std::max(this->maxCorner.x, n.x), std::max(this->maxCorner.y, n.y));
+        }
+        this->count += nodes.size();
+        return true;
+    });
+    if(this->minCorner.x > this->maxCorner.x)
+        this->minCorner = this->maxCorner = Node(0.0f, 0.0f); // nothing finite, any grid will do
+    return ok;
+}
+
+bool OutOfCoreTriangulator::flushRow(int row, IoPhase* phase)
+{
+    std::vector<Record>& records = this->pending[row];
+    if(records.empty())
+        return true;
+    // opened per flush, so the number of rows is not bounded by the open file limit
+    std::FILE* file = std::fopen(this->spillPath(row).string().c_str(), "ab");
+    if(file == nullptr)
+        return this->fail("could not write " + this->spillPath(row).string());
+    bool ok = writeBytes(file, records.data(), records.size() * sizeof(Record), phase);
+    ok = std::fclose(file) == 0 && ok;
+    this->spilled[row] += records.size();
+    records.clear();
+    return ok || this->fail("could not write " + this->spillPath(row).string());
+}
+
+bool OutOfCoreTriangulator::partition(const Source& source, const StreamingTriangulator& streaming, std::FILE* output)
+{
+    TRACE_SCOPE("partition");
+    IoPhase& phase = this->phases.emplace_back();
+    phase.name = "partition";
+    PhaseClock clock(&phase);
+
+    // the row buffers share one block between them
+    std::size_t capacity = std::max(BLOCK_SIZE / sizeof(Record) / this->rows, MIN_ROW_RECORDS);
+    this->pending.assign(this->rows, std::vector<Record>());
+    for(std::vector<Record>& records : this->pending)
+        records.reserve(capacity);
+    this->spilled.assign(this->rows, 0);
+
+    MeshFileHeader placeholder{};
+    bool ok = writeBytes(output, &placeholder, sizeof(placeholder), &phase)
+        && this->readBlocks(source, &phase, [&](std::span<const Node> nodes, std::uint64_t first)
+    {
+        // input order is vertex order, so the block goes to the output as it is
+        if(!writeBytes(output, nodes.data(), nodes.size_bytes(), &phase))
+            return this->fail("could not write the vertices");
+        for(std::size_t i = 0; i < nodes.size(); i++)
+        {
+            int cell = streaming.cellOf(nodes[i]);
+            if(cell == Mesh::NONE)
+            {
+                this->rejected++;
+                continue;
+            }
+            int row = cell / this->columns;
+            this->pending[row].push_back(Record{nodes[i], first + i});
+            if(this->pending[row].size() >= capacity && !this->flushRow(row, &phase))
+                return false;
+        }
+        return true;
+    });
+    for(int row = 0; ok && row < this->rows; row++)
+        ok = this->flushRow(row, &phase);
+    std::vector<std::vector<Record>>().swap(this->pending);
+
+    MeshFileHeader header = MeshFile::layout(this->count, 0, false);
+    return ok && (writeZeros(output, header.triangleOffset - header.vertexOffset - this->count * sizeof(Node), &phase)
+                  || this->fail("could not write the vertices"));
+}
+
+bool OutOfCoreTriangulator::flushTriangles(std::FILE* output, IoPhase* phase)
+{
+    bool ok = writeBytes(output, this->triangles.data(), this->triangles.size() * sizeof(MeshFile::Triple), phase);
+    this->triangleCount += this->triangles.size();
+    this->triangles.clear();
+    return ok || this->fail("could not write the triangles");
+}
+
+bool OutOfCoreTriangulator::triangulate(StreamingTriangulator& streaming, std::FILE* output)
+{
+    TRACE_SCOPE("triangulate");
+    IoPhase& phase = this->phases.emplace_back();
+    phase.name = "triangulate";
+    PhaseClock clock(&phase);
+
+    const std::size_t blockTriangles = BLOCK_SIZE / sizeof(MeshFile::Triple);
+    std::vector<Record> records;
+    std::vector<std::size_t> start(this->columns + 1);
+    std::vector<std::uint64_t> order;
+    for(int row = 0; row < this->rows; row++)
+    {
+        // the whole row is read in blocks, then sorted into its buckets
+        records.resize(static_cast<std::size_t>(this->spilled[row]));
+        if(!records.empty())
+        {
+            std::string path = this->spillPath(row).string();
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            if(file == nullptr)
+                return this->fail("could not open " + path);
+            const std::size_t blockRecords = BLOCK_SIZE / sizeof(Record);
+            std::size_t done = 0;
+            while(done < records.size())
+            {
+                std::size_t got = std::fread(records.data() + done, sizeof(Record), std::min(blockRecords, records.size() - done), file);
+                if(got == 0)
+                    break;
+                done += got;
+            }
+            std::fclose(file);
+            phase.bytesRead += done * sizeof(Record);
+            if(done < records.size())
+                return this->fail("could not read " + path);
+            std::error_code code;
+            std::filesystem::remove(path, code);
+        }
+
+        std::fill(start.begin(), start.end(), 0);
+        for(const Record& r : records)
+            start[streaming.cellOf(r.node) % this->columns + 1]++;
+        for(int c = 0; c < this->columns; c++)
+            start[c + 1] += start[c];
+        order.resize(records.size());
+        std::vector<std::size_t> fill(start.begin(), start.end() - 1);
+        for(std::size_t k = 0; k < records.size(); k++)
+            order[fill[streaming.cellOf(records[k].node) % this->columns]++] = k;
+
+        for(int c = 0; c < this->columns; c++)
+        {
+            for(std::size_t k = start[c]; k < start[c + 1]; k++)
+                streaming.insert(records[order[k]].node, records[order[k]].id);
+            streaming.finalize(row * this->columns + c);
+            if(this->triangles.size() >= blockTriangles && !this->flushTriangles(output, &phase))
+                return false;
+        }
+    }
+    std::vector<Record>().swap(records);
+    streaming.finish();
+    this->peakFaces = streaming.getPeakFaces();
+    if(!this->flushTriangles(output, &phase))
+        return false;
+    std::vector<MeshFile::Triple>().swap(this->triangles);
+
+    // the triangle count is known only now, so the header goes in last
+    MeshFileHeader header = MeshFile::layout(this->count, this->triangleCount, false);
+    std::uint64_t end = header.triangleOffset + this->triangleCount * sizeof(MeshFile::Triple);
+    bool ok = writeZeros(output, header.fileSize - end, &phase) && std::fseek(output, 0, SEEK_SET) == 0
+        && writeBytes(output, &header, sizeof(header), &phase);
+    return ok || this->fail("could not write the header");
+}
+
+bool OutOfCoreTriangulator::run(const Source& source, const char* outputPath)
+{
+    TRACE_SCOPE("outOfCoreTriangulate");
+    this->phases.clear();
+    this->phases.reserve(3);
+    this->error.clear();
+    this->triangleCount = 0;
+    this->rejected = 0;
+    this->peakFaces = 0;
+    if constexpr(std::endian::native != std::endian::little)
+        return this->fail("mesh files can only be written on little-endian hosts");
+
+    std::error_code code;
+    std::filesystem::create_directories(this->directory, code);
+    if(code)
+        return this->fail("could not create " + this->directory.string());
+    if(!this->scan(source))
+        return false;
+    if(this->count > static_cast<std::uint64_t>(INT_MAX))
+        return this->fail("more points than a mesh file can index");
+
+    std::FILE* output = std::fopen(outputPath, "wb");
+    if(output == nullptr)
+        return this->fail(std::string("could not create ") + outputPath);
+    // spill files of an earlier run would be appended to
+    this->removeSpills();
+
+    StreamingTriangulator streaming(this->minCorner, this->maxCorner, this->columns, this->rows, [this](const StreamTriangle& t)
+    {
+        this->triangles.push_back({static_cast<int>(t.id[0]), static_cast<int>(t.id[1]), static_cast<int>(t.id[2])});
+    });
+    bool ok = this->partition(source, streaming, output) && this->triangulate(streaming, output);
+    ok = std::fclose(output) == 0 && ok;
+    this->removeSpills();
+    this->triangles.clear();
+    if(!ok)
+    {
+        if(this->error.empty())
+            this->error = std::string("could not write ") + outputPath;
+        std::remove(outputPath);
+    }
+    return ok;
+}
@@ -0,0 +1,137 @@
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "node.h"
+#include "meshfile.h"
+
+class StreamingTriangulator;
+
+/// bytes one phase of an out-of-core run moved through files, and the time it took
+class IoPhase
+{
+public:
+    const char* name = "";
+    std::uint64_t bytesRead = 0;
+    std::uint64_t bytesWritten = 0;
+    double seconds = 0.0;
+
+    friend std::ostream& operator << (std::ostream& out, const IoPhase& phase);
+};
+
+/** Triangulates point sets larger than memory into a mesh file (see MeshFile).
+* The bounds are split into a grid of buckets and the run makes three sequential passes:
+*   scan         reads the input once for its bounds and point count
+*   partition    reads it again, copies every point into the vertex array of the output
+*                and appends it with its input position to the spill file of its bucket row
+*   triangulate  reads the spill files back row by row, sorts each row into its buckets and
+*                streams them through a StreamingTriangulator, finalizing every bucket after
+*                its last point; finished triangles are appended to the output as they leave
+* then writes the header. Reads and triangle writes move BLOCK_SIZE bytes at a time, the bucket
+* rows share one BLOCK_SIZE write buffer, and a spill file is deleted as soon as its row is in.
+* Triangles crossing a bucket boundary stay on the frontier of the streaming triangulator
+* until every bucket their circumcircle touches is in, so that frontier is the overlap
+* between buckets and stitching them needs no extra pass:
+* the output is the Delaunay triangulation of the whole input, degenerate input included,
+* and equal points are triangulated once with the later copies left unused in the file.
+* Memory holds one bucket row of points plus the frontier, which spans about a row too, so
+* rows is chosen so that n / rows points fit comfortably. Vertex indices are input
+* positions and the file stores them as int32, which bounds n to 2^31 - 1. */
+class OutOfCoreTriangulator
+{
+public:
+    static const std::size_t BLOCK_SIZE = 1 << 24;
+
+    /// spill files go to directory, which is created if it does not exist
+    OutOfCoreTriangulator(const std::filesystem::path& directory, int columns, int rows);
+
+    /// triangulates a binary point file, raw little-endian float32 x, y pairs (see PointReader)
+    /// @return false with getError() set if a file could not be read or written
+    bool run(const char* inputPath, const char* outputPath);
+    /// nodes may be a mapping, e.g. MeshFile::vertices(), it is only ever read front to back
+    bool run(std::span<const Node> nodes, const char* outputPath);
+
+    /// @return the phases of the last run in order, with the bytes each one read and wrote
+    inline const std::vector<IoPhase>& getPhases(void) const noexcept
+    {
+        return this->phases;
+    }
+
+    inline std::uint64_t getTriangleCount(void) const noexcept
+    {
+        return this->triangleCount;
+    }
+
+    /// @return the input points that were not finite
+    inline std::uint64_t getRejected(void) const noexcept
+    {
+        return this->rejected;
+    }
+
+    /// @return the most faces the streaming triangulator held at once
+    inline std::size_t getPeakFaces(void) const noexcept
+    {
+        return this->peakFaces;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    /// a point in a spill file, id is its position in the input
+    class Record
+    {
+    public:
+        Node node;
+        std::uint64_t id;
+    };
+
+    /// where the points come from, a file read in blocks or nodes already addressable
+    class Source
+    {
+    public:
+        const char* path = nullptr;
+        std::span<const Node> nodes;
+    };
+
+    bool run(const Source& source, const char* outputPath);
+    /// hands the input to visit in blocks of at most BLOCK_SIZE bytes, with the position of their first point
+    template <typename Visit>
+    bool readBlocks(const Source& source, IoPhase* phase, Visit visit);
+    bool scan(const Source& source);
+    bool partition(const Source& source, const StreamingTriangulator& streaming, std::FILE* output);
+    bool triangulate(StreamingTriangulator& streaming, std::FILE* output);
+    bool flushRow(int row, IoPhase* phase);
+    bool flushTriangles(std::FILE* output, IoPhase* phase);
+    std::filesystem::path spillPath(int row) const;
+    void removeSpills(void);
+    bool fail(const std::string& message);
+
+    std::filesystem::path directory;
+    int columns, rows;
+
+    Node minCorner, maxCorner;
+    std::uint64_t count = 0;
+    std::vector<Node> block;                  // input block when reading from a file
+    std::vector<std::vector<Record>> pending; // per bucket row, records not yet spilled
+    std::vector<std::uint64_t> spilled;       // per bucket row, records in its spill file
+    std::vector<MeshFile::Triple> triangles;  // emitted, not yet written
+
+    std::vector<IoPhase> phases;
+    std::uint64_t triangleCount = 0;
+    std::uint64_t rejected = 0;
+    std::size_t peakFaces = 0;
+    std::string error;
+};
+
+#endif // OUTOFCORE_H
@@ -0,0 +1,277 @@
+#include "pointreader.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "meshfile.h"
+#include "trace.h"
+
+static_assert(sizeof(Node) == 2 * sizeof(float), "binary files map straight onto Node arrays");
+
+/// pieces per worker, so a piece full of long lines does not hold up the whole block
+static const unsigned int PIECES_PER_WORKER = 4;
+
+static inline bool isSeparator(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == ',' || c == ';';
+}
+
+static inline bool isFinite(const Node& n) noexcept
+{
+    return std::isfinite(n.x) && std::isfinite(n.y);
+}
+
+/**==============================================
+*@return how many nodes with a NaN or infinite coordinate were removed from nodes */
+static std::size_t dropNonFinite(std::vector<Node>* nodes)
+{
+    return static_cast<std::size_t>(std::erase_if(*nodes, [](const Node& n) { return !isFinite(n); }));
+}
+
+static inline const char* parseNumber(const char* p, const char* end, float* value) noexcept
+{
+    if(p < end && *p == '+')
+        p++; // from_chars only accepts a minus sign
+    std::from_chars_result result = std::from_chars(p, end, *value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+/**==============================================
+*@return 1 if [p, end) starts with two finite numbers, 0 for a blank line and -1 for anything else */
+static inline int parseLine(const char* p, const char* end, Node* node) noexcept
+{
+    while(p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    if(p == end || *p == '\r')
+        return 0;
+    p = parseNumber(p, end, &node->x);
+    if(p == nullptr || p == end || !isSeparator(*p))
+        return -1;
+    while(p < end && isSeparator(*p))
+        p++;
+    // from_chars takes "nan" and "inf", which no engine can insert
+    return parseNumber(p, end, &node->y) != nullptr && isFinite(*node) ? 1 : -1;
+}
+
+/// swaps the bytes of every coordinate on big-endian hosts, the file order is little-endian
+static inline void toLittleEndian(Node* nodes, std::size_t count) noexcept
+{
+    if constexpr(std::endian::native == std::endian::big)
+    {
+        for(std::size_t i = 0; i < count; i++)
+        {
+            std::uint32_t x = std::bit_cast<std::uint32_t>(nodes[i].x), y = std::bit_cast<std::uint32_t>(nodes[i].y);
+            x = (x >> 24) | ((x >> 8) & 0xff00u) | ((x << 8) & 0xff0000u) | (x << 24);
+            y = (y >> 24) | ((y >> 8) & 0xff00u) | ((y << 8) & 0xff0000u) | (y << 24);
+            nodes[i] = Node(std::bit_cast<float>(x), std::bit_cast<float>(y));
+        }
+    }
+    else
+    {
+        (void)nodes;
+        (void)count;
+    }
+}
+
+PointReader::PointReader(unsigned int threadCount)
+    : pool(threadCount), pieces(pool.size() * PIECES_PER_WORKER)
+{
+}
+
+bool PointReader::read(const char* path, std::vector<Node>* out)
+{
+    if(std::string_view(path).ends_with(".bin"))
+        return this->readBinary(path, out);
+    if(std::string_view(path).ends_with(".mesh"))
+    {
+        MeshFile file;
+        if(!file.open(path))
+        {
+            this->error = file.getError();
+            return false;
+        }
+        out->assign(file.vertices().begin(), file.vertices().end());
+        this->skippedLines = dropNonFinite(out);
+        return true;
+    }
+    return this->readText(path, out);
+}
+
+void PointReader::parseBlock(const char* begin, const char* end, std::vector<Node>* out)
+{
+    TRACE_SCOPE("parseBlock");
+    // cut at the first line end after each even split, the pieces then hold whole lines
+    std::size_t count = this->pieces.size();
+    const char* cut = begin;
+    for(std::size_t k = 0; k < count; k++)
+    {
+        Piece& piece = this->pieces[k];
+        piece.begin = cut;
+        const char* target = begin + (end - begin) * (k + 1) / count;
+        if(target < cut)
+            target = cut;
+        const char* newline = k + 1 == count ? nullptr : static_cast<const char*>(std::memchr(target, '\n', end - target));
+        cut = newline != nullptr ? newline + 1 : end;
+        piece.end = cut;
+    }
+
+    this->pool.parallelFor(count, 1, [&](std::size_t first, std::size_t last, unsigned int)
+    {
+        for(std::size_t k = first; k < last; k++)
+        {
+            Piece& piece = this->pieces[k];
+            piece.nodes.clear();
+            piece.skipped = 0;
+            for(const char* p = piece.begin; p < piece.end; )
+            {
+                const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', piece.end - p));
+                if(lineEnd == nullptr)
+                    lineEnd = piece.end;
+                Node node;
+                int parsed = parseLine(p, lineEnd, &node);
+                if(parsed > 0)
+                    piece.nodes.push_back(node);
+                else if(parsed < 0)
+                    piece.skipped++;
+                p = lineEnd + 1;
+            }
+        }
+    });
+
+    for(const Piece& piece : this->pieces)
+    {
+        out->insert(out->end(), piece.nodes.begin(), piece.nodes.end());
+        this->skippedLines += piece.skipped;
+    }
+}
+
+void PointReader::parseText(std::string_view text, std::vector<Node>* out)
+{
+    out->clear();
+    this->skippedLines = 0;
+    this->parseBlock(text.data(), text.data() + text.size(), out);
+}
+
+bool PointReader::readText(const char* path, std::vector<Node>* out)
+{
+    TRACE_SCOPE("readText");
+    out->clear();
+    this->skippedLines = 0;
+    this->error.clear();
+
+    std::FILE* file = std::fopen(path, "rb");
+    if(file == nullptr)
+    {
+        this->error = std::string("could not open ") + path;
+        return false;
+    }
+
+    std::size_t carry = 0; // bytes of an unfinished line kept at the front of the buffer
+    while(true)
+    {
+        // a line longer than a block grows the buffer rather than being split
+        if(this->buffer.size() < carry + BLOCK_SIZE)
+            this->buffer.resize(carry + BLOCK_SIZE);
+        char* data = this->buffer.data();
+        std::size_t got = std::fread(data + carry, 1, BLOCK_SIZE, file);
+        std::size_t size = carry + got;
+        if(got == 0)
+        {
+            this->parseBlock(data, data + size, out);
+            break;
+        }
+
+        const char* last = data + size;
+        while(last > data && last[-1] != '\n')
+            last--;
+        if(last == data)
+        {
+            carry = size;
+            continue;
+        }
+        this->parseBlock(data, last, out);
+        carry = data + size - last;
+        std::memmove(data, last, carry);
+    }
+
+    bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if(failed)
+        this->error = std::string("could not read ") + path;
+    return !failed;
+}
+
+bool PointReader::readBinary(const char* path, std::vector<Node>* out)
+{
+    TRACE_SCOPE("readBinary");
+    out->clear();
+    this->skippedLines = 0;
+    this->error.clear();
+
+    std::error_code code;
+    std::uintmax_t bytes = std::filesystem::file_size(path, code);
+    if(code)
+    {
+        this->error = std::string("could not open ") + path;
+        return false;
+    }
+    if(bytes % sizeof(Node) != 0)
+    {
+        this->error = std::string(path) + " does not hold whole x, y pairs";
+        return false;
+    }
+    std::FILE* file = std::fopen(path, "rb");
+    if(file == nullptr)
+    {
+        this->error = std::string("could not open ") + path;
+        return false;
+    }
+
+    // no staging buffer, the file is read in blocks straight into the nodes
+    out->resize(static_cast<std::size_t>(bytes / sizeof(Node)));
+    char* data = reinterpret_cast<char*>(out->data());
+    std::size_t done = 0;
+    while(done < bytes)
+    {
+        std::size_t got = std::fread(data + done, 1, std::min<std::size_t>(BLOCK_SIZE, bytes - done), file);
+        if(got == 0)
+            break;
+        done += got;
+    }
+    std::fclose(file);
+    if(done < bytes)
+    {
+        out->clear();
+        this->error = std::string("could not read ") + path;
+        return false;
+    }
+    toLittleEndian(out->data(), out->size());
+    this->skippedLines = dropNonFinite(out);
+    return true;
+}
+
+bool PointReader::writeBinary(const char* path, std::span<const Node> nodes)
+{
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return false;
+
+    std::size_t written;
+    if constexpr(std::endian::native == std::endian::big)
+    {
+        std::vector<Node> swapped(nodes.begin(), nodes.end());
+        toLittleEndian(swapped.data(), swapped.size());
+        written = std::fwrite(swapped.data(), sizeof(Node), swapped.size(), file);
+    }
+    else
+        written = std::fwrite(nodes.data(), sizeof(Node), nodes.size(), file);
+
+    bool failed = std::fclose(file) != 0;
+    return !failed && written == nodes.size();
+}
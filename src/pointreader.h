@@ -0,0 +1,72 @@
+#ifndef POINTREADER_H
+#define POINTREADER_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "node.h"
+#include "threadpool.h"
+
+/** Reads point sets from files straight into Node arrays.
+* Text files (CSV, XYZ) are streamed in blocks of BLOCK_SIZE bytes: each block is cut
+* at line ends into pieces that the pool parses in parallel with std::from_chars, and
+* the partial line at its end is carried over to the next block, so memory stays at one
+* block plus the output and no line is ever copied into a string. Binary files are raw
+* little-endian float32 x, y pairs with no header and are read directly into the output.
+* Points with a NaN or infinite coordinate are dropped, no engine can insert them. */
+class PointReader
+{
+public:
+    static const std::size_t BLOCK_SIZE = 1 << 24;
+
+    explicit PointReader(unsigned int threadCount = std::thread::hardware_concurrency());
+
+    /// reads files ending in .bin as binary, the vertices of .mesh files (see MeshFile) and anything else as text
+    /// @return false with getError() set if the file could not be read
+    bool read(const char* path, std::vector<Node>* out);
+    /// one point per line, x and y are the first two numbers separated by spaces, tabs, commas or
+    /// semicolons; further columns such as z are ignored and lines not starting with a number skipped
+    bool readText(const char* path, std::vector<Node>* out);
+    bool readBinary(const char* path, std::vector<Node>* out);
+    /// parses text already in memory, the last line needs no line end
+    void parseText(std::string_view text, std::vector<Node>* out);
+
+    static bool writeBinary(const char* path, std::span<const Node> nodes);
+
+    /// @return the lines of the last read that held no finite point, headers and comments
+    /// included, or the binary and .mesh points dropped for a NaN or infinite coordinate
+    inline std::size_t getSkippedLines(void) const noexcept
+    {
+        return this->skippedLines;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    class alignas(64) Piece
+    {
+    public:
+        const char* begin;
+        const char* end;
+        std::vector<Node> nodes;
+        std::size_t skipped;
+    };
+
+    /// parses [begin, end), which must hold whole lines, and appends its points to out
+    void parseBlock(const char* begin, const char* end, std::vector<Node>* out);
+
+    ThreadPool pool;
+    std::vector<Piece> pieces;
+    std::vector<char> buffer;
+    std::size_t skippedLines = 0;
+    std::string error;
+};
+
+#endif // POINTREADER_H
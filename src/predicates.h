@@ -0,0 +1,219 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include "node.h"
+#include "stats.h"
+
+/** Robust orientation and in-circle tests.
+* Both predicates are evaluated in double precision first; only when the result
+* is smaller than the forward error bound is the determinant recomputed exactly
+* using floating point expansions (Shewchuk, "Adaptive Precision Floating-Point
+* Arithmetic and Fast Robust Geometric Predicates", 1997). Everything here is
+* constexpr, so fixed point sets can be triangulated at compile time. */
+namespace predicates
+{
+    typedef std::vector<double> Expansion;
+
+    static constexpr double EPSILON = 1.1102230246251565e-16; // 2^-53
+    static constexpr double ORIENT_ERRBOUND = (3.0 + 16.0 * EPSILON) * EPSILON;
+    static constexpr double INCIRCLE_ERRBOUND = (10.0 + 96.0 * EPSILON) * EPSILON;
+
+    /// x + y == a + b exactly, x is the rounded sum
+    static constexpr void twoSum(double a, double b, double& x, double& y) noexcept
+    {
+        x = a + b;
+        double bVirtual = x - a;
+        double aVirtual = x - bVirtual;
+        y = (a - aVirtual) + (b - bVirtual);
+    }
+
+    static constexpr double SPLITTER = 134217729.0; // 2^27 + 1
+
+    /// |a|, std::abs is not constexpr before C++23 but compiles to a single mask at run time
+    static constexpr double absolute(double a) noexcept
+    {
+        if(std::is_constant_evaluated())
+            return a < 0.0 ? -a : a;
+        return std::abs(a);
+    }
+
+    /// hi + lo == a, both halves fit in 26 bits
+    static constexpr void split(double a, double& hi, double& lo) noexcept
+    {
+        double c = SPLITTER * a;
+        hi = c - (c - a);
+        lo = a - hi;
+    }
+
+    /// x + y == a * b exactly, x is the rounded product
+    static constexpr void twoProduct(double a, double b, double& x, double& y) noexcept
+    {
+        x = a * b;
+        if(!std::is_constant_evaluated())
+        {
+            y = std::fma(a, b, -x);
+            return;
+        }
+        // std::fma is not constexpr, fall back to Dekker's product
+        double aHi = 0.0, aLo = 0.0, bHi = 0.0, bLo = 0.0;
+        split(a, aHi, aLo);
+        split(b, bHi, bLo);
+        y = aLo * bLo - (((x - aHi * bHi) - aLo * bHi) - aHi * bLo);
+    }
+
+    /**==============================================
+    *@return e + b, with zero components removed */
+    static constexpr Expansion grow(const Expansion& e, double b)
+    {
+        Expansion h;
+        h.reserve(e.size() + 1);
+        double q = b, hh = 0.0;
+        for(double component : e)
+        {
+            twoSum(q, component, q, hh);
+            if(hh != 0.0)
+                h.push_back(hh);
+        }
+        if(q != 0.0 || h.empty())
+            h.push_back(q);
+        return h;
+    }
+
+    /**==============================================
+    *@return e + f */
+    static constexpr Expansion sum(const Expansion& e, const Expansion& f)
+    {
+        Expansion h = e;
+        for(double component : f)
+            h = grow(h, component);
+        return h;
+    }
+
+    /**==============================================
+    *@return e * b */
+    static constexpr Expansion scale(const Expansion& e, double b)
+    {
+        Expansion h;
+        double hi = 0.0, lo = 0.0;
+        for(double component : e)
+        {
+            twoProduct(component, b, hi, lo);
+            h = grow(grow(h, lo), hi);
+        }
+        return h;
+    }
+
+    /**==============================================
+    *@return e * f */
+    static constexpr Expansion product(const Expansion& e, const Expansion& f)
+    {
+        Expansion h;
+        for(double component : f)
+            h = sum(h, scale(e, component));
+        return h;
+    }
+
+    /**==============================================
+    *@return -e */
+    static constexpr Expansion negate(Expansion e)
+    {
+        for(double& component : e)
+            component = -component;
+        return e;
+    }
+
+    /**==============================================
+    *@return a - b as a two component expansion */
+    static constexpr Expansion difference(double a, double b)
+    {
+        double x = 0.0, y = 0.0;
+        twoSum(a, -b, x, y);
+        return grow(Expansion(1, y), x);
+    }
+
+    /**==============================================
+    *@return the sign of an expansion, its largest component comes last */
+    static constexpr double sign(const Expansion& e) noexcept
+    {
+        if(e.empty() || e.back() == 0.0)
+            return 0.0;
+        return e.back() > 0.0 ? 1.0 : -1.0;
+    }
+
+    static constexpr double orient2dExact(const Node& a, const Node& b, const Node& c)
+    {
+        Expansion acx = difference(a.x, c.x), acy = difference(a.y, c.y);
+        Expansion bcx = difference(b.x, c.x), bcy = difference(b.y, c.y);
+        return sign(sum(product(acx, bcy), negate(product(acy, bcx))));
+    }
+
+    static constexpr double inCircleExact(const Node& a, const Node& b, const Node& c, const Node& d)
+    {
+        Expansion adx = difference(a.x, d.x), ady = difference(a.y, d.y);
+        Expansion bdx = difference(b.x, d.x), bdy = difference(b.y, d.y);
+        Expansion cdx = difference(c.x, d.x), cdy = difference(c.y, d.y);
+
+        Expansion aLift = sum(product(adx, adx), product(ady, ady));
+        Expansion bLift = sum(product(bdx, bdx), product(bdy, bdy));
+        Expansion cLift = sum(product(cdx, cdx), product(cdy, cdy));
+
+        Expansion bc = sum(product(bdx, cdy), negate(product(cdx, bdy)));
+        Expansion ca = sum(product(cdx, ady), negate(product(adx, cdy)));
+        Expansion ab = sum(product(adx, bdy), negate(product(bdx, ady)));
+
+        return sign(sum(sum(product(aLift, bc), product(bLift, ca)), product(cLift, ab)));
+    }
+}
+
+/**==============================================
+*@return a positive value if a, b, c are in counter-clockwise order,
+* a negative value if clockwise and zero if they are collinear */
+static constexpr double orient2d(const Node& a, const Node& b, const Node& c)
+{
+    double detLeft  = (double(a.x) - c.x) * (double(b.y) - c.y);
+    double detRight = (double(a.y) - c.y) * (double(b.x) - c.x);
+    double det = detLeft - detRight;
+    double errBound = predicates::ORIENT_ERRBOUND * (predicates::absolute(detLeft) + predicates::absolute(detRight));
+
+    STATS_ADD(orientTests, 1);
+    if(det > errBound || -det > errBound)
+        return det;
+    STATS_ADD(orientExact, 1);
+    return predicates::orient2dExact(a, b, c);
+}
+
+/**==============================================
+*@return a positive value if d lies inside the circumcircle of the
+* counter-clockwise triangle a, b, c, negative if outside, zero if on it */
+static constexpr double inCircle(const Node& a, const Node& b, const Node& c, const Node& d)
+{
+    double adx = double(a.x) - d.x, ady = double(a.y) - d.y;
+    double bdx = double(b.x) - d.x, bdy = double(b.y) - d.y;
+    double cdx = double(c.x) - d.x, cdy = double(c.y) - d.y;
+
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+    double aLift = adx * adx + ady * ady;
+    double bLift = bdx * bdx + bdy * bdy;
+    double cLift = cdx * cdx + cdy * cdy;
+
+    double det = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+    double permanent = (predicates::absolute(bdxcdy) + predicates::absolute(cdxbdy)) * aLift
+                     + (predicates::absolute(cdxady) + predicates::absolute(adxcdy)) * bLift
+                     + (predicates::absolute(adxbdy) + predicates::absolute(bdxady)) * cLift;
+    double errBound = predicates::INCIRCLE_ERRBOUND * permanent;
+
+    STATS_ADD(inCircleTests, 1);
+    if(det > errBound || -det > errBound)
+        return det;
+    STATS_ADD(inCircleExact, 1);
+    return predicates::inCircleExact(a, b, c, d);
+}
+
+#endif // PREDICATES_H
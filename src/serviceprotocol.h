@@ -0,0 +1,119 @@
+#ifndef SERVICEPROTOCOL_H
+#define SERVICEPROTOCOL_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "node.h"
+
+/** Frames of the triangulation service (see TriangulationService), all little-endian.
+* A client sends a RequestHeader followed by length payload bytes and gets one
+* ReplyHeader with the same tag followed by its payload back, replies in request order.
+* Payloads by opcode, request -> reply:
+*   CREATE   Box                          -> uint32 mesh id
+*   DROP     empty                        -> empty
+*   INSERT   n x Node                     -> n x int32 vertex handle, -1 outside the bounds
+*   REMOVE   n x int32 vertex handle      -> n x uint8, 1 if the vertex was removed
+*   LOCATE   Node                         -> LocateReply
+*   NEAREST  Node                         -> NearestReply
+*   QUERY    Box                          -> m x 3 int32, the triangles meeting the box
+*   STATS    empty                        -> ServiceStats
+* Handles 0 to 2 are the super vertices of the mesh, so a located face with one of them
+* lies outside the hull. Equal nodes share a handle and a handle stays valid until removed;
+* later insertions reuse the handles of removed vertices, so churn keeps a mesh's storage flat
+* and a client must forget a handle once it removed it. */
+class RequestHeader
+{
+public:
+    enum Opcode : std::uint16_t {CREATE = 1, DROP, INSERT, REMOVE, LOCATE, NEAREST, QUERY, STATS, OPCODE_COUNT};
+    /// larger payloads close the connection
+    static const std::uint32_t MAX_PAYLOAD = 1u << 26;
+
+    std::uint32_t length; // payload bytes following the header
+    std::uint32_t tag;    // chosen by the client, echoed in the reply
+    std::uint32_t mesh;   // target of every opcode but CREATE and STATS
+    std::uint16_t opcode;
+    std::uint16_t reserved;
+};
+
+class ReplyHeader
+{
+public:
+    enum Status : std::uint16_t {OK = 0, BAD_REQUEST, NO_SUCH_MESH};
+
+    std::uint32_t length;
+    std::uint32_t tag;
+    std::uint16_t status; // the payload is empty unless OK
+    std::uint16_t opcode;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(RequestHeader) == 16 && sizeof(ReplyHeader) == 16, "the headers are part of the protocol");
+
+/// an axis aligned box, the bounds of a new mesh or the range of a query
+class Box
+{
+public:
+    Node minCorner, maxCorner;
+};
+
+class LocateReply
+{
+public:
+    std::int32_t face;
+    std::int32_t v[3]; // counter-clockwise vertex handles of the face
+};
+
+class NearestReply
+{
+public:
+    std::int32_t vertex; // -1 while the mesh is empty
+    Node node;
+};
+
+/// counters of one opcode, latencies from a request being read to its reply being queued
+class OpcodeStats
+{
+public:
+    std::uint64_t requests;
+    std::uint32_t p50Micros;
+    std::uint32_t p99Micros;
+};
+
+/// what the service did since it started, opcodes[0] covers every request
+class ServiceStats
+{
+public:
+    double seconds;               // since the service started
+    std::uint64_t connections;    // accepted so far
+    std::uint64_t meshes;         // alive now
+    std::uint64_t batches;        // request batches processed
+    std::uint64_t insertedPoints; // nodes that arrived in INSERT requests
+    std::uint64_t bytesIn, bytesOut;
+    OpcodeStats opcodes[RequestHeader::OPCODE_COUNT];
+
+    static const char* opcodeName(int opcode) noexcept
+    {
+        static const char* const NAMES[RequestHeader::OPCODE_COUNT] = {"all", "create", "drop", "insert", "remove", "locate",
+                                                                      "nearest", "query", "stats"};
+        return opcode >= 0 && opcode < RequestHeader::OPCODE_COUNT ? NAMES[opcode] : "unknown";
+    }
+
+    friend std::ostream& operator << (std::ostream& out, const ServiceStats& stats)
+    {
+        double seconds = stats.seconds > 0.0 ? stats.seconds : 1.0;
+        out << "uptime       " << stats.seconds << " s, " << stats.connections << " connections, " << stats.meshes << " meshes\n"
+            << "throughput   " << stats.opcodes[0].requests / seconds << " requests/s, " << stats.insertedPoints / seconds
+            << " points/s in " << stats.batches << " batches\n"
+            << "traffic      " << stats.bytesIn << " bytes in, " << stats.bytesOut << " bytes out\n";
+        for(int i = 0; i < RequestHeader::OPCODE_COUNT; i++)
+        {
+            const OpcodeStats& opcode = stats.opcodes[i];
+            if(opcode.requests > 0)
+                out << opcodeName(i) << ": " << opcode.requests << " requests, p50 " << opcode.p50Micros << " us, p99 " << opcode.p99Micros << " us\n";
+        }
+        return out;
+    }
+};
+
+#endif // SERVICEPROTOCOL_H
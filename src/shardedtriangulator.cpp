@@ -0,0 +1,664 @@
+#include "shardedtriangulator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "mesh.h"
+#include "trace.h"
+
+std::ostream& operator << (std::ostream& out, const ShardReport& report)
+{
+    out << "shard " << report.shard;
+    if(report.numaNode >= 0)
+        out << " on node " << report.numaNode;
+    return out << ": " << report.points << " points + " << report.halo << " halo, " << report.triangles << " triangles, "
+               << report.unresolved << " unresolved in " << report.seconds << " s, " << report.attempts
+               << (report.attempts == 1 ? " attempt" : " attempts");
+}
+
+/// a directed edge a -> b as one key
+static inline std::uint64_t edgeKey(int a, int b) noexcept
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(a)) << 32) | static_cast<std::uint32_t>(b);
+}
+
+/// the loaded range of a slab holds the whole circumcircle of a face, with room for rounding
+static bool circleInside(const Node& a, const Node& b, const Node& c, double low, double high)
+{
+    double bx = double(b.x) - a.x, by = double(b.y) - a.y;
+    double cx = double(c.x) - a.x, cy = double(c.y) - a.y;
+    double d = 2.0 * (bx * cy - by * cx);
+    if(!(d > 0.0))
+        return false;
+    double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+    double ux = (cy * b2 - by * c2) / d, uy = (bx * c2 - cx * b2) / d;
+    double r = std::sqrt(ux * ux + uy * uy);
+    ux += a.x;
+    r += 1e-6 * (r + std::abs(ux) + std::abs(uy + a.y));
+    return ux - r > low && ux + r < high;
+}
+
+/// @return the cpus of each NUMA node, empty unless the machine has more than one
+static std::vector<std::vector<int>> numaNodes(void)
+{
+    std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+    std::error_code code;
+    std::vector<std::filesystem::path> paths;
+    for(const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", code))
+    {
+        std::string name = entry.path().filename().string();
+        if(name.size() > 4 && name.compare(0, 4, "node") == 0 && std::all_of(name.begin() + 4, name.end(), ::isdigit))
+            paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end(), [](const std::filesystem::path& p, const std::filesystem::path& q)
+    {
+        return std::stoi(p.filename().string().substr(4)) < std::stoi(q.filename().string().substr(4));
+    });
+    for(const std::filesystem::path& path : paths)
+    {
+        // a list of ranges such as 0-7,16-23
+        std::ifstream list(path / "cpulist");
+        std::vector<int> cpus;
+        std::string range;
+        while(std::getline(list, range, ','))
+        {
+            std::size_t dash = range.find('-');
+            int first = std::atoi(range.c_str());
+            int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+            for(int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        if(!cpus.empty())
+            nodes.push_back(cpus);
+    }
+#endif
+    if(nodes.size() < 2)
+        nodes.clear();
+    return nodes;
+}
+
+#if !defined(_WIN32)
+
+#if defined(MSG_NOSIGNAL)
+static const int SEND_FLAGS = MSG_NOSIGNAL; // a dead peer is an error, not a SIGPIPE
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+static bool sendAll(int socket, const void* data, std::size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while(size > 0)
+    {
+        ssize_t sent = send(socket, p, size, SEND_FLAGS);
+        if(sent < 0 && errno == EINTR)
+            continue;
+        if(sent <= 0)
+            return false;
+        p += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+static bool receiveAll(int socket, void* data, std::size_t size)
+{
+    char* p = static_cast<char*>(data);
+    while(size > 0)
+    {
+        ssize_t got = recv(socket, p, size, 0);
+        if(got < 0 && errno == EINTR)
+            continue;
+        if(got <= 0)
+            return false;
+        p += got;
+        size -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+template <typename T>
+static bool sendArray(int socket, const std::vector<T>& values)
+{
+    std::uint64_t count = values.size();
+    return sendAll(socket, &count, sizeof(count)) && sendAll(socket, values.data(), values.size() * sizeof(T));
+}
+
+/// limit bounds the count, a broken peer cannot make us allocate more
+template <typename T>
+static bool receiveArray(int socket, std::size_t limit, std::vector<T>* values)
+{
+    std::uint64_t count;
+    if(!receiveAll(socket, &count, sizeof(count)) || count > limit)
+        return false;
+    values->resize(static_cast<std::size_t>(count));
+    return receiveAll(socket, values->data(), values->size() * sizeof(T));
+}
+
+static void pin(const std::vector<int>& cpus)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus)
+    {
+        if(cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    // everything the worker allocates from here on is first touched on its node
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpus;
+#endif
+}
+
+#endif // !_WIN32
+
+ShardedTriangulator::ShardedTriangulator(int shards, double halo)
+    : shardCount(std::max(shards, 1)), halo(halo)
+{
+}
+
+void ShardedTriangulator::split(std::span<const Node> nodes)
+{
+    TRACE_SCOPE("split");
+    std::vector<float> xs;
+    xs.reserve(nodes.size());
+    float minX = std::numeric_limits<float>::infinity(), maxX = -minX, minY = minX, maxY = -minX;
+    for(const Node& n : nodes)
+    {
+        if(!std::isfinite(n.x) || !std::isfinite(n.y))
+            continue;
+        xs.push_back(n.x);
+        minX = std::min(minX, n.x);
+        maxX = std::max(maxX, n.x);
+        minY = std::min(minY, n.y);
+        maxY = std::max(maxY, n.y);
+    }
+
+    // the mean spacing of points spread evenly over their bounding box
+    double width = xs.empty() ? 0.0 : double(maxX) - minX, height = xs.empty() ? 0.0 : double(maxY) - minY;
+    double spacing = xs.empty() ? 0.0 : width > 0.0 && height > 0.0 ? std::sqrt(width * height / xs.size())
+                                                                     : std::max(width, height) / xs.size();
+    this->haloWidth = this->halo * spacing;
+
+    // slabs of equal count, cut at the x quantiles
+    int count = this->shardCount;
+    std::vector<double> cuts(count + 1);
+    cuts[0] = -std::numeric_limits<double>::infinity();
+    cuts[count] = std::numeric_limits<double>::infinity();
+    std::size_t previous = 0;
+    for(int k = 1; k < count; k++)
+    {
+        std::size_t position = xs.size() * k / count;
+        if(position >= xs.size())
+        {
+            cuts[k] = cuts[count];
+            continue;
+        }
+        std::nth_element(xs.begin() + previous, xs.begin() + position, xs.end());
+        cuts[k] = xs[position];
+        previous = position;
+    }
+    std::vector<float>().swap(xs);
+
+    this->shards.assign(count, Shard());
+    for(int k = 0; k < count; k++)
+    {
+        this->shards[k].low = k == 0 ? cuts[0] : cuts[k] - this->haloWidth;
+        this->shards[k].high = k == count - 1 ? cuts[count] : cuts[k + 1] + this->haloWidth;
+    }
+
+    // own points in input order first, then the halo in input order
+    std::vector<std::vector<Record>> halos(count);
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        const Node& n = nodes[i];
+        if(!std::isfinite(n.x) || !std::isfinite(n.y))
+            continue;
+        int k = static_cast<int>(std::upper_bound(cuts.begin() + 1, cuts.end() - 1, double(n.x)) - (cuts.begin() + 1));
+        Record record{n, static_cast<std::int32_t>(i)};
+        this->shards[k].records.push_back(record);
+        for(int j = k - 1; j >= 0 && n.x <= this->shards[j].high; j--)
+            halos[j].push_back(record);
+        for(int j = k + 1; j < count && n.x >= this->shards[j].low; j++)
+            halos[j].push_back(record);
+    }
+    for(int k = 0; k < count; k++)
+    {
+        Shard& shard = this->shards[k];
+        shard.own = shard.records.size();
+        shard.records.insert(shard.records.end(), halos[k].begin(), halos[k].end());
+    }
+}
+
+ShardedTriangulator::Result ShardedTriangulator::certify(const Shard& shard)
+{
+    Result result;
+    if(shard.records.empty())
+        return result;
+
+    std::vector<Node> nodes(shard.records.size());
+    Node minCorner = shard.records[0].node, maxCorner = minCorner;
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        nodes[i] = shard.records[i].node;
+        minCorner = Node(std::min(minCorner.x, nodes[i].x), std::min(minCorner.y, nodes[i].y));
+        maxCorner = Node(std::max(maxCorner.x, nodes[i].x), std::max(maxCorner.y, nodes[i].y));
+    }
+    Mesh mesh(minCorner, maxCorner);
+    std::vector<int> handles = mesh.insertBatch(nodes);
+
+    // equal points share a handle, it takes the first index, which every shard agrees on
+    std::vector<std::int32_t> id(mesh.vertices.size(), Mesh::NONE);
+    std::vector<unsigned char> own(mesh.vertices.size(), 0);
+    for(std::size_t i = 0; i < handles.size(); i++)
+    {
+        int h = handles[i];
+        if(h != Mesh::NONE && id[h] == Mesh::NONE)
+        {
+            id[h] = shard.records[i].id;
+            own[h] = i < shard.own;
+        }
+    }
+
+    // a Delaunay cell is the group of faces sharing one empty circle, joined across cocircular edges
+    int faceCount = static_cast<int>(mesh.faces.size());
+    std::vector<int> group(faceCount);
+    std::iota(group.begin(), group.end(), 0);
+    auto find = [&](int f)
+    {
+        while(group[f] != f)
+            f = group[f] = group[group[f]];
+        return f;
+    };
+    auto finite = [&](int f) { return mesh.isAlive(f) && !mesh.isSuperFace(f); };
+    for(int f = 0; f < faceCount; f++)
+    {
+        if(!finite(f))
+            continue;
+        for(int g : mesh.faces[f].adj)
+        {
+            if(g <= f || !finite(g))
+                continue;
+            const Mesh::Face& other = mesh.faces[g];
+            int opposite = other.adj[0] == f ? other.v[0] : other.adj[1] == f ? other.v[1] : other.v[2];
+            if(mesh.inCircle(f, mesh.vertices[opposite]) == 0.0)
+                group[find(g)] = find(f);
+        }
+    }
+
+    std::vector<unsigned char> certain(faceCount, 1), anyOwn(faceCount, 0), allOwn(faceCount, 1);
+    for(int f = 0; f < faceCount; f++)
+    {
+        if(!finite(f))
+            continue;
+        const Mesh::Face& face = mesh.faces[f];
+        int root = find(f);
+        if(!circleInside(mesh.vertices[face.v[0]], mesh.vertices[face.v[1]], mesh.vertices[face.v[2]], shard.low, shard.high))
+            certain[root] = 0;
+        for(int v : face.v)
+        {
+            anyOwn[root] |= own[v];
+            allOwn[root] &= own[v];
+        }
+    }
+
+    // own vertices touching an uncertain cell or the hull are left to the seam
+    std::vector<unsigned char> unresolved(mesh.vertices.size(), 0);
+    for(int f = 0; f < faceCount; f++)
+    {
+        if(!mesh.isAlive(f))
+            continue;
+        const Mesh::Face& face = mesh.faces[f];
+        if(mesh.isSuperFace(f) || !certain[find(f)])
+        {
+            for(int v : face.v)
+                unresolved[v] = 1;
+            continue;
+        }
+        int root = find(f);
+        if(!anyOwn[root])
+            continue;
+        std::array<int, 3> triangle{id[face.v[0]], id[face.v[1]], id[face.v[2]]};
+        if(allOwn[root])
+            result.triangles.push_back(triangle);
+        else
+        {
+            result.shared.push_back(triangle);
+            result.sharedGroup.push_back(root);
+        }
+    }
+    for(std::size_t v = 3; v < unresolved.size(); v++)
+    {
+        if(unresolved[v] && own[v])
+            result.unresolved.push_back(id[v]);
+    }
+    return result;
+}
+
+#if !defined(_WIN32)
+
+void ShardedTriangulator::work(int socket, bool fail)
+{
+    Shard shard;
+    std::uint64_t own;
+    if(!receiveAll(socket, &shard.low, sizeof(shard.low)) || !receiveAll(socket, &shard.high, sizeof(shard.high))
+        || !receiveAll(socket, &own, sizeof(own)) || !receiveArray(socket, INT_MAX, &shard.records) || own > shard.records.size())
+        _exit(1);
+    shard.own = static_cast<std::size_t>(own);
+    if(fail)
+        raise(SIGKILL);
+
+    auto start = std::chrono::steady_clock::now();
+    Result result = certify(shard);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool ok = sendArray(socket, result.triangles) && sendArray(socket, result.shared) && sendArray(socket, result.sharedGroup)
+        && sendArray(socket, result.unresolved) && sendAll(socket, &result.seconds, sizeof(result.seconds));
+    close(socket);
+    _exit(ok ? 0 : 1);
+}
+
+int ShardedTriangulator::spawn(int shard, const std::vector<int>* cpus, int attempt, int* process)
+{
+    int pair[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+        return -1;
+#if defined(SO_NOSIGPIPE)
+    int on = 1;
+    setsockopt(pair[0], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        close(pair[0]);
+        close(pair[1]);
+        return -1;
+    }
+    if(pid == 0)
+    {
+        // the worker keeps only its own end
+        close(pair[0]);
+        for(int socket : this->sockets)
+        {
+            if(socket >= 0)
+                close(socket);
+        }
+        if(cpus != nullptr)
+            pin(*cpus);
+        work(pair[1], shard == this->failingShard && attempt == 0);
+    }
+    close(pair[1]);
+    *process = pid;
+
+    const Shard& s = this->shards[shard];
+    std::uint64_t own = s.own;
+    if(sendAll(pair[0], &s.low, sizeof(s.low)) && sendAll(pair[0], &s.high, sizeof(s.high)) && sendAll(pair[0], &own, sizeof(own))
+        && sendArray(pair[0], s.records))
+        return pair[0];
+    close(pair[0]);
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    *process = -1;
+    return -1;
+}
+
+bool ShardedTriangulator::receive(int socket, std::size_t pointCount, Result* result)
+{
+    // a planar triangulation has fewer than two triangles per point
+    std::size_t limit = 2 * pointCount + 16;
+    return receiveArray(socket, limit, &result->triangles) && receiveArray(socket, limit, &result->shared)
+        && receiveArray(socket, limit, &result->sharedGroup) && result->sharedGroup.size() == result->shared.size()
+        && receiveArray(socket, pointCount, &result->unresolved) && receiveAll(socket, &result->seconds, sizeof(result->seconds));
+}
+
+#endif // !_WIN32
+
+void ShardedTriangulator::merge(std::span<const Node> nodes, std::vector<std::array<int, 3>>* out)
+{
+    TRACE_SCOPE("merge");
+    for(const Result& result : this->results)
+        out->insert(out->end(), result.triangles.begin(), result.triangles.end());
+
+    // cells spanning slabs come back from every slab they touch, the first copy is kept
+    std::set<std::vector<int>> seen;
+    for(const Result& result : this->results)
+    {
+        std::unordered_map<int, std::vector<std::size_t>> groups;
+        for(std::size_t t = 0; t < result.shared.size(); t++)
+            groups[result.sharedGroup[t]].push_back(t);
+        for(const auto& entry : groups)
+        {
+            std::vector<int> key;
+            for(std::size_t t : entry.second)
+                key.insert(key.end(), result.shared[t].begin(), result.shared[t].end());
+            std::sort(key.begin(), key.end());
+            key.erase(std::unique(key.begin(), key.end()), key.end());
+            if(!seen.insert(std::move(key)).second)
+                continue;
+            for(std::size_t t : entry.second)
+                out->push_back(result.shared[t]);
+        }
+    }
+
+    // every cell still missing has only unresolved vertices
+    std::vector<unsigned char> inSeam(nodes.size(), 0);
+    std::vector<int> seam;
+    for(const Result& result : this->results)
+    {
+        for(int v : result.unresolved)
+        {
+            if(!inSeam[v])
+            {
+                inSeam[v] = 1;
+                seam.push_back(v);
+            }
+        }
+    }
+    this->seamPoints = seam.size();
+    if(seam.size() < 3)
+        return;
+
+    // the edges of certain cells between seam vertices, the holes lie across those without a twin
+    std::unordered_set<std::uint64_t> certainEdges;
+    for(const std::array<int, 3>& t : *out)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            if(inSeam[t[i]] && inSeam[t[(i + 1) % 3]])
+                certainEdges.insert(edgeKey(t[i], t[(i + 1) % 3]));
+        }
+    }
+
+    std::vector<Node> seamNodes(seam.size());
+    Node minCorner = nodes[seam[0]], maxCorner = minCorner;
+    for(std::size_t i = 0; i < seam.size(); i++)
+    {
+        seamNodes[i] = nodes[seam[i]];
+        minCorner = Node(std::min(minCorner.x, seamNodes[i].x), std::min(minCorner.y, seamNodes[i].y));
+        maxCorner = Node(std::max(maxCorner.x, seamNodes[i].x), std::max(maxCorner.y, seamNodes[i].y));
+    }
+    Mesh mesh(minCorner, maxCorner);
+    std::vector<int> handles = mesh.insertBatch(seamNodes);
+    std::vector<int> id(mesh.vertices.size(), Mesh::NONE);
+    for(std::size_t i = 0; i < handles.size(); i++)
+    {
+        if(handles[i] != Mesh::NONE && id[handles[i]] == Mesh::NONE)
+            id[handles[i]] = seam[i];
+    }
+    std::vector<std::array<int, 3>> triangles;
+    mesh.getTriangles(&triangles);
+    std::unordered_map<std::uint64_t, int> seamEdges;
+    for(std::size_t t = 0; t < triangles.size(); t++)
+    {
+        for(int& v : triangles[t])
+            v = id[v];
+        for(int i = 0; i < 3; i++)
+            seamEdges[edgeKey(triangles[t][i], triangles[t][(i + 1) % 3])] = static_cast<int>(t);
+    }
+
+    // flood the holes from their rims without crossing into a certain cell
+    std::vector<unsigned char> taken(triangles.size(), 0);
+    std::vector<int> stack;
+    auto take = [&](int a, int b)
+    {
+        auto it = seamEdges.find(edgeKey(a, b));
+        if(it != seamEdges.end() && !taken[it->second])
+        {
+            taken[it->second] = 1;
+            stack.push_back(it->second);
+        }
+    };
+    if(out->empty())
+    {
+        // nothing was certain, the seam is the whole triangulation
+        std::fill(taken.begin(), taken.end(), 1);
+    }
+    for(std::uint64_t key : certainEdges)
+    {
+        int a = static_cast<int>(key >> 32), b = static_cast<int>(key & 0xffffffffu);
+        if(!certainEdges.count(edgeKey(b, a)))
+            take(b, a);
+    }
+    while(!stack.empty())
+    {
+        const std::array<int, 3>& t = triangles[stack.back()];
+        stack.pop_back();
+        for(int i = 0; i < 3; i++)
+        {
+            int a = t[i], b = t[(i + 1) % 3];
+            if(!certainEdges.count(edgeKey(b, a)))
+                take(b, a);
+        }
+    }
+    for(std::size_t t = 0; t < triangles.size(); t++)
+    {
+        if(taken[t])
+        {
+            out->push_back(triangles[t]);
+            this->seamTriangles++;
+        }
+    }
+}
+
+bool ShardedTriangulator::triangulate(std::span<const Node> nodes, std::vector<std::array<int, 3>>* out)
+{
+    TRACE_SCOPE("shardedTriangulate");
+    out->clear();
+    this->error.clear();
+    this->seamPoints = 0;
+    this->seamTriangles = 0;
+#if defined(_WIN32)
+    (void)nodes;
+    this->error = "sharded triangulation forks its workers, which needs a POSIX system";
+    return false;
+#else
+    if(nodes.size() > static_cast<std::size_t>(INT_MAX))
+    {
+        this->error = "more points than a triangle can index";
+        return false;
+    }
+    this->split(nodes);
+    std::vector<std::vector<int>> numa = numaNodes();
+
+    int count = this->shardCount;
+    this->reports.assign(count, ShardReport());
+    this->results.assign(count, Result());
+    this->sockets.assign(count, -1);
+    std::vector<int> processes(count, -1);
+    auto numaNode = [&](int k) { return numa.empty() ? -1 : k % static_cast<int>(numa.size()); };
+    auto cpus = [&](int k) { return numa.empty() ? nullptr : &numa[numaNode(k)]; };
+
+    // all workers start before any result is read, so they run side by side
+    for(int k = 0; k < count; k++)
+    {
+        ShardReport& report = this->reports[k];
+        report.shard = k;
+        report.numaNode = numaNode(k);
+        report.points = this->shards[k].own;
+        report.halo = this->shards[k].records.size() - this->shards[k].own;
+        this->sockets[k] = this->spawn(k, cpus(k), 0, &processes[k]);
+        report.attempts = 1;
+    }
+
+    // a worker that fails is replaced, the others keep their results
+    bool ok = true;
+    for(int k = 0; k < count && ok; k++)
+    {
+        ShardReport& report = this->reports[k];
+        while(true)
+        {
+            bool received = this->sockets[k] >= 0 && this->receive(this->sockets[k], this->shards[k].records.size(), &this->results[k]);
+            int status = 0;
+            if(this->sockets[k] >= 0)
+                close(this->sockets[k]);
+            this->sockets[k] = -1;
+            if(processes[k] > 0)
+            {
+                if(!received)
+                    kill(processes[k], SIGKILL);
+                received = waitpid(processes[k], &status, 0) == processes[k] && received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            }
+            processes[k] = -1;
+            if(received)
+                break;
+            if(report.attempts == MAX_ATTEMPTS)
+            {
+                this->error = "every worker of shard " + std::to_string(k) + " failed";
+                ok = false;
+                break;
+            }
+            this->results[k] = Result();
+            this->sockets[k] = this->spawn(k, cpus(k), report.attempts, &processes[k]);
+            report.attempts++;
+        }
+        report.triangles = this->results[k].triangles.size() + this->results[k].shared.size();
+        report.unresolved = this->results[k].unresolved.size();
+        report.seconds = this->results[k].seconds;
+    }
+
+    if(!ok)
+    {
+        for(int k = 0; k < count; k++)
+        {
+            if(this->sockets[k] >= 0)
+                close(this->sockets[k]);
+            if(processes[k] > 0)
+            {
+                kill(processes[k], SIGKILL);
+                waitpid(processes[k], nullptr, 0);
+            }
+        }
+    }
+    else
+        this->merge(nodes, out);
+
+    std::vector<Shard>().swap(this->shards);
+    std::vector<Result>().swap(this->results);
+    this->sockets.clear();
+    return ok;
+#endif
+}
@@ -0,0 +1,143 @@
+#ifndef SHARDEDTRIANGULATOR_H
+#define SHARDEDTRIANGULATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "node.h"
+
+/// what one shard cost, and where its worker ran
+class ShardReport
+{
+public:
+    int shard = 0;
+    int numaNode = -1;          // node the worker was pinned to, -1 if it was not pinned
+    int attempts = 0;           // workers started for the shard, more than one after a failure
+    std::size_t points = 0;     // points of the shard's own slab
+    std::size_t halo = 0;       // points copied in from the neighbouring slabs
+    std::size_t triangles = 0;  // triangles the worker could certify
+    std::size_t unresolved = 0; // own vertices left to the seam
+    double seconds = 0.0;       // triangulation and certification inside the worker
+
+    friend std::ostream& operator << (std::ostream& out, const ShardReport& report);
+};
+
+/** Delaunay triangulation split across worker processes on one machine.
+* The coordinator cuts the points into vertical slabs of equal count and forks one worker
+* per slab, sending it the slab plus a halo of the points within getHalo() of either side
+* over a Unix socket pair. Each worker pins itself to a NUMA node of its own where the
+* machine has several, triangulates with Mesh::insertBatch and sends back only what it can
+* prove: a Delaunay cell, the triangles sharing one empty circumcircle, is certain when that
+* circle stays inside the slab and halo, as then no point the worker has not seen can lie
+* in it. Certain cells with a vertex in the slab come back whole, so cocircular points are
+* triangulated once; cells spanning slabs come back from each and are kept once.
+* An own vertex whose star is certain has its complete final star, so every cell missing
+* from the merged result has only unresolved vertices: the coordinator triangulates those
+* alone and fills the holes left between the certain cells from that seam triangulation,
+* flooding from the edges of the certain cells. A worker that dies or sends a short result
+* costs a new worker for its slab only, up to MAX_ATTEMPTS. POSIX only, as it forks. */
+class ShardedTriangulator
+{
+public:
+    static const int MAX_ATTEMPTS = 3;
+
+    /// halo is the overlap on each side of a slab, in mean point spacings of the input
+    explicit ShardedTriangulator(int shards, double halo = 6.0);
+
+    /// @return false with getError() set if no worker of some shard succeeded
+    bool triangulate(std::span<const Node> nodes, std::vector<std::array<int, 3>>* out);
+
+    /// the first worker of the shard kills itself after reading its input, to exercise recovery
+    inline void injectFailure(int shard) noexcept
+    {
+        this->failingShard = shard;
+    }
+
+    inline const std::vector<ShardReport>& getShards(void) const noexcept
+    {
+        return this->reports;
+    }
+
+    /// @return the halo width of the last run in input units
+    inline double getHalo(void) const noexcept
+    {
+        return this->haloWidth;
+    }
+
+    /// @return the unresolved vertices the coordinator triangulated for the seams
+    inline std::size_t getSeamPoints(void) const noexcept
+    {
+        return this->seamPoints;
+    }
+
+    /// @return the triangles the seam triangulation filled in
+    inline std::size_t getSeamTriangles(void) const noexcept
+    {
+        return this->seamTriangles;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    /// a point as a worker receives it, id is its index in the input
+    class Record
+    {
+    public:
+        Node node;
+        std::int32_t id;
+    };
+
+    /// the slab of one shard, own points first, then the halo, each in input order
+    class Shard
+    {
+    public:
+        double low, high;   // the loaded x range, infinite on the outer sides
+        std::vector<Record> records;
+        std::size_t own = 0;
+    };
+
+    /// what a worker proved, in input indices
+    class Result
+    {
+    public:
+        std::vector<std::array<int, 3>> triangles; // cells with all vertices in the slab
+        std::vector<std::array<int, 3>> shared;    // cells spanning slabs, a group index per triangle below
+        std::vector<std::int32_t> sharedGroup;
+        std::vector<std::int32_t> unresolved;
+        double seconds = 0.0;
+    };
+
+    void split(std::span<const Node> nodes);
+    /// forks a worker for the shard, pinned to cpus if given, and sends it its points
+    /// @return the coordinator's end of the socket, or -1
+    int spawn(int shard, const std::vector<int>* cpus, int attempt, int* process);
+    bool receive(int socket, std::size_t pointCount, Result* result);
+    void merge(std::span<const Node> nodes, std::vector<std::array<int, 3>>* out);
+
+    /// runs in the worker process and ends it
+    [[noreturn]] static void work(int socket, bool fail);
+    static Result certify(const Shard& shard);
+
+    int shardCount;
+    double halo;
+    double haloWidth = 0.0;
+    int failingShard = -1;
+
+    std::vector<Shard> shards;
+    std::vector<Result> results;
+    std::vector<int> sockets; // coordinator ends, one per shard while its worker runs
+    std::vector<ShardReport> reports;
+    std::size_t seamPoints = 0;
+    std::size_t seamTriangles = 0;
+    std::string error;
+};
+
+#endif // SHARDEDTRIANGULATOR_H
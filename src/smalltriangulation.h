@@ -0,0 +1,267 @@
+#ifndef SMALLTRIANGULATION_H
+#define SMALLTRIANGULATION_H
+
+#include <array>
+#include <span>
+
+#include "node.h"
+#include "predicates.h"
+#include "superpredicates.h"
+
+/** Delaunay kernel for point sets of at most MAX_POINTS nodes.
+* All vertices, faces, adjacency and the flip stack live in fixed-size arrays
+* sized at compile time, so a triangulation touches no heap at all; keep an
+* instance on the stack. Nodes are inserted with Lawson flips in input order,
+* which for a few dozen points beats any spatial sort or hierarchy. The
+* super vertices are the same symbolic ones the Mesh uses. The whole kernel is
+* constexpr, see stencil.h for triangulations computed at compile time. */
+template <int MAX_POINTS>
+class SmallTriangulation
+{
+public:
+    static const int MAX_VERTICES = MAX_POINTS + 3;
+    static const int MAX_FACES = 2 * MAX_POINTS + 1;
+    /// an upper bound on the triangles of any set, the size out must have
+    static const int MAX_TRIANGLES = 2 * MAX_POINTS;
+
+    /**==============================================
+    *@return the number of triangles written to out, each an index triple into nodes;
+    * nodes.size() must not exceed MAX_POINTS */
+    constexpr int triangulate(std::span<const Node> nodes, std::array<int, 3>* out)
+    {
+        this->vertexCount = 3;
+        this->faceCount = 1;
+        this->v[0] = {0, 1, 2};
+        this->adj[0] = {NONE, NONE, NONE};
+
+        int face = 0;
+        for(int i = 0; i < static_cast<int>(nodes.size()); i++)
+        {
+            face = this->locate(nodes[i], face);
+            const std::array<int, 3>& f = this->v[face];
+            if(this->isEqual(f[0], nodes[i]) || this->isEqual(f[1], nodes[i]) || this->isEqual(f[2], nodes[i]))
+                continue;
+            this->vertices[this->vertexCount] = nodes[i];
+            this->source[this->vertexCount] = i;
+            face = this->insert(this->vertexCount++, face);
+        }
+
+        int count = 0;
+        for(int g = 0; g < this->faceCount; g++)
+        {
+            const std::array<int, 3>& f = this->v[g];
+            if(f[0] >= 3 && f[1] >= 3 && f[2] >= 3)
+                out[count++] = {this->source[f[0]], this->source[f[1]], this->source[f[2]]};
+        }
+        return count;
+    }
+
+private:
+    static const int NONE = -1;
+    static constexpr int NEXT[3] = {1, 2, 0};
+    static constexpr int PREV[3] = {2, 0, 1};
+
+    constexpr bool isEqual(int vertex, const Node& n) const noexcept
+    {
+        return vertex >= 3 && this->vertices[vertex] == n;
+    }
+
+    constexpr SymbolicPoint point(int vertex) const noexcept
+    {
+        if(vertex < 3)
+            return SymbolicPoint{nullptr, vertex};
+        return SymbolicPoint{&this->vertices[vertex], NONE};
+    }
+
+    constexpr double orient(int a, int b, const Node& n) const
+    {
+        if(a >= 3 && b >= 3)
+            return orient2d(this->vertices[a], this->vertices[b], n);
+        return symbolicOrient(this->point(a), this->point(b), SymbolicPoint{&n, NONE});
+    }
+
+    constexpr double inCircle(int a, int b, int c, int d) const
+    {
+        if(a >= 3 && b >= 3 && c >= 3 && d >= 3)
+            return ::inCircle(this->vertices[a], this->vertices[b], this->vertices[c], this->vertices[d]);
+        return symbolicInCircle(this->point(a), this->point(b), this->point(c), this->point(d));
+    }
+
+    /**==============================================
+    *@return the position of vertex in face, which must contain it */
+    constexpr int indexOf(int face, int vertex) const noexcept
+    {
+        const std::array<int, 3>& f = this->v[face];
+        return f[0] == vertex ? 0 : f[1] == vertex ? 1 : 2;
+    }
+
+    constexpr void setFace(int face, int a, int b, int c, int adjA, int adjB, int adjC) noexcept
+    {
+        this->v[face] = {a, b, c};
+        this->adj[face] = {adjA, adjB, adjC};
+    }
+
+    constexpr void replaceNeighbour(int face, int oldNeighbour, int newNeighbour) noexcept
+    {
+        if(face == NONE)
+            return;
+        std::array<int, 3>& a = this->adj[face];
+        a[a[0] == oldNeighbour ? 0 : a[1] == oldNeighbour ? 1 : 2] = newNeighbour;
+    }
+
+    /**==============================================
+    *@return the face containing n, found by a visibility walk from face */
+    constexpr int locate(const Node& n, int face) const
+    {
+        int previous = NONE;
+        unsigned int step = 0;
+        while(true)
+        {
+            const std::array<int, 3>& f = this->v[face];
+            const std::array<int, 3>& a = this->adj[face];
+            // rotate the first edge tested so the walk cannot cycle on degenerate input
+            int i = step % 3, j = NEXT[i], k = PREV[i];
+            int next;
+            if(a[i] != previous && this->orient(f[j], f[k], n) < 0.0)
+                next = a[i];
+            else if(a[j] != previous && this->orient(f[k], f[i], n) < 0.0)
+                next = a[j];
+            else if(a[k] != previous && this->orient(f[i], f[j], n) < 0.0)
+                next = a[k];
+            else
+                return face;
+            previous = face;
+            face = next;
+            step++;
+        }
+    }
+
+    /**==============================================
+    *@return a face incident to the new vertex p, which lies in face */
+    constexpr int insert(int p, int face)
+    {
+        const Node& n = this->vertices[p];
+        const std::array<int, 3> f = this->v[face];
+        const std::array<int, 3> fadj = this->adj[face];
+
+        int onEdge = NONE;
+        if(this->orient(f[1], f[2], n) == 0.0)
+            onEdge = 0;
+        else if(this->orient(f[2], f[0], n) == 0.0)
+            onEdge = 1;
+        else if(this->orient(f[0], f[1], n) == 0.0)
+            onEdge = 2;
+
+        // as in Mesh::insertByFlips every face touching p keeps it as v[0]
+        this->stackSize = 0;
+        if(onEdge == NONE)
+        {
+            int f0 = face, f1 = this->faceCount++, f2 = this->faceCount++;
+            this->setFace(f0, p, f[0], f[1], fadj[2], f1, f2);
+            this->setFace(f1, p, f[1], f[2], fadj[0], f2, f0);
+            this->setFace(f2, p, f[2], f[0], fadj[1], f0, f1);
+            this->replaceNeighbour(fadj[0], face, f1);
+            this->replaceNeighbour(fadj[1], face, f2);
+            this->stack[0] = f0;
+            this->stack[1] = f1;
+            this->stack[2] = f2;
+            this->stackSize = 3;
+        }
+        else
+        {
+            int a = f[NEXT[onEdge]], b = f[PREV[onEdge]], c = f[onEdge];
+            int fa = fadj[NEXT[onEdge]], fb = fadj[PREV[onEdge]];
+            int g = fadj[onEdge];
+
+            int f1 = face, f2 = this->faceCount++;
+            int g1 = NONE, g2 = NONE;
+            if(g != NONE)
+            {
+                int j = NEXT[this->indexOf(g, a)];
+                int d = this->v[g][j];
+                int ga = this->adj[g][PREV[j]], gb = this->adj[g][NEXT[j]];
+
+                g1 = g;
+                g2 = this->faceCount++;
+                this->setFace(g1, p, d, b, ga, f1, g2);
+                this->setFace(g2, p, a, d, gb, g1, f2);
+                this->replaceNeighbour(gb, g, g2);
+                this->stack[2] = g1;
+                this->stack[3] = g2;
+                this->stackSize = 2;
+            }
+            this->setFace(f1, p, b, c, fa, f2, g1);
+            this->setFace(f2, p, c, a, fb, g2, f1);
+            this->replaceNeighbour(fb, face, f2);
+            this->stack[0] = f1;
+            this->stack[1] = f2;
+            this->stackSize += 2;
+        }
+
+        this->legalize();
+        return face;
+    }
+
+    constexpr void legalize(void)
+    {
+        while(this->stackSize > 0)
+        {
+            int face = this->stack[--this->stackSize];
+            int g = this->adj[face][0];
+            if(g == NONE)
+                continue;
+
+            // face = (p, x, y) and g = (d, y, x) become (p, x, d) and (p, d, y)
+            const std::array<int, 3> f = this->v[face];
+            int j = NEXT[this->indexOf(g, f[1])];
+            int d = this->v[g][j];
+            if(this->inCircle(f[0], f[1], f[2], d) <= 0.0)
+                continue;
+
+            int fx = this->adj[face][1], fy = this->adj[face][2];
+            int gx = this->adj[g][PREV[j]], gy = this->adj[g][NEXT[j]];
+            this->setFace(face, f[0], f[1], d, gy, g, fy);
+            this->setFace(g, f[0], d, f[2], gx, fx, face);
+            this->replaceNeighbour(gy, g, face);
+            this->replaceNeighbour(fx, face, g);
+
+            this->stack[this->stackSize++] = face;
+            this->stack[this->stackSize++] = g;
+        }
+    }
+
+    std::array<Node, MAX_VERTICES> vertices;
+    std::array<int, MAX_VERTICES> source;           // vertex -> index in the input span
+    std::array<std::array<int, 3>, MAX_FACES> v;     // counterclockwise vertices of each face
+    std::array<std::array<int, 3>, MAX_FACES> adj;   // adj[f][i] is across the edge opposite v[f][i]
+    // each flip adds one entry and there are fewer flips per insertion than vertices
+    std::array<int, MAX_VERTICES + 4> stack;
+    int vertexCount = 0;
+    int faceCount = 0;
+    int stackSize = 0;
+};
+
+/// the largest set triangulateSmall() accepts
+static const int SMALL_KERNEL_LIMIT = 32;
+
+/**==============================================
+*@return the number of triangles written to out, using the smallest kernel that fits;
+* nodes.size() must not exceed SMALL_KERNEL_LIMIT and out must hold 2 * nodes.size() triples */
+static inline int triangulateSmall(std::span<const Node> nodes, std::array<int, 3>* out)
+{
+    // default initialized, so the arrays are not zeroed first
+    if(nodes.size() <= 8)
+    {
+        SmallTriangulation<8> kernel;
+        return kernel.triangulate(nodes, out);
+    }
+    if(nodes.size() <= 16)
+    {
+        SmallTriangulation<16> kernel;
+        return kernel.triangulate(nodes, out);
+    }
+    SmallTriangulation<SMALL_KERNEL_LIMIT> kernel;
+    return kernel.triangulate(nodes, out);
+}
+
+#endif // SMALLTRIANGULATION_H
@@ -0,0 +1,256 @@
+#include "snapshot.h"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "trace.h"
+
+static_assert(sizeof(Mesh::Face) == 6 * sizeof(std::int32_t), "faces are stored as they are laid out in memory");
+
+template <typename T>
+static bool writeValue(std::FILE* file, const T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    return std::fwrite(&value, sizeof(T), 1, file) == 1;
+}
+
+template <typename T>
+static bool writeArray(std::FILE* file, const std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::uint64_t count = values.size();
+    return writeValue(file, count) && (count == 0 || std::fwrite(values.data(), sizeof(T), values.size(), file) == values.size());
+}
+
+template <typename T>
+static bool readValue(std::FILE* file, T* value)
+{
+    return std::fread(value, sizeof(T), 1, file) == 1;
+}
+
+/// remaining is what is left of the file, a damaged count cannot make us allocate more than that
+template <typename T>
+static bool readArray(std::FILE* file, std::uintmax_t* remaining, std::vector<T>* values)
+{
+    std::uint64_t count;
+    if(!readValue(file, &count) || *remaining < sizeof(count) || count > (*remaining - sizeof(count)) / sizeof(T))
+        return false;
+    *remaining -= sizeof(count) + count * sizeof(T);
+    values->resize(static_cast<std::size_t>(count));
+    return count == 0 || std::fread(values->data(), sizeof(T), values->size(), file) == values->size();
+}
+
+static bool writeHeader(std::FILE* file, Snapshot::Kind kind, std::uint32_t levels)
+{
+    return std::fwrite(Snapshot::MAGIC, 1, sizeof(Snapshot::MAGIC), file) == sizeof(Snapshot::MAGIC)
+        && writeValue(file, Snapshot::VERSION) && writeValue(file, static_cast<std::uint32_t>(kind)) && writeValue(file, levels);
+}
+
+/// @return the level count, or 0 if the header does not match
+static std::uint32_t readHeader(std::FILE* file, Snapshot::Kind kind)
+{
+    char magic[sizeof(Snapshot::MAGIC)];
+    std::uint32_t version, stored, levels;
+    if(std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, Snapshot::MAGIC, sizeof(magic)) != 0)
+        return 0;
+    if(!readValue(file, &version) || version != Snapshot::VERSION || !readValue(file, &stored) || stored != static_cast<std::uint32_t>(kind))
+        return 0;
+    return readValue(file, &levels) ? levels : 0;
+}
+
+/// the whole file as remaining budget, or nothing if it cannot be opened
+static std::FILE* openForRestore(const char* path, std::uintmax_t* remaining)
+{
+    if constexpr(std::endian::native != std::endian::little)
+        return nullptr;
+    std::error_code code;
+    *remaining = std::filesystem::file_size(path, code);
+    return code ? nullptr : std::fopen(path, "rb");
+}
+
+bool Snapshot::writeMesh(std::FILE* file, const Mesh& mesh)
+{
+    return writeValue(file, static_cast<std::int32_t>(mesh.engine)) && writeValue(file, static_cast<std::int32_t>(mesh.lastFace))
+        && writeArray(file, mesh.vertices) && writeArray(file, mesh.faces)
+        && writeArray(file, mesh.vertexFace) && writeArray(file, mesh.freeFaces) && writeArray(file, mesh.freeVertices);
+}
+
+bool Snapshot::readMesh(std::FILE* file, std::uintmax_t* remaining, Mesh* mesh)
+{
+    std::int32_t engine, lastFace;
+    if(!readValue(file, &engine) || !readValue(file, &lastFace) || *remaining < 2 * sizeof(std::int32_t))
+        return false;
+    *remaining -= 2 * sizeof(std::int32_t);
+    if(!readArray(file, remaining, &mesh->vertices) || !readArray(file, remaining, &mesh->faces)
+        || !readArray(file, remaining, &mesh->vertexFace) || !readArray(file, remaining, &mesh->freeFaces)
+        || !readArray(file, remaining, &mesh->freeVertices))
+        return false;
+    if(mesh->vertexFace.size() != mesh->vertices.size() || mesh->vertices.size() < 3 || lastFace < Mesh::NONE
+        || lastFace >= static_cast<std::int32_t>(mesh->faces.size()) || !checkIndices(*mesh))
+        return false;
+
+    mesh->engine = engine == Mesh::FLIP_ENGINE ? Mesh::FLIP_ENGINE : Mesh::CAVITY_ENGINE;
+    mesh->lastFace = lastFace;
+    // scratch only, it regrows on the first cavity search
+    mesh->faceMark.clear();
+    mesh->markStamp = 0;
+    return true;
+}
+
+/// @return true for NONE, or an index in [0, size) when not
+static inline bool isIndex(int index, std::size_t size, bool none) noexcept
+{
+    return index == Mesh::NONE ? none : index >= 0 && static_cast<std::size_t>(index) < size;
+}
+
+/// @return true if every entry of links is NONE or a vertex of the level it points to
+static bool isLinks(const std::vector<int>& links, std::size_t vertexCount)
+{
+    for(int v : links)
+    {
+        if(!isIndex(v, vertexCount, true))
+            return false;
+    }
+    return true;
+}
+
+bool Snapshot::checkIndices(const Mesh& mesh)
+{
+    std::size_t vertexCount = mesh.vertices.size(), faceCount = mesh.faces.size();
+    for(const Mesh::Face& face : mesh.faces)
+    {
+        // a free slot keeps the links it had, nothing reads them
+        if(face.v[0] == Mesh::NONE)
+            continue;
+        for(int i = 0; i < 3; i++)
+        {
+            if(!isIndex(face.v[i], vertexCount, false) || !isIndex(face.adj[i], faceCount, true))
+                return false;
+        }
+    }
+    for(int face : mesh.vertexFace)
+    {
+        if(!isIndex(face, faceCount, true))
+            return false;
+    }
+
+    // free slots are dead and listed once, super vertices are never free
+    std::vector<unsigned char> listed(faceCount, 0);
+    for(int face : mesh.freeFaces)
+    {
+        if(!isIndex(face, faceCount, false) || mesh.faces[face].v[0] != Mesh::NONE || listed[face]++ != 0)
+            return false;
+    }
+    listed.assign(vertexCount, 0);
+    for(int vertex : mesh.freeVertices)
+    {
+        if(!isIndex(vertex, vertexCount, false) || mesh.isSuperVertex(vertex) || mesh.vertexFace[vertex] != Mesh::NONE
+            || listed[vertex]++ != 0)
+            return false;
+    }
+    return true;
+}
+
+bool Snapshot::save(const char* path, const Mesh& mesh)
+{
+    TRACE_SCOPE("saveSnapshot");
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return false;
+    bool ok = writeHeader(file, MESH_SNAPSHOT, 1) && writeMesh(file, mesh);
+    return std::fclose(file) == 0 && ok;
+}
+
+bool Snapshot::restore(const char* path, Mesh* mesh)
+{
+    TRACE_SCOPE("restoreSnapshot");
+    std::uintmax_t remaining;
+    std::FILE* file = openForRestore(path, &remaining);
+    if(file == nullptr)
+        return false;
+
+    Mesh restored;
+    bool ok = readHeader(file, MESH_SNAPSHOT) == 1 && readMesh(file, &remaining, &restored);
+    std::fclose(file);
+    if(ok)
+    {
+        // the journals stay with the target, which keeps no handle from before
+        std::vector<MeshJournal*> journals = std::move(mesh->journals);
+        *mesh = std::move(restored);
+        mesh->journals = std::move(journals);
+        for(MeshJournal* journal : mesh->journals)
+        {
+            journal->reset();
+            journal->cleared = true;
+        }
+    }
+    return ok;
+}
+
+bool Snapshot::save(const char* path, const DelaunayHierarchy& hierarchy)
+{
+    TRACE_SCOPE("saveSnapshot");
+    std::FILE* file = std::fopen(path, "wb");
+    if(file == nullptr)
+        return false;
+
+    std::uint32_t levels = static_cast<std::uint32_t>(hierarchy.levels.size());
+    bool ok = writeHeader(file, HIERARCHY_SNAPSHOT, levels);
+    for(std::uint32_t k = 0; ok && k < levels; k++)
+        ok = writeMesh(file, hierarchy.levels[k]);
+    for(std::uint32_t k = 0; ok && k < levels; k++)
+        ok = writeArray(file, hierarchy.down[k]) && writeArray(file, hierarchy.up[k]);
+    if(ok)
+    {
+        std::ostringstream state;
+        state << hierarchy.rng;
+        std::string text = state.str();
+        ok = writeArray(file, std::vector<char>(text.begin(), text.end()));
+    }
+    return std::fclose(file) == 0 && ok;
+}
+
+bool Snapshot::restore(const char* path, DelaunayHierarchy* hierarchy)
+{
+    TRACE_SCOPE("restoreSnapshot");
+    std::uintmax_t remaining;
+    std::FILE* file = openForRestore(path, &remaining);
+    if(file == nullptr)
+        return false;
+
+    DelaunayHierarchy restored;
+    std::uint32_t levels = readHeader(file, HIERARCHY_SNAPSHOT);
+    bool ok = levels == restored.levels.size();
+    for(std::uint32_t k = 0; ok && k < levels; k++)
+        ok = readMesh(file, &remaining, &restored.levels[k]);
+    for(std::uint32_t k = 0; ok && k < levels; k++)
+        ok = readArray(file, &remaining, &restored.down[k]) && readArray(file, &remaining, &restored.up[k]);
+    // a level is walked through the links of the one above, indexed by its own vertices
+    for(std::uint32_t k = 0; ok && k < levels; k++)
+    {
+        std::size_t vertexCount = restored.levels[k].vertices.size();
+        ok = restored.up[k].size() == vertexCount && (k == 0 || restored.down[k].size() == vertexCount)
+            && (k + 1 == levels || isLinks(restored.up[k], restored.levels[k + 1].vertices.size()))
+            && (k == 0 || isLinks(restored.down[k], restored.levels[k - 1].vertices.size()));
+    }
+    std::vector<char> text;
+    if(ok && readArray(file, &remaining, &text))
+    {
+        std::istringstream state(std::string(text.begin(), text.end()));
+        state >> restored.rng;
+        ok = !state.fail();
+    }
+    else
+        ok = false;
+    std::fclose(file);
+    if(ok)
+        *hierarchy = std::move(restored);
+    return ok;
+}
@@ -0,0 +1,46 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include "mesh.h"
+#include "hierarchy.h"
+
+/** Saves and restores the complete state of a triangulation, so a restart does not
+* retriangulate. A snapshot holds every face slot with its adjacency, the free lists,
+* the incident face of every vertex and the last touched face that seeds the next walk;
+* a hierarchy snapshot adds each level, the links between levels and the generator
+* that picks the levels of new vertices. Restoring is a bulk read of those arrays:
+* no predicate runs, and the result continues exactly as the saved object would.
+* Layout, little-endian: the 8 byte MAGIC, VERSION and Kind as uint32, the level count
+* as uint32, then per level the engine and last face as int32 followed by the vertex,
+* face, vertex face, free face and free vertex arrays, each a uint64 count then its elements.
+* A hierarchy then stores its down and up arrays per level the same way and the text
+* state of its std::mt19937 as a counted string. */
+class Snapshot
+{
+public:
+    static constexpr char MAGIC[8] = {'S', 'N', 'A', 'P', 'S', 'H', 'O', 'T'};
+    /// bumped whenever the layout changes, older snapshots are refused rather than misread
+    static constexpr std::uint32_t VERSION = 2;
+
+    enum Kind {MESH_SNAPSHOT, HIERARCHY_SNAPSHOT};
+
+    static bool save(const char* path, const Mesh& mesh);
+    static bool save(const char* path, const DelaunayHierarchy& hierarchy);
+    /// @return false and leaves the target unchanged if the file is missing, of another kind or
+    /// version, truncated, or holds an index out of range
+    static bool restore(const char* path, Mesh* mesh);
+    static bool restore(const char* path, DelaunayHierarchy* hierarchy);
+
+private:
+    static bool writeMesh(std::FILE* file, const Mesh& mesh);
+    /// remaining is what is left of the file, counts beyond it are refused before allocating
+    static bool readMesh(std::FILE* file, std::uintmax_t* remaining, Mesh* mesh);
+    /// @return true if every vertex, face and free list index of mesh is in range or NONE where
+    /// that is allowed, so a damaged snapshot cannot send a walk out of the arrays
+    static bool checkIndices(const Mesh& mesh);
+};
+
+#endif // SNAPSHOT_H
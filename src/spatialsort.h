@@ -0,0 +1,91 @@
+#ifndef SPATIALSORT_H
+#define SPATIALSORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "node.h"
+
+/**==============================================
+*@return the distance of cell (x, y) along a Hilbert curve filling a 2^16 x 2^16 grid */
+static inline std::uint32_t hilbertIndex(std::uint32_t x, std::uint32_t y) noexcept
+{
+    std::uint32_t d = 0;
+    for(std::uint32_t s = 1u << 15; s > 0; s >>= 1)
+    {
+        std::uint32_t rx = (x & s) > 0;
+        std::uint32_t ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant so the curve stays continuous
+        if(ry == 0)
+        {
+            if(rx == 1)
+            {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+/**==============================================
+* fills keys with the Hilbert index of every node, quantized over the nodes' bounding box */
+static inline void hilbertKeys(std::span<const Node> nodes, std::vector<std::uint32_t>* keys)
+{
+    keys->resize(nodes.size());
+    if(nodes.empty())
+        return;
+
+    Node lo = nodes[0], hi = nodes[0];
+    for(const Node& n : nodes)
+    {
+        lo = Node(std::min(lo.x, n.x), std::min(lo.y, n.y));
+        hi = Node(std::max(hi.x, n.x), std::max(hi.y, n.y));
+    }
+    const float CELLS = 65535.0f;
+    float sx = hi.x > lo.x ? CELLS / (hi.x - lo.x) : 0.0f;
+    float sy = hi.y > lo.y ? CELLS / (hi.y - lo.y) : 0.0f;
+
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        std::uint32_t x = static_cast<std::uint32_t>((nodes[i].x - lo.x) * sx);
+        std::uint32_t y = static_cast<std::uint32_t>((nodes[i].y - lo.y) * sy);
+        (*keys)[i] = hilbertIndex(std::min(x, 65535u), std::min(y, 65535u));
+    }
+}
+
+/**==============================================
+* fills order with the indices of nodes sorted along a Hilbert curve, equal nodes end up
+* adjacent; keys is scratch, both keep their memory for the next call */
+static inline void hilbertOrder(std::span<const Node> nodes, std::vector<int>* order, std::vector<std::uint32_t>* keys)
+{
+    hilbertKeys(nodes, keys);
+    const std::vector<std::uint32_t>& key = *keys;
+    order->resize(nodes.size());
+    std::iota(order->begin(), order->end(), 0);
+    std::sort(order->begin(), order->end(), [&](int a, int b)
+    {
+        if(key[a] != key[b])
+            return key[a] < key[b];
+        if(nodes[a].x != nodes[b].x)
+            return nodes[a].x < nodes[b].x;
+        return nodes[a].y < nodes[b].y;
+    });
+}
+
+/**==============================================
+*@return the indices of nodes sorted along a Hilbert curve, equal nodes end up adjacent */
+static inline std::vector<int> hilbertOrder(std::span<const Node> nodes)
+{
+    std::vector<int> order;
+    std::vector<std::uint32_t> keys;
+    hilbertOrder(nodes, &order, &keys);
+    return order;
+}
+
+#endif // SPATIALSORT_H
@@ -0,0 +1,151 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** Counters of the insertion hot path.
+* They are only compiled in when TRIANGULATION_STATS is defined; otherwise every
+* STATS_ macro below expands to nothing and the engines carry no trace of them.
+* Each thread counts into its own instance, read it with triangulationStats()
+* after a run and reset() it before the next one. */
+class TriangulationStats
+{
+public:
+    enum Phase {SORT, LOCATE, CAVITY, RETRIANGULATE, EXTRACT, PHASE_COUNT};
+    /// cavity sizes of HISTOGRAM_SIZE faces or more share the last bucket
+    static const int HISTOGRAM_SIZE = 32;
+
+    std::uint64_t orientTests = 0;
+    std::uint64_t orientExact = 0;       // orientation tests the filter could not decide
+    std::uint64_t inCircleTests = 0;
+    std::uint64_t inCircleExact = 0;     // in-circle tests the filter could not decide
+    std::uint64_t locations = 0;
+    std::uint64_t walkSteps = 0;         // faces visited by all locations
+    std::uint64_t cavities = 0;
+    std::uint64_t boundaryEdges = 0;     // edges of all cavity boundaries, one new face each
+    std::uint64_t flips = 0;
+    std::uint64_t facesAllocated = 0;
+    std::uint64_t facesFreed = 0;
+    std::array<std::uint64_t, HISTOGRAM_SIZE> cavitySizes{};
+    std::array<std::uint64_t, PHASE_COUNT> phaseCycles{};
+
+    void reset(void) noexcept
+    {
+        *this = TriangulationStats();
+    }
+
+    /// adds the counts of another thread
+    void merge(const TriangulationStats& other) noexcept
+    {
+        this->orientTests += other.orientTests;
+        this->orientExact += other.orientExact;
+        this->inCircleTests += other.inCircleTests;
+        this->inCircleExact += other.inCircleExact;
+        this->locations += other.locations;
+        this->walkSteps += other.walkSteps;
+        this->cavities += other.cavities;
+        this->boundaryEdges += other.boundaryEdges;
+        this->flips += other.flips;
+        this->facesAllocated += other.facesAllocated;
+        this->facesFreed += other.facesFreed;
+        for(int i = 0; i < HISTOGRAM_SIZE; i++)
+            this->cavitySizes[i] += other.cavitySizes[i];
+        for(int i = 0; i < PHASE_COUNT; i++)
+            this->phaseCycles[i] += other.phaseCycles[i];
+    }
+
+    /**==============================================
+    *@return the share of orientation and in-circle tests that needed exact arithmetic */
+    double exactFallbackRate(void) const noexcept
+    {
+        std::uint64_t tests = this->orientTests + this->inCircleTests;
+        return tests == 0 ? 0.0 : double(this->orientExact + this->inCircleExact) / tests;
+    }
+
+    static const char* phaseName(int phase) noexcept
+    {
+        static const char* const NAMES[PHASE_COUNT] = {"sort", "locate", "cavity", "retriangulate", "extract"};
+        return NAMES[phase];
+    }
+
+    friend std::ostream& operator << (std::ostream& out, const TriangulationStats& stats)
+    {
+        out << "orient tests     " << stats.orientTests << " (" << stats.orientExact << " exact)\n"
+            << "in-circle tests  " << stats.inCircleTests << " (" << stats.inCircleExact << " exact)\n"
+            << "exact fallback   " << stats.exactFallbackRate() * 100.0 << " %\n"
+            << "walk steps       " << stats.walkSteps << " over " << stats.locations << " locations\n"
+            << "cavities         " << stats.cavities << ", " << stats.boundaryEdges << " boundary edges\n"
+            << "flips            " << stats.flips << '\n'
+            << "faces            " << stats.facesAllocated << " allocated, " << stats.facesFreed << " freed\n"
+            << "cavity sizes    ";
+        for(int i = 1; i < HISTOGRAM_SIZE; i++)
+        {
+            if(stats.cavitySizes[i] > 0)
+                out << ' ' << i << (i + 1 == HISTOGRAM_SIZE ? "+:" : ":") << stats.cavitySizes[i];
+        }
+        out << "\ncycles          ";
+        for(int i = 0; i < PHASE_COUNT; i++)
+            out << ' ' << phaseName(i) << ':' << stats.phaseCycles[i];
+        return out << '\n';
+    }
+};
+
+/**==============================================
+*@return the counters of the calling thread, not static so every translation unit shares them */
+inline TriangulationStats& triangulationStats(void) noexcept
+{
+    static thread_local TriangulationStats stats;
+    return stats;
+}
+
+/**==============================================
+*@return a timestamp in cycles where the CPU offers a counter, in nanoseconds otherwise */
+static inline std::uint64_t cycleCount(void) noexcept
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/// adds the cycles from construction to destruction to one phase
+class ScopedPhase
+{
+public:
+    explicit ScopedPhase(TriangulationStats::Phase phase) noexcept : phase(phase), start(cycleCount()) {}
+
+    ~ScopedPhase()
+    {
+        triangulationStats().phaseCycles[this->phase] += cycleCount() - this->start;
+    }
+
+private:
+    TriangulationStats::Phase phase;
+    std::uint64_t start;
+};
+
+#ifdef TRIANGULATION_STATS
+// the predicates are constexpr, nothing is counted while the compiler evaluates them
+#define STATS_ADD(counter, value) do { if(!std::is_constant_evaluated()) triangulationStats().counter += (value); } while(0)
+#define STATS_CAVITY(size) do { triangulationStats().cavitySizes[std::min<std::size_t>((size), TriangulationStats::HISTOGRAM_SIZE - 1)]++; } while(0)
+#define STATS_PHASE(phase) ScopedPhase statsPhase(TriangulationStats::phase)
+#else
+#define STATS_ADD(counter, value) do {} while(0)
+#define STATS_CAVITY(size) do {} while(0)
+#define STATS_PHASE(phase) do {} while(0)
+#endif
+
+#endif // STATS_H
@@ -0,0 +1,86 @@
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include "node.h"
+#include "predicates.h"
+#include "smalltriangulation.h"
+
+/** Triangulation of a fixed point layout, computed at compile time.
+* triangles[0 .. count - 1] are counterclockwise index triples into the layout. */
+template <std::size_t N>
+class Stencil
+{
+public:
+    std::array<std::array<int, 3>, 2 * N> triangles{};
+    int count = 0;
+
+    constexpr std::span<const std::array<int, 3>> faces(void) const noexcept
+    {
+        return std::span<const std::array<int, 3>>(this->triangles.data(), this->count);
+    }
+};
+
+/**==============================================
+*@return the Delaunay triangulation of nodes, use it to initialize a constexpr variable */
+template <std::size_t N>
+constexpr Stencil<N> triangulateStencil(const std::array<Node, N>& nodes)
+{
+    Stencil<N> stencil;
+    SmallTriangulation<static_cast<int>(N)> kernel;
+    stencil.count = kernel.triangulate(nodes, stencil.triangles.data());
+    return stencil;
+}
+
+/**==============================================
+*@return true if every triangle of the stencil is counterclockwise and no node
+* lies strictly inside the circumcircle of any of them */
+template <std::size_t N>
+constexpr bool isDelaunay(const std::array<Node, N>& nodes, const Stencil<N>& stencil)
+{
+    for(const std::array<int, 3>& t : stencil.faces())
+    {
+        if(orient2d(nodes[t[0]], nodes[t[1]], nodes[t[2]]) <= 0.0)
+            return false;
+        for(const Node& n : nodes)
+        {
+            if(inCircle(nodes[t[0]], nodes[t[1]], nodes[t[2]], n) > 0.0)
+                return false;
+        }
+    }
+    return true;
+}
+
+/// five point finite difference cross
+inline constexpr std::array<Node, 5> CROSS_STENCIL = {
+    Node(0.0f, 0.0f), Node(1.0f, 0.0f), Node(0.0f, 1.0f), Node(-1.0f, 0.0f), Node(0.0f, -1.0f)
+};
+
+/// nine point finite difference block
+inline constexpr std::array<Node, 9> BLOCK_STENCIL = {
+    Node(-1.0f, -1.0f), Node(0.0f, -1.0f), Node(1.0f, -1.0f),
+    Node(-1.0f,  0.0f), Node(0.0f,  0.0f), Node(1.0f,  0.0f),
+    Node(-1.0f,  1.0f), Node(0.0f,  1.0f), Node(1.0f,  1.0f)
+};
+
+/// seven point hexagonal stencil, the centre and its six unit neighbours
+inline constexpr std::array<Node, 7> HEXAGON_STENCIL = {
+    Node(0.0f, 0.0f),
+    Node(1.0f, 0.0f), Node(0.5f, 0.8660254f), Node(-0.5f, 0.8660254f),
+    Node(-1.0f, 0.0f), Node(-0.5f, -0.8660254f), Node(0.5f, -0.8660254f)
+};
+
+/// the triangles of the stencils above, nothing is computed at startup
+inline constexpr Stencil<5> CROSS_TRIANGLES = triangulateStencil(CROSS_STENCIL);
+inline constexpr Stencil<9> BLOCK_TRIANGLES = triangulateStencil(BLOCK_STENCIL);
+inline constexpr Stencil<7> HEXAGON_TRIANGLES = triangulateStencil(HEXAGON_STENCIL);
+
+// a triangulation of n nodes with h of them on the hull has 2n - h - 2 triangles
+static_assert(CROSS_TRIANGLES.count == 4 && isDelaunay(CROSS_STENCIL, CROSS_TRIANGLES));
+static_assert(BLOCK_TRIANGLES.count == 8 && isDelaunay(BLOCK_STENCIL, BLOCK_TRIANGLES));
+static_assert(HEXAGON_TRIANGLES.count == 6 && isDelaunay(HEXAGON_STENCIL, HEXAGON_TRIANGLES));
+
+#endif // STENCIL_H
@@ -0,0 +1,250 @@
+#include "streamingtriangulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "trace.h"
+
+StreamingTriangulator::StreamingTriangulator(const Node& minCorner, const Node& maxCorner, int columns, int rows, Sink sink)
+    : mesh(minCorner, maxCorner), sink(std::move(sink)), minCorner(minCorner), maxCorner(maxCorner),
+      columns(std::max(columns, 1)), rows(std::max(rows, 1)),
+      cellWidth(std::max(double(maxCorner.x) - minCorner.x, 1e-30) / std::max(columns, 1)),
+      cellHeight(std::max(double(maxCorner.y) - minCorner.y, 1e-30) / std::max(rows, 1)),
+      finalized(static_cast<std::size_t>(this->columns) * this->rows, 0), waiting(finalized.size()),
+      ids(3, NO_ID), references(3, 0)
+{
+    this->mesh.setEngine(Mesh::CAVITY_ENGINE);
+}
+
+int StreamingTriangulator::cellOf(const Node& n) const noexcept
+{
+    if(!(n.x >= this->minCorner.x && n.x <= this->maxCorner.x && n.y >= this->minCorner.y && n.y <= this->maxCorner.y))
+        return Mesh::NONE;
+    int x = std::min(static_cast<int>((double(n.x) - this->minCorner.x) / this->cellWidth), this->columns - 1);
+    int y = std::min(static_cast<int>((double(n.y) - this->minCorner.y) / this->cellHeight), this->rows - 1);
+    return y * this->columns + x;
+}
+
+bool StreamingTriangulator::circleCells(int face, int* x0, int* y0, int* x1, int* y1) const
+{
+    if(this->mesh.isSuperFace(face))
+        return false;
+    const Mesh::Face& f = this->mesh.faces[face];
+    const Node& a = this->mesh.vertices[f.v[0]];
+    const Node& b = this->mesh.vertices[f.v[1]];
+    const Node& c = this->mesh.vertices[f.v[2]];
+
+    // circumcentre relative to a, in double from float input
+    double bx = double(b.x) - a.x, by = double(b.y) - a.y;
+    double cx = double(c.x) - a.x, cy = double(c.y) - a.y;
+    double d = 2.0 * (bx * cy - by * cx);
+    if(!(d > 0.0))
+        return false;
+    double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+    double ux = (cy * b2 - by * c2) / d, uy = (bx * c2 - cx * b2) / d;
+    double r = std::sqrt(ux * ux + uy * uy);
+    ux += a.x;
+    uy += a.y;
+    if(!std::isfinite(r))
+        return false;
+
+    // widen the circle well past the rounding of its centre, waiting a little longer is always safe
+    r += 1e-6 * (r + std::abs(ux) + std::abs(uy));
+    // no point is ever accepted outside the grid, so the part of the circle out there counts as finalized
+    // clamped before the conversion, slivers have circles far wider than int reaches in cells
+    auto column = [&](double x) { return static_cast<int>(std::clamp(std::floor((x - this->minCorner.x) / this->cellWidth), 0.0, this->columns - 1.0)); };
+    auto row = [&](double y) { return static_cast<int>(std::clamp(std::floor((y - this->minCorner.y) / this->cellHeight), 0.0, this->rows - 1.0)); };
+    *x0 = column(ux - r);
+    *x1 = column(ux + r);
+    *y0 = row(uy - r);
+    *y1 = row(uy + r);
+    return true;
+}
+
+void StreamingTriangulator::schedule(int face)
+{
+    int x0, y0, x1, y1;
+    if(!this->circleCells(face, &x0, &y0, &x1, &y1))
+        return; // finish() emits it
+
+    // scanning from the far corner, cells finalized in row order hold a face up only a few times
+    for(int y = y1; y >= y0; y--)
+    {
+        for(int x = x1; x >= x0; x--)
+        {
+            int cell = y * this->columns + x;
+            if(!this->finalized[cell])
+            {
+                this->waiting[cell].push_back(Waiting{face, this->mesh.faces[face].v});
+                return;
+            }
+        }
+    }
+    this->emit(face);
+}
+
+void StreamingTriangulator::emit(int face)
+{
+    const Mesh::Face f = this->mesh.faces[face];
+    StreamTriangle triangle;
+    for(int i = 0; i < 3; i++)
+    {
+        triangle.id[i] = this->ids[f.v[i]];
+        triangle.corner[i] = this->mesh.vertices[f.v[i]];
+    }
+    this->sink(triangle);
+    this->emitted++;
+
+    this->mesh.detach(face);
+    for(int i = 0; i < 3; i++)
+    {
+        if(--this->references[f.v[i]] == 0 && !this->mesh.isSuperVertex(f.v[i]))
+            this->mesh.releaseVertex(f.v[i]);
+    }
+}
+
+int StreamingTriangulator::locate(const Node& n, int cell)
+{
+    int face = this->mesh.locate(n, this->mesh.getLastFace());
+    if(face != Mesh::NONE)
+        return face;
+
+    // the walk ran into a freed region, retry from a face whose circumcircle reaches into the cell of n
+    const std::vector<Waiting>& near = this->waiting[cell];
+    for(auto w = near.rbegin(); w != near.rend(); w++)
+    {
+        if(this->mesh.isAlive(w->face) && this->mesh.faces[w->face].v == w->v)
+        {
+            face = this->mesh.locate(n, w->face);
+            if(face != Mesh::NONE)
+                return face;
+            break;
+        }
+    }
+
+    // n is in an unfinalized cell, so some face left contains it
+    this->fallbacks++;
+    for(int f = 0; f < static_cast<int>(this->mesh.faces.size()); f++)
+    {
+        if(!this->mesh.isAlive(f))
+            continue;
+        const Mesh::Face& candidate = this->mesh.faces[f];
+        if(this->mesh.orient(candidate.v[1], candidate.v[2], n) >= 0.0 && this->mesh.orient(candidate.v[2], candidate.v[0], n) >= 0.0
+            && this->mesh.orient(candidate.v[0], candidate.v[1], n) >= 0.0)
+            return f;
+    }
+    return Mesh::NONE;
+}
+
+std::uint64_t StreamingTriangulator::insert(const Node& n, std::uint64_t id)
+{
+    int cell = this->cellOf(n);
+    if(cell == Mesh::NONE || this->finalized[cell])
+    {
+        this->rejected++;
+        return NO_ID;
+    }
+
+    int face = this->locate(n, cell);
+    if(face == Mesh::NONE)
+    {
+        this->rejected++;
+        return NO_ID;
+    }
+    for(int i = 0; i < 3; i++)
+    {
+        int v = this->mesh.faces[face].v[i];
+        if(!this->mesh.isSuperVertex(v) && this->mesh.vertices[v] == n)
+            return this->ids[v];
+    }
+
+    // the cavity vertices all lie on its boundary, so none of them runs out of faces here
+    this->mesh.findCavity(n, face);
+    for(int bad : this->mesh.getCavity())
+    {
+        for(int v : this->mesh.faces[bad].v)
+            this->references[v]--;
+    }
+    int vertex = this->mesh.fillCavity(n);
+    if(vertex >= static_cast<int>(this->ids.size()))
+    {
+        this->ids.resize(vertex + 1, NO_ID);
+        this->references.resize(vertex + 1, 0);
+    }
+    this->ids[vertex] = id;
+
+    for(const Mesh::BoundaryEdge& e : this->mesh.getBoundary())
+    {
+        for(int v : this->mesh.faces[e.created].v)
+            this->references[v]++;
+    }
+    // a new face has n on its circle, and n lies in an unfinalized cell, so none is emitted here
+    for(const Mesh::BoundaryEdge& e : this->mesh.getBoundary())
+        this->schedule(e.created);
+    return id;
+}
+
+void StreamingTriangulator::finalize(int cell)
+{
+    TRACE_SCOPE("finalize");
+    if(cell < 0 || cell >= this->cellCount() || this->finalized[cell])
+        return;
+    this->finalized[cell] = 1;
+
+    // swapping the list out also returns its memory
+    std::vector<Waiting> queue;
+    queue.swap(this->waiting[cell]);
+    for(const Waiting& w : queue)
+    {
+        // faces destroyed since they started waiting are skipped, their slots may hold other faces now
+        if(this->mesh.isAlive(w.face) && this->mesh.faces[w.face].v == w.v)
+            this->schedule(w.face);
+    }
+}
+
+void StreamingTriangulator::finish(void)
+{
+    TRACE_SCOPE("finish");
+    std::fill(this->finalized.begin(), this->finalized.end(), 1);
+    for(std::vector<Waiting>& list : this->waiting)
+        std::vector<Waiting>().swap(list);
+    for(int f = 0; f < static_cast<int>(this->mesh.faces.size()); f++)
+    {
+        if(this->mesh.isAlive(f) && !this->mesh.isSuperFace(f))
+            this->emit(f);
+    }
+}
+
+void StreamingTriangulator::triangulate(std::span<const Node> nodes)
+{
+    TRACE_SCOPE("streamingTriangulate");
+    // a counting sort by cell stands in for the spatial finalizer in front of a real stream
+    int cells = this->cellCount();
+    std::vector<std::size_t> start(cells + 1, 0);
+    std::vector<int> cellOfNode(nodes.size());
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        cellOfNode[i] = this->cellOf(nodes[i]);
+        if(cellOfNode[i] != Mesh::NONE)
+            start[cellOfNode[i] + 1]++;
+        else
+            this->rejected++;
+    }
+    for(int c = 0; c < cells; c++)
+        start[c + 1] += start[c];
+    std::vector<std::size_t> order(start[cells]);
+    std::vector<std::size_t> fill(start.begin(), start.end() - 1);
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        if(cellOfNode[i] != Mesh::NONE)
+            order[fill[cellOfNode[i]]++] = i;
+    }
+
+    for(int c = 0; c < cells; c++)
+    {
+        for(std::size_t k = start[c]; k < start[c + 1]; k++)
+            this->insert(nodes[order[k]], order[k]);
+        this->finalize(c);
+    }
+    this->finish();
+}
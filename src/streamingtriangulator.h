@@ -0,0 +1,121 @@
+#ifndef STREAMINGTRIANGULATOR_H
+#define STREAMINGTRIANGULATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+
+/// a triangle leaving the streaming triangulator, counter-clockwise
+class StreamTriangle
+{
+public:
+    std::array<std::uint64_t, 3> id; // the ids the corners were inserted with
+    std::array<Node, 3> corner;
+};
+
+/** Delaunay triangulation of a point stream that only keeps its frontier in memory,
+* after Isenburg et al., "Streaming Computation of Delaunay Triangulations", 2006.
+* The bounds are split into a grid of cells and the stream interleaves points with
+* finalization markers: finalize(cell) promises that no later point falls in that cell.
+* A triangle whose circumcircle lies entirely in finalized cells can never be destroyed
+* by a later point, so it is handed to the sink at once and its face freed; a vertex is
+* freed with its last face. Every face waits on one unfinalized cell its circumcircle
+* overlaps and is checked again only when that cell is finalized, so the work per
+* triangle stays constant and memory scales with the unfinalized frontier, not with n.
+* The mesh runs the cavity engine, whose cavities give the faces each insertion
+* creates and destroys. */
+class StreamingTriangulator
+{
+public:
+    static constexpr std::uint64_t NO_ID = ~std::uint64_t(0);
+
+    typedef std::function<void(const StreamTriangle&)> Sink;
+
+    StreamingTriangulator(const Node& minCorner, const Node& maxCorner, int columns, int rows, Sink sink);
+
+    /// @return id, the id of an equal point inserted before, or NO_ID if n lies outside the grid or in a finalized cell
+    std::uint64_t insert(const Node& n, std::uint64_t id);
+    /// promises that no later point falls in the cell and emits every triangle that became final
+    void finalize(int cell);
+    /// finalizes the cells left and emits every remaining triangle
+    void finish(void);
+    /// streams nodes cell by cell in row order, each cell finalized after its last node, ids are input positions
+    void triangulate(std::span<const Node> nodes);
+
+    /// @return the cell containing n, row * columns + column, or Mesh::NONE outside the grid
+    int cellOf(const Node& n) const noexcept;
+
+    inline int cellCount(void) const noexcept
+    {
+        return this->columns * this->rows;
+    }
+
+    /// @return the most faces held at once, the face slots the mesh ever allocated
+    inline std::size_t getPeakFaces(void) const noexcept
+    {
+        return this->mesh.faces.size();
+    }
+
+    /// @return the most vertices held at once, super vertices included
+    inline std::size_t getPeakVertices(void) const noexcept
+    {
+        return this->mesh.vertices.size();
+    }
+
+    inline std::uint64_t getEmitted(void) const noexcept
+    {
+        return this->emitted;
+    }
+
+    /// @return the points refused for lying outside the grid or in a finalized cell
+    inline std::uint64_t getRejected(void) const noexcept
+    {
+        return this->rejected;
+    }
+
+    /// @return the locations whose walks ran into freed regions and fell back to a scan of the frontier
+    inline std::uint64_t getLocateFallbacks(void) const noexcept
+    {
+        return this->fallbacks;
+    }
+
+private:
+    /// a face as it was when it started waiting, it is stale once the slot holds other vertices
+    class Waiting
+    {
+    public:
+        int face;
+        std::array<int, 3> v;
+    };
+
+    /// finds the cells covered by the circumcircle of a face
+    /// @return false if the circle is degenerate or leaves the grid, the face then waits for finish()
+    bool circleCells(int face, int* x0, int* y0, int* x1, int* y1) const;
+    /// queues a face on the first unfinalized cell under its circumcircle, or emits it if there is none
+    void schedule(int face);
+    void emit(int face);
+    int locate(const Node& n, int cell);
+
+    Mesh mesh;
+    Sink sink;
+    Node minCorner, maxCorner;
+    int columns, rows;
+    double cellWidth, cellHeight;
+
+    std::vector<unsigned char> finalized;
+    std::vector<std::vector<Waiting>> waiting; // faces each cell holds up
+    std::vector<std::uint64_t> ids;            // id of the point in each vertex slot
+    std::vector<int> references;               // faces using each vertex slot
+
+    std::uint64_t emitted = 0;
+    std::uint64_t rejected = 0;
+    std::uint64_t fallbacks = 0;
+};
+
+#endif // STREAMINGTRIANGULATOR_H
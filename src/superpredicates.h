@@ -0,0 +1,148 @@
+#ifndef SUPERPREDICATES_H
+#define SUPERPREDICATES_H
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "node.h"
+#include "predicates.h"
+
+/** The super vertices are handled symbolically: super vertex i lies infinitely far
+* away in direction DIRECTIONS[i], and each one is infinitely farther than the one
+* before it. Every predicate below is the sign its determinant takes in that limit,
+* so no circumcircle of inserted nodes can ever contain a super vertex and the
+* finite faces are exactly the Delaunay triangulation of the inserted nodes. */
+static constexpr float DIRECTIONS[3][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {0.0f, 1.0f}};
+
+/// a node, or super vertex `super` when node is null
+class SymbolicPoint
+{
+public:
+    const Node* node;
+    int super;
+};
+
+static constexpr double signOf(double value) noexcept
+{
+    return value > 0.0 ? 1.0 : value < 0.0 ? -1.0 : 0.0;
+}
+
+/**==============================================
+*@return the sign of (q - p) x DIRECTIONS[i] */
+static constexpr double crossDirection(const Node& p, const Node& q, int i)
+{
+    double ux = DIRECTIONS[i][0], uy = DIRECTIONS[i][1];
+    double dx = double(q.x) - p.x, dy = double(q.y) - p.y;
+    double det = dx * uy - dy * ux;
+    double errBound = 3.0 * predicates::EPSILON * (predicates::absolute(dx * uy) + predicates::absolute(dy * ux));
+    if(det > errBound || -det > errBound)
+        return signOf(det);
+
+    predicates::Expansion ex = predicates::difference(q.x, p.x), ey = predicates::difference(q.y, p.y);
+    return predicates::sign(predicates::sum(predicates::scale(ex, uy), predicates::negate(predicates::scale(ey, ux))));
+}
+
+/**==============================================
+*@return true if d, collinear with p and q, lies strictly between them */
+static constexpr bool isBetween(const Node& p, const Node& q, const Node& d) noexcept
+{
+    if(p.x != q.x)
+        return std::min(p.x, q.x) < d.x && d.x < std::max(p.x, q.x);
+    return std::min(p.y, q.y) < d.y && d.y < std::max(p.y, q.y);
+}
+
+/**==============================================
+*@return true if d, on the line from p along DIRECTIONS[i], lies strictly ahead of p */
+static constexpr bool isAhead(const Node& p, int i, const Node& d) noexcept
+{
+    if(DIRECTIONS[i][0] != 0.0f)
+        return DIRECTIONS[i][0] > 0.0f ? d.x > p.x : d.x < p.x;
+    return DIRECTIONS[i][1] > 0.0f ? d.y > p.y : d.y < p.y;
+}
+
+static constexpr double symbolicOrient(SymbolicPoint a, SymbolicPoint b, SymbolicPoint c)
+{
+    // sort real nodes first and super vertices by index, tracking the permutation sign
+    std::array<SymbolicPoint, 3> pts = {a, b, c};
+    double sign = 1.0;
+    auto key = [](const SymbolicPoint& point) { return point.node ? -1 : point.super; };
+    for(int pass = 0; pass < 2; pass++)
+    {
+        for(int k = 0; k < 2 - pass; k++)
+        {
+            if(key(pts[k]) > key(pts[k + 1]))
+            {
+                std::swap(pts[k], pts[k + 1]);
+                sign = -sign;
+            }
+        }
+    }
+
+    if(pts[2].node)
+        return sign * orient2d(*pts[0].node, *pts[1].node, *pts[2].node);
+    if(pts[1].node)
+    {
+        // (q - p) x (R u - p) = R (q - p) x u + p x q
+        double o = crossDirection(*pts[0].node, *pts[1].node, pts[2].super);
+        if(o == 0.0)
+            o = signOf(orient2d(Node(0.0f, 0.0f), *pts[0].node, *pts[1].node));
+        return sign * o;
+    }
+    // the product of the two largest distances dominates: sign of u_i x u_j
+    int i = pts[1].super, j = pts[2].super;
+    return sign * signOf(DIRECTIONS[i][0] * DIRECTIONS[j][1] - DIRECTIONS[i][1] * DIRECTIONS[j][0]);
+}
+
+/// in-circle test of d against the counter-clockwise face a, b, c
+static constexpr double symbolicInCircle(SymbolicPoint a, SymbolicPoint b, SymbolicPoint c, SymbolicPoint d)
+{
+    int supers = (a.node ? 0 : 1) + (b.node ? 0 : 1) + (c.node ? 0 : 1);
+
+    if(supers == 0)
+        return d.node ? inCircle(*a.node, *b.node, *c.node, *d.node) : -1.0;
+    if(supers == 3)
+        return 1.0;
+
+    // rotate the face, which keeps its circle, so the real nodes come first
+    while(!a.node || (supers == 1 && !b.node))
+    {
+        SymbolicPoint t = a;
+        a = b;
+        b = c;
+        c = t;
+    }
+
+    if(supers == 1)
+    {
+        // the circle through p, q and a super vertex is the half-plane left of p -> q
+        if(!d.node)
+        {
+            // a nearer super vertex on the line p q is still far outside the chord
+            double o = d.super > c.super ? -1.0 : symbolicOrient(a, b, d);
+            return o != 0.0 ? o : -1.0;
+        }
+        double o = orient2d(*a.node, *b.node, *d.node);
+        if(o != 0.0)
+            return o;
+        if(*d.node == *a.node || *d.node == *b.node)
+            return 0.0;
+        return isBetween(*a.node, *b.node, *d.node) ? 1.0 : -1.0;
+    }
+
+    // two super vertices: the half-plane bounded by the line from p to the nearer one, on the farther one's side
+    SymbolicPoint nearer = b.super < c.super ? b : c;
+    SymbolicPoint farther = b.super < c.super ? c : b;
+    double side = symbolicOrient(a, nearer, farther);
+
+    if(!d.node)
+        return d.super > farther.super ? -1.0 : side * symbolicOrient(a, nearer, d);
+    double o = symbolicOrient(a, nearer, d);
+    if(o != 0.0)
+        return side * o;
+    if(*d.node == *a.node)
+        return 0.0;
+    return isAhead(*a.node, nearer.super, *d.node) ? 1.0 : -1.0;
+}
+
+#endif // SUPERPREDICATES_H
@@ -0,0 +1,92 @@
+#include "threadpool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : workerCount(std::max(threadCount, 1u)), ranges(new Range[std::max(threadCount, 1u)])
+{
+    for(unsigned int worker = 1; worker < this->workerCount; worker++)
+        this->threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for(std::thread& thread : this->threads)
+        thread.join();
+}
+
+void ThreadPool::runRanges(unsigned int worker)
+{
+    // own range first, then steal from the others in turn
+    for(unsigned int k = 0; k < this->workerCount; k++)
+    {
+        Range& range = this->ranges[(worker + k) % this->workerCount];
+        while(true)
+        {
+            std::size_t begin = range.next.fetch_add(this->grain, std::memory_order_relaxed);
+            if(begin >= range.end)
+                break;
+            (*this->task)(begin, std::min(begin + this->grain, range.end), worker);
+        }
+    }
+}
+
+void ThreadPool::workerLoop(unsigned int worker)
+{
+    unsigned int seen = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [&]() { return this->stopping || this->generation != seen; });
+            if(this->stopping)
+                return;
+            seen = this->generation;
+        }
+
+        this->runRanges(worker);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if(--this->running == 0)
+            this->finished.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain, const Task& task)
+{
+    if(count == 0)
+        return;
+    if(this->workerCount == 1 || count <= grain)
+    {
+        task(0, count, 0);
+        return;
+    }
+
+    std::size_t share = (count + this->workerCount - 1) / this->workerCount;
+    for(unsigned int worker = 0; worker < this->workerCount; worker++)
+    {
+        std::size_t begin = std::min(count, worker * share);
+        this->ranges[worker].next.store(begin, std::memory_order_relaxed);
+        this->ranges[worker].end = std::min(count, begin + share);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->task = &task;
+        this->grain = std::max<std::size_t>(grain, 1);
+        this->running = this->workerCount - 1;
+        this->generation++;
+    }
+    this->wake.notify_all();
+
+    this->runRanges(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->finished.wait(lock, [&]() { return this->running == 0; });
+    this->task = nullptr;
+}
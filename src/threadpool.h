@@ -0,0 +1,62 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** A fixed set of worker threads running parallel loops with work stealing.
+* Each loop is split into one contiguous range per worker; a worker claims
+* chunks from the front of its own range and, once that is empty, steals
+* chunks from the other ranges. The calling thread takes part as worker 0. */
+class ThreadPool
+{
+public:
+    /// task(begin, end, worker) processes the indices [begin, end)
+    typedef std::function<void(std::size_t, std::size_t, unsigned int)> Task;
+
+    explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator = (const ThreadPool&) = delete;
+
+    /// runs task over [0, count) in chunks of at most grain indices, returns when all are done
+    void parallelFor(std::size_t count, std::size_t grain, const Task& task);
+
+    inline unsigned int size(void) const noexcept
+    {
+        return this->workerCount;
+    }
+
+private:
+    class alignas(64) Range
+    {
+    public:
+        std::atomic<std::size_t> next;
+        std::size_t end;
+    };
+
+    void workerLoop(unsigned int worker);
+    void runRanges(unsigned int worker);
+
+    unsigned int workerCount;
+    std::vector<std::thread> threads;
+    std::unique_ptr<Range[]> ranges;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const Task* task = nullptr;
+    std::size_t grain = 1;
+    unsigned int generation = 0;
+    unsigned int running = 0;
+    bool stopping = false;
+};
+
+#endif // THREADPOOL_H
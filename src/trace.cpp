@@ -0,0 +1,72 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+Tracer& Tracer::instance(void)
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Buffer& Tracer::addBuffer(void)
+{
+    // buffers outlive their threads, so a dump still shows finished workers
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->buffers.push_back(std::make_unique<Buffer>());
+    this->buffers.back()->thread = static_cast<unsigned int>(this->buffers.size());
+    return *this->buffers.back();
+}
+
+void Tracer::dump(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    std::vector<Event> events;
+    bool first = true;
+
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - this->start).count();
+    std::uint64_t ticks = cycleCount() - this->startTicks;
+    double microseconds = ticks > 0 ? elapsed / double(ticks) : 0.0; // per tick
+
+    out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    for(const std::unique_ptr<Buffer>& buffer : this->buffers)
+    {
+        std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        std::uint64_t begin = head > CAPACITY ? head - CAPACITY : 0;
+        events.clear();
+        for(std::uint64_t i = begin; i < head; i++)
+            events.push_back(buffer->events[i % CAPACITY]);
+
+        // the owner kept recording while we copied, drop the slots it may have overwritten
+        std::uint64_t after = buffer->head.load(std::memory_order_acquire);
+        std::uint64_t valid = after >= CAPACITY ? after - CAPACITY + 1 : 0;
+        std::size_t skip = static_cast<std::size_t>(std::min<std::uint64_t>(valid > begin ? valid - begin : 0, events.size()));
+
+        for(std::size_t i = skip; i < events.size(); i++)
+        {
+            const Event& e = events[i];
+            out << (first ? "\n" : ",\n") << "{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                << buffer->thread << ", \"ts\": " << double(e.begin - this->startTicks) * microseconds
+                << ", \"dur\": " << double(e.end - e.begin) * microseconds << '}';
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+bool Tracer::dump(const char* path)
+{
+    std::ofstream out(path);
+    if(!out)
+        return false;
+    this->dump(out);
+    return static_cast<bool>(out);
+}
+
+void Tracer::clear(void)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for(const std::unique_ptr<Buffer>& buffer : this->buffers)
+        buffer->head.store(0, std::memory_order_relaxed);
+}
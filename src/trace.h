@@ -0,0 +1,113 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "stats.h"
+
+/** Timeline of scoped events, exported as Chrome trace JSON (chrome://tracing, Perfetto).
+* Every thread records into its own ring buffer, so recording takes no lock: only
+* the owning thread writes a buffer and it publishes each event by bumping an atomic
+* head. A buffer keeps the last CAPACITY events of its thread.
+* Nothing is recorded unless TRIANGULATION_TRACE is defined, and then TRACE_SCOPE
+* marks whole phases (sorting, batches, extraction, upload) at no measurable cost.
+* TRIANGULATION_TRACE=2 also turns on TRACE_DETAIL, one event per location, cavity
+* search and retriangulation, which costs about two clock reads per event. */
+class Tracer
+{
+public:
+    static const std::size_t CAPACITY = 1 << 16;
+
+    /// a complete event, times in ticks of cycleCount()
+    class Event
+    {
+    public:
+        const char* name; // must outlive the tracer, in practice a string literal
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    class alignas(64) Buffer
+    {
+    public:
+        std::array<Event, CAPACITY> events;
+        std::atomic<std::uint64_t> head{0}; // events ever written, the next slot is head % CAPACITY
+        unsigned int thread = 0;
+    };
+
+    static Tracer& instance(void);
+
+    /// a timestamp for record(), in cycles where the CPU offers a counter; dump() converts to time
+    inline std::uint64_t now(void) const noexcept
+    {
+        return cycleCount();
+    }
+
+    inline void record(const char* name, std::uint64_t begin, std::uint64_t end) noexcept
+    {
+        Buffer* buffer = Tracer::current;
+        if(buffer == nullptr)
+            buffer = Tracer::current = &this->addBuffer();
+        std::uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        buffer->events[head % CAPACITY] = Event{name, begin, end};
+        buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    /// writes every buffered event of every thread as Chrome trace JSON
+    void dump(std::ostream& out);
+    /// @return false if path could not be written
+    bool dump(const char* path);
+    /// drops the recorded events, threads must not be recording
+    void clear(void);
+
+private:
+    Tracer(void) : start(std::chrono::steady_clock::now()), startTicks(cycleCount()) {}
+
+    Buffer& addBuffer(void);
+
+    static inline thread_local Buffer* current = nullptr; // the calling thread's buffer once it has one
+
+    // both clocks read at start, and again at each dump, give the length of a tick
+    std::chrono::steady_clock::time_point start;
+    std::uint64_t startTicks;
+    std::mutex mutex; // guards buffers, only taken when a thread records its first event or on dump
+    std::vector<std::unique_ptr<Buffer>> buffers;
+};
+
+/// records the lifetime of a scope as one event
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace(const char* name) noexcept : name(name), begin(Tracer::instance().now()) {}
+
+    ~ScopedTrace()
+    {
+        Tracer& tracer = Tracer::instance();
+        tracer.record(this->name, this->begin, tracer.now());
+    }
+
+private:
+    const char* name;
+    std::uint64_t begin;
+};
+
+#ifdef TRIANGULATION_TRACE
+#define TRACE_SCOPE(name) ScopedTrace traceScope(name)
+#else
+#define TRACE_SCOPE(name) do {} while(0)
+#endif
+
+#if defined(TRIANGULATION_TRACE) && TRIANGULATION_TRACE >= 2
+#define TRACE_DETAIL(name) ScopedTrace traceDetail(name)
+#else
+#define TRACE_DETAIL(name) do {} while(0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,631 @@
+#include "triangulationservice.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "trace.h"
+
+static const int SUB_BITS = 3;
+static_assert(LatencyHistogram::SUB_BUCKETS == 1 << SUB_BITS, "a power of two is split into SUB_BUCKETS buckets");
+
+void LatencyHistogram::record(std::uint64_t micros) noexcept
+{
+    int bucket = static_cast<int>(micros);
+    if(micros >= SUB_BUCKETS)
+    {
+        int exponent = std::bit_width(micros) - 1;
+        int sub = static_cast<int>(micros >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+        bucket = (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+    this->buckets[bucket]++;
+    this->total++;
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const noexcept
+{
+    if(this->total == 0)
+        return 0;
+    std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * this->total)));
+    std::uint64_t seen = 0;
+    int bucket = 0;
+    while(bucket + 1 < static_cast<int>(this->buckets.size()) && (seen += this->buckets[bucket]) < target)
+        bucket++;
+    if(bucket < SUB_BUCKETS)
+        return static_cast<std::uint64_t>(bucket);
+    int exponent = bucket / SUB_BUCKETS + SUB_BITS - 1;
+    std::uint64_t sub = static_cast<std::uint64_t>(bucket % SUB_BUCKETS);
+    return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BITS)) - 1;
+}
+
+/// appends the bytes of a plain value to a reply
+template <typename T>
+static void append(std::vector<unsigned char>* out, const T& value)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+/// @return the payload as one plain value, false if its size does not match
+template <typename T>
+static bool read(const std::vector<unsigned char>& payload, T* value)
+{
+    if(payload.size() != sizeof(T))
+        return false;
+    std::memcpy(value, payload.data(), sizeof(T));
+    return true;
+}
+
+static inline bool isFinite(const Node& n) noexcept
+{
+    return std::isfinite(n.x) && std::isfinite(n.y);
+}
+
+static inline bool isValid(const Box& box) noexcept
+{
+    return isFinite(box.minCorner) && isFinite(box.maxCorner) && box.minCorner.x <= box.maxCorner.x && box.minCorner.y <= box.maxCorner.y;
+}
+
+static inline bool isInside(const Box& box, const Node& n) noexcept
+{
+    return n.x >= box.minCorner.x && n.x <= box.maxCorner.x && n.y >= box.minCorner.y && n.y <= box.maxCorner.y;
+}
+
+/// Liang-Barsky clipping of the segment p q against the closed box
+static bool segmentMeetsBox(const Node& p, const Node& q, const Box& box)
+{
+    double dx = double(q.x) - p.x, dy = double(q.y) - p.y;
+    double low = 0.0, high = 1.0;
+    auto clip = [&](double direction, double distance)
+    {
+        if(direction == 0.0)
+            return distance >= 0.0;
+        double t = distance / direction;
+        if(direction < 0.0)
+        {
+            if(t > high)
+                return false;
+            low = std::max(low, t);
+        }
+        else
+        {
+            if(t < low)
+                return false;
+            high = std::min(high, t);
+        }
+        return true;
+    };
+    return clip(-dx, double(p.x) - box.minCorner.x) && clip(dx, double(box.maxCorner.x) - p.x) &&
+           clip(-dy, double(p.y) - box.minCorner.y) && clip(dy, double(box.maxCorner.y) - p.y);
+}
+
+TriangulationService::TriangulationService(int window) : window(std::max(window, 0)), started(Clock::now())
+{
+}
+
+TriangulationService::~TriangulationService()
+{
+#if !defined(_WIN32)
+    for(const auto& [socket, client] : this->clients)
+        close(socket);
+    if(this->listener >= 0)
+    {
+        close(this->listener);
+        unlink(this->path.c_str());
+    }
+#endif
+}
+
+bool TriangulationService::fail(const std::string& message)
+{
+    this->error = message;
+    return false;
+}
+
+ServiceStats TriangulationService::getStats(void) const
+{
+    ServiceStats stats{};
+    stats.seconds = std::chrono::duration<double>(Clock::now() - this->started).count();
+    stats.connections = this->connections;
+    stats.meshes = this->meshes.size();
+    stats.batches = this->batches;
+    stats.insertedPoints = this->insertedPoints;
+    stats.bytesIn = this->bytesIn;
+    stats.bytesOut = this->bytesOut;
+    for(int i = 0; i < RequestHeader::OPCODE_COUNT; i++)
+    {
+        const LatencyHistogram& latency = this->latencies[i];
+        stats.opcodes[i].requests = latency.count();
+        stats.opcodes[i].p50Micros = static_cast<std::uint32_t>(std::min<std::uint64_t>(latency.percentile(0.5), UINT32_MAX));
+        stats.opcodes[i].p99Micros = static_cast<std::uint32_t>(std::min<std::uint64_t>(latency.percentile(0.99), UINT32_MAX));
+    }
+    return stats;
+}
+
+TriangulationService::Entry* TriangulationService::find(std::uint32_t mesh)
+{
+    auto it = this->meshes.find(mesh);
+    return it == this->meshes.end() ? nullptr : it->second.get();
+}
+
+#if defined(_WIN32)
+
+bool TriangulationService::listen(const char* path)
+{
+    (void)path;
+    return this->fail("the triangulation service needs POSIX sockets");
+}
+
+bool TriangulationService::run(void)
+{
+    return this->fail("the triangulation service needs POSIX sockets");
+}
+
+#else
+
+#if defined(MSG_NOSIGNAL)
+static const int SEND_FLAGS = MSG_NOSIGNAL; // a client gone is an error, not a SIGPIPE
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+static bool setNonBlocking(int socket)
+{
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool TriangulationService::listen(const char* path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(std::strlen(path) >= sizeof(address.sun_path))
+        return this->fail(std::string("socket path too long: ") + path);
+    std::strcpy(address.sun_path, path);
+
+    // a socket file left behind by a service that did not shut down cleanly
+    struct stat status;
+    if(lstat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+        unlink(path);
+
+    this->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(this->listener < 0)
+        return this->fail(std::string("cannot create a socket: ") + std::strerror(errno));
+    if(bind(this->listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+       ::listen(this->listener, SOMAXCONN) != 0 || !setNonBlocking(this->listener))
+    {
+        std::string reason = std::strerror(errno);
+        close(this->listener);
+        this->listener = -1;
+        return this->fail("cannot listen on " + std::string(path) + ": " + reason);
+    }
+    this->path = path;
+    return true;
+}
+
+bool TriangulationService::run(void)
+{
+    if(this->listener < 0)
+        return this->fail("the service is not listening");
+
+    // the longest a poll waits, so stop() is seen even without traffic
+    static const std::chrono::milliseconds IDLE(100);
+
+    this->running.store(true);
+    std::vector<pollfd> fds;
+    std::vector<int> sockets;
+    while(this->running.load())
+    {
+        fds.assign(1, pollfd{this->listener, POLLIN, 0});
+        sockets.clear();
+        for(const auto& [socket, client] : this->clients)
+        {
+            short events = 0;
+            if(!client.closed && client.output.size() - client.written < MAX_OUTPUT)
+                events |= POLLIN;
+            if(client.written < client.output.size())
+                events |= POLLOUT;
+            fds.push_back(pollfd{socket, events, 0});
+            sockets.push_back(socket);
+        }
+
+        Clock::duration timeout = IDLE;
+        if(!this->batch.empty())
+            timeout = std::clamp<Clock::duration>(this->deadline - Clock::now(), Clock::duration::zero(), IDLE);
+#if defined(__linux__)
+        // microsecond windows, poll() would round them up to a millisecond
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+        timespec wait{static_cast<time_t>(nanoseconds / 1000000000), static_cast<long>(nanoseconds % 1000000000)};
+        int ready = ppoll(fds.data(), fds.size(), &wait, nullptr);
+#else
+        int ready = poll(fds.data(), fds.size(), static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(timeout).count()));
+#endif
+        if(ready < 0 && errno != EINTR)
+            return this->fail(std::string("poll failed: ") + std::strerror(errno));
+
+        if(ready > 0)
+        {
+            TRACE_SCOPE("receive");
+            for(std::size_t i = 1; i < fds.size(); i++)
+            {
+                if((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !this->clients[sockets[i - 1]].closed)
+                    this->receive(sockets[i - 1]);
+                if((fds[i].revents & POLLOUT) != 0)
+                    this->send(sockets[i - 1]);
+            }
+            if((fds[0].revents & POLLIN) != 0)
+                this->accept();
+        }
+
+        if(!this->batch.empty() && (this->batch.size() >= MAX_BATCH || Clock::now() >= this->deadline))
+            this->process();
+        for(int socket : sockets)
+            this->closeIfDone(socket);
+    }
+    return true;
+}
+
+void TriangulationService::accept(void)
+{
+    for(;;)
+    {
+        int socket = ::accept(this->listener, nullptr, nullptr);
+        if(socket < 0)
+            return;
+        if(!setNonBlocking(socket))
+        {
+            close(socket);
+            continue;
+        }
+        this->clients.emplace(socket, Client());
+        this->connections++;
+    }
+}
+
+void TriangulationService::receive(int socket)
+{
+    Client& client = this->clients[socket];
+    unsigned char buffer[1 << 16];
+    for(;;)
+    {
+        ssize_t got = recv(socket, buffer, sizeof(buffer), 0);
+        if(got < 0 && errno == EINTR)
+            continue;
+        if(got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if(got <= 0)
+        {
+            // the client may have only shut down its side, the replies still go out
+            client.closed = true;
+            break;
+        }
+        client.input.insert(client.input.end(), buffer, buffer + got);
+        this->bytesIn += static_cast<std::uint64_t>(got);
+    }
+
+    std::size_t offset = 0;
+    while(client.input.size() - offset >= sizeof(RequestHeader))
+    {
+        Request request;
+        std::memcpy(&request.header, client.input.data() + offset, sizeof(RequestHeader));
+        if(request.header.length > RequestHeader::MAX_PAYLOAD)
+        {
+            // the stream cannot be resynchronized, answer what came before and hang up
+            client.closed = true;
+            offset = client.input.size();
+            break;
+        }
+        std::size_t length = request.header.length;
+        if(client.input.size() - offset - sizeof(RequestHeader) < length)
+            break;
+        const unsigned char* payload = client.input.data() + offset + sizeof(RequestHeader);
+        request.client = socket;
+        request.payload.assign(payload, payload + length);
+        request.arrival = Clock::now();
+        if(this->batch.empty())
+            this->deadline = request.arrival + std::chrono::microseconds(this->window);
+        this->batch.push_back(std::move(request));
+        client.pending++;
+        offset += sizeof(RequestHeader) + length;
+    }
+    client.input.erase(client.input.begin(), client.input.begin() + static_cast<std::ptrdiff_t>(offset));
+}
+
+void TriangulationService::send(int socket)
+{
+    Client& client = this->clients[socket];
+    while(client.written < client.output.size())
+    {
+        ssize_t sent = ::send(socket, client.output.data() + client.written, client.output.size() - client.written, SEND_FLAGS);
+        if(sent < 0 && errno == EINTR)
+            continue;
+        if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if(sent <= 0)
+        {
+            // nobody is left to read the rest
+            client.closed = true;
+            client.output.clear();
+            client.written = 0;
+            return;
+        }
+        client.written += static_cast<std::size_t>(sent);
+        this->bytesOut += static_cast<std::uint64_t>(sent);
+    }
+    client.output.clear();
+    client.written = 0;
+}
+
+void TriangulationService::closeIfDone(int socket)
+{
+    auto it = this->clients.find(socket);
+    if(it == this->clients.end())
+        return;
+    const Client& client = it->second;
+    if(client.closed && client.pending == 0 && client.written == client.output.size())
+    {
+        close(socket);
+        this->clients.erase(it);
+    }
+}
+
+#endif // _WIN32
+
+void TriangulationService::process(void)
+{
+    TRACE_SCOPE("batch");
+    // held back inserts per mesh, in arrival order
+    std::unordered_map<std::uint32_t, std::vector<Request*>> inserts;
+    for(Request& request : this->batch)
+    {
+        std::uint16_t opcode = request.header.opcode;
+        if(opcode == RequestHeader::INSERT && request.payload.size() % sizeof(Node) == 0 && this->find(request.header.mesh) != nullptr)
+        {
+            inserts[request.header.mesh].push_back(&request);
+            continue;
+        }
+        // whatever else touches the mesh sees the inserts that came before it
+        auto held = opcode == RequestHeader::CREATE || opcode == RequestHeader::STATS ? inserts.end() : inserts.find(request.header.mesh);
+        if(held != inserts.end())
+        {
+            this->flushInserts(held->first, &held->second);
+            inserts.erase(held);
+        }
+        this->execute(&request);
+    }
+    for(auto& [mesh, held] : inserts)
+        this->flushInserts(mesh, &held);
+
+    Clock::time_point done = Clock::now();
+    for(Request& request : this->batch)
+    {
+        std::uint64_t micros = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(done - request.arrival).count());
+        this->latencies[0].record(micros);
+        if(request.header.opcode > 0 && request.header.opcode < RequestHeader::OPCODE_COUNT)
+            this->latencies[request.header.opcode].record(micros);
+
+        Client& client = this->clients[request.client];
+        client.pending--;
+        ReplyHeader reply{};
+        reply.tag = request.header.tag;
+        reply.opcode = request.header.opcode;
+        reply.status = request.status;
+        if(request.status != ReplyHeader::OK)
+            request.reply.clear();
+        reply.length = static_cast<std::uint32_t>(request.reply.size());
+        append(&client.output, reply);
+        client.output.insert(client.output.end(), request.reply.begin(), request.reply.end());
+    }
+    this->batch.clear();
+    this->batches++;
+
+#if !defined(_WIN32)
+    // most replies fit the socket buffer, which saves a poll round
+    for(auto& [socket, client] : this->clients)
+    {
+        if(client.written < client.output.size())
+            this->send(socket);
+    }
+#endif
+}
+
+void TriangulationService::flushInserts(std::uint32_t mesh, std::vector<Request*>* inserts)
+{
+    TRACE_SCOPE("insert");
+    Entry* entry = this->find(mesh);
+    std::vector<Node> nodes;
+    std::vector<std::size_t> slots; // position of every node inside the bounds among all the requests' nodes
+    std::size_t total = 0;
+    for(const Request* request : *inserts)
+    {
+        const Node* requested = reinterpret_cast<const Node*>(request->payload.data());
+        std::size_t count = request->payload.size() / sizeof(Node);
+        for(std::size_t i = 0; i < count; i++, total++)
+        {
+            Node n;
+            std::memcpy(&n, requested + i, sizeof(Node));
+            if(isFinite(n) && isInside(entry->bounds, n))
+            {
+                nodes.push_back(n);
+                slots.push_back(total);
+            }
+        }
+    }
+    this->insertedPoints += total;
+
+    std::vector<std::int32_t> handles(total, Mesh::NONE);
+    std::vector<int> inserted = entry->mesh.insertBatch(nodes);
+    for(std::size_t i = 0; i < inserted.size(); i++)
+        handles[slots[i]] = inserted[i];
+
+    std::size_t first = 0;
+    for(Request* request : *inserts)
+    {
+        std::size_t count = request->payload.size() / sizeof(Node);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(handles.data() + first);
+        request->reply.assign(bytes, bytes + count * sizeof(std::int32_t));
+        first += count;
+    }
+}
+
+void TriangulationService::execute(Request* request)
+{
+    std::uint16_t opcode = request->header.opcode;
+    if(opcode == RequestHeader::CREATE)
+    {
+        Box bounds;
+        if(!read(request->payload, &bounds) || !isValid(bounds) || !(bounds.minCorner.x < bounds.maxCorner.x) ||
+           !(bounds.minCorner.y < bounds.maxCorner.y))
+        {
+            request->status = ReplyHeader::BAD_REQUEST;
+            return;
+        }
+        std::uint32_t mesh = this->nextMesh++;
+        this->meshes.emplace(mesh, std::make_unique<Entry>(bounds));
+        append(&request->reply, mesh);
+        return;
+    }
+    if(opcode == RequestHeader::STATS)
+    {
+        if(!request->payload.empty())
+            request->status = ReplyHeader::BAD_REQUEST;
+        else
+            append(&request->reply, this->getStats());
+        return;
+    }
+    if(opcode == 0 || opcode >= RequestHeader::OPCODE_COUNT)
+    {
+        request->status = ReplyHeader::BAD_REQUEST;
+        return;
+    }
+
+    Entry* entry = this->find(request->header.mesh);
+    if(entry == nullptr)
+    {
+        request->status = ReplyHeader::NO_SUCH_MESH;
+        return;
+    }
+    Mesh& mesh = entry->mesh;
+    Node n;
+    Box box;
+    switch(opcode)
+    {
+    case RequestHeader::DROP:
+        if(!request->payload.empty())
+            request->status = ReplyHeader::BAD_REQUEST;
+        else
+            this->meshes.erase(request->header.mesh);
+        break;
+    case RequestHeader::INSERT:
+        // only a payload that is no whole number of nodes comes here
+        request->status = ReplyHeader::BAD_REQUEST;
+        break;
+    case RequestHeader::REMOVE:
+        if(request->payload.size() % sizeof(std::int32_t) != 0)
+        {
+            request->status = ReplyHeader::BAD_REQUEST;
+            break;
+        }
+        for(std::size_t i = 0; i < request->payload.size(); i += sizeof(std::int32_t))
+        {
+            std::int32_t vertex;
+            std::memcpy(&vertex, request->payload.data() + i, sizeof(vertex));
+            request->reply.push_back(mesh.remove(vertex) ? 1 : 0);
+        }
+        break;
+    case RequestHeader::LOCATE:
+        if(!read(request->payload, &n) || !isFinite(n))
+            request->status = ReplyHeader::BAD_REQUEST;
+        else
+        {
+            LocateReply reply{};
+            reply.face = mesh.locate(n, mesh.getLastFace());
+            for(int i = 0; i < 3; i++)
+                reply.v[i] = reply.face == Mesh::NONE ? Mesh::NONE : mesh.faces[reply.face].v[i];
+            append(&request->reply, reply);
+        }
+        break;
+    case RequestHeader::NEAREST:
+        if(!read(request->payload, &n) || !isFinite(n))
+            request->status = ReplyHeader::BAD_REQUEST;
+        else
+        {
+            NearestReply reply{};
+            reply.vertex = mesh.nearest(n, mesh.getLastFace());
+            reply.node = reply.vertex == Mesh::NONE ? Node(0.0f, 0.0f) : mesh.vertices[reply.vertex];
+            append(&request->reply, reply);
+        }
+        break;
+    case RequestHeader::QUERY:
+        if(!read(request->payload, &box) || !isValid(box))
+            request->status = ReplyHeader::BAD_REQUEST;
+        else
+            this->query(entry, box, &request->reply);
+        break;
+    }
+}
+
+void TriangulationService::query(Entry* entry, const Box& box, std::vector<unsigned char>* reply)
+{
+    const Mesh& mesh = entry->mesh;
+    if(entry->mark.size() < mesh.faces.size())
+        entry->mark.resize(mesh.faces.size(), 0);
+    if(++entry->stamp == 0)
+    {
+        std::fill(entry->mark.begin(), entry->mark.end(), 0);
+        entry->stamp = 1;
+    }
+
+    // the faces meeting a convex box are connected across the edges meeting it, so flood
+    // from the face at its centre; edges to a super vertex are crossed unchecked
+    Node centre((box.minCorner.x + box.maxCorner.x) * 0.5f, (box.minCorner.y + box.maxCorner.y) * 0.5f);
+    int start = mesh.locate(centre, mesh.getLastFace());
+    if(start == Mesh::NONE)
+        return;
+    std::vector<int> stack(1, start);
+    entry->mark[start] = entry->stamp;
+    while(!stack.empty())
+    {
+        int face = stack.back();
+        stack.pop_back();
+        const Mesh::Face& f = mesh.faces[face];
+        if(!mesh.isSuperFace(face))
+        {
+            const Node& a = mesh.vertices[f.v[0]];
+            const Node& b = mesh.vertices[f.v[1]];
+            const Node& c = mesh.vertices[f.v[2]];
+            // a box inside the face touches none of its edges but holds the centre
+            bool meets = segmentMeetsBox(a, b, box) || segmentMeetsBox(b, c, box) || segmentMeetsBox(c, a, box) ||
+                         (mesh.orient(f.v[0], f.v[1], centre) >= 0.0 && mesh.orient(f.v[1], f.v[2], centre) >= 0.0 &&
+                          mesh.orient(f.v[2], f.v[0], centre) >= 0.0);
+            if(meets)
+            {
+                for(int v : f.v)
+                    append(reply, static_cast<std::int32_t>(v));
+            }
+        }
+        for(int i = 0; i < 3; i++)
+        {
+            int next = f.adj[i];
+            if(next == Mesh::NONE || entry->mark[next] == entry->stamp)
+                continue;
+            int a = f.v[(i + 1) % 3], b = f.v[(i + 2) % 3];
+            if(mesh.isSuperVertex(a) || mesh.isSuperVertex(b) || segmentMeetsBox(mesh.vertices[a], mesh.vertices[b], box))
+            {
+                entry->mark[next] = entry->stamp;
+                stack.push_back(next);
+            }
+        }
+    }
+}
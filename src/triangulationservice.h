@@ -0,0 +1,159 @@
+#ifndef TRIANGULATIONSERVICE_H
+#define TRIANGULATIONSERVICE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+#include "serviceprotocol.h"
+
+/** Log-linear histogram of latencies in microseconds.
+* Values below SUB_BUCKETS are exact, above that every power of two is split into
+* SUB_BUCKETS buckets, so a percentile is off by at most 1 / SUB_BUCKETS of its value. */
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKETS = 8;
+
+    void record(std::uint64_t micros) noexcept;
+    /// @return the upper end of the bucket holding the given fraction of the samples, 0 without samples
+    std::uint64_t percentile(double fraction) const noexcept;
+
+    inline std::uint64_t count(void) const noexcept
+    {
+        return this->total;
+    }
+
+private:
+    std::array<std::uint64_t, 64 * SUB_BUCKETS> buckets{};
+    std::uint64_t total = 0;
+};
+
+/** A daemon holding meshes in memory and serving them over a Unix domain socket.
+* run() is a single-threaded poll() loop speaking the protocol of serviceprotocol.h. The
+* first request to arrive opens a batch, which collects every request read in the next
+* getWindow() microseconds or up to MAX_BATCH requests. A batch is executed in arrival
+* order, except that consecutive inserts into one mesh, from any client, are held back and
+* go through Mesh::insertBatch together as soon as another request touches that mesh or the
+* batch ends: the Hilbert sort turns many small inserts into one short walk each. Replies
+* are queued only once the whole batch is done, so every client sees its replies in
+* request order. A client whose replies pile up past MAX_OUTPUT is not read until it
+* catches up. Each opcode keeps a LatencyHistogram and the STATS request reports p50, p99
+* and throughput counters. POSIX only. */
+class TriangulationService
+{
+public:
+    static const std::size_t MAX_BATCH = 4096;
+    static const std::size_t MAX_OUTPUT = 1 << 26;
+
+    /// window is how long a batch stays open after its first request, in microseconds
+    explicit TriangulationService(int window = 200);
+    ~TriangulationService();
+
+    TriangulationService(const TriangulationService&) = delete;
+    TriangulationService& operator = (const TriangulationService&) = delete;
+
+    /// binds the socket, replacing a stale socket file at path
+    /// @return false with getError() set if the socket could not be bound
+    bool listen(const char* path);
+    /// serves clients until stop() is called
+    /// @return false with getError() set if polling failed
+    bool run(void);
+    /// ends run() within a poll timeout, safe to call from a signal handler
+    inline void stop(void) noexcept
+    {
+        this->running.store(false);
+    }
+
+    ServiceStats getStats(void) const;
+
+    inline int getWindow(void) const noexcept
+    {
+        return this->window;
+    }
+
+    inline const std::string& getError(void) const noexcept
+    {
+        return this->error;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    class Client
+    {
+    public:
+        std::vector<unsigned char> input;
+        std::vector<unsigned char> output;
+        std::size_t written = 0; // bytes of output already sent
+        std::size_t pending = 0; // requests of the open batch
+        bool closed = false;     // the peer hung up or broke the protocol, the socket waits for pending
+    };
+
+    class Request
+    {
+    public:
+        int client;
+        RequestHeader header;
+        std::vector<unsigned char> payload;
+        Clock::time_point arrival;
+        ReplyHeader::Status status = ReplyHeader::OK;
+        std::vector<unsigned char> reply;
+    };
+
+    /// a mesh with its bounds and the marks of its range queries
+    class Entry
+    {
+    public:
+        explicit Entry(const Box& bounds) : bounds(bounds), mesh(bounds.minCorner, bounds.maxCorner) {}
+
+        Box bounds;
+        Mesh mesh;
+        std::vector<unsigned int> mark;
+        unsigned int stamp = 0;
+    };
+
+    void accept(void);
+    /// reads what the client sent and cuts it into requests
+    void receive(int socket);
+    void send(int socket);
+    void closeIfDone(int socket);
+
+    void process(void);
+    /// inserts the held back INSERT requests of one mesh in one batch
+    void flushInserts(std::uint32_t mesh, std::vector<Request*>* inserts);
+    void execute(Request* request);
+    void query(Entry* entry, const Box& box, std::vector<unsigned char>* reply);
+    Entry* find(std::uint32_t mesh);
+
+    bool fail(const std::string& message);
+
+    int window;
+    int listener = -1;
+    std::string path;
+    std::atomic<bool> running{false};
+
+    std::unordered_map<int, Client> clients;
+    std::vector<Request> batch;
+    Clock::time_point deadline;
+    std::unordered_map<std::uint32_t, std::unique_ptr<Entry>> meshes;
+    std::uint32_t nextMesh = 1;
+
+    Clock::time_point started;
+    std::uint64_t connections = 0;
+    std::uint64_t batches = 0;
+    std::uint64_t insertedPoints = 0;
+    std::uint64_t bytesIn = 0, bytesOut = 0;
+    std::array<LatencyHistogram, RequestHeader::OPCODE_COUNT> latencies;
+    std::string error;
+};
+
+#endif // TRIANGULATIONSERVICE_H
@@ -14,6 +14,14 @@ static inline float distance(const Node& n1, const Node& n2) noexcept
     return std::sqrt( std::pow(n2.x - n1.x, 2) + std::pow(n2.y - n1.y, 2) );
 }
 
+/**==============================================
+*@return squared distance between two nodes in double, float would tie distinct neighbours */
+static inline double squaredDistance(const Node& n1, const Node& n2) noexcept
+{
+    double dx = double(n2.x) - n1.x, dy = double(n2.y) - n1.y;
+    return dx * dx + dy * dy;
+}
+
 /**==============================================
 *@return the midpoint of two nodes */
 static inline Node midPoint(const Node& n1, const Node& n2) noexcept
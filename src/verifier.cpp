@@ -0,0 +1,308 @@
+#include "verifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "predicates.h"
+#include "trace.h"
+
+static const std::size_t GRAIN = 1 << 14;
+static const int VISITED = -2;
+
+/// the half-edge 3 * t + i runs from tail to head along triangle t, opposite its vertex i
+static inline int tail(std::span<const std::array<int, 3>> triangles, int edge) noexcept
+{
+    return triangles[edge / 3][(edge % 3 + 1) % 3];
+}
+
+static inline int head(std::span<const std::array<int, 3>> triangles, int edge) noexcept
+{
+    return triangles[edge / 3][(edge % 3 + 2) % 3];
+}
+
+std::ostream& operator << (std::ostream& out, const VerifyReport& report)
+{
+    out << "triangles        " << report.triangles << ", " << report.edges << " edges, " << report.vertices
+        << " vertices (" << report.unusedVertices << " unused)\n"
+        << "boundary         " << report.boundaryEdges << " edges in " << report.boundaryLoops << " loops, winding "
+        << report.windingNumber << ", euler " << report.eulerCharacteristic << '\n'
+        << "defects          invalid:" << report.invalidTriangles << " orientation:" << report.badOrientation
+        << " non-manifold:" << report.nonManifoldEdges << " non-delaunay:" << report.nonDelaunayEdges
+        << " pinched:" << report.pinchedVertices << " reflex:" << report.reflexCorners
+        << " broken-links:" << report.brokenLinks << '\n'
+        << "result           " << (report.isValid() ? "valid" : "INVALID");
+    if(report.firstBadTriangle != Mesh::NONE)
+        out << ", first bad triangle " << report.firstBadTriangle;
+    return out << '\n';
+}
+
+DelaunayVerifier::DelaunayVerifier(unsigned int threadCount)
+    : pool(threadCount), counts(pool.size())
+{
+}
+
+void DelaunayVerifier::resetCounts(void)
+{
+    for(Counts& c : this->counts)
+        c = Counts();
+}
+
+DelaunayVerifier::Counts DelaunayVerifier::sumCounts(void) const
+{
+    Counts sum;
+    for(const Counts& c : this->counts)
+    {
+        sum.invalid += c.invalid;
+        sum.badOrientation += c.badOrientation;
+        sum.nonDelaunay += c.nonDelaunay;
+        sum.interior += c.interior;
+        sum.boundary += c.boundary;
+        sum.nonManifold += c.nonManifold;
+        sum.brokenLinks += c.brokenLinks;
+        if(c.firstBad != Mesh::NONE)
+            sum.markBad(c.firstBad);
+    }
+    return sum;
+}
+
+void DelaunayVerifier::matchEdges(std::span<const std::array<int, 3>> triangles)
+{
+    TRACE_SCOPE("matchEdges");
+    int edges = static_cast<int>(triangles.size() * 3);
+    std::size_t vertexCount = this->start.size() - 1;
+
+    // counting sort of the half-edges by their lower vertex, start[v] ends up at the first edge of v
+    for(int e = 0; e < edges; e++)
+        this->start[std::min(tail(triangles, e), head(triangles, e)) + 1]++;
+    for(std::size_t v = 0; v < vertexCount; v++)
+        this->start[v + 1] += this->start[v];
+    this->edgeOrder.resize(edges);
+    for(int e = 0; e < edges; e++)
+        this->edgeOrder[this->start[std::min(tail(triangles, e), head(triangles, e))]++] = e;
+    for(std::size_t v = vertexCount; v > 0; v--)
+        this->start[v] = this->start[v - 1];
+    this->start[0] = 0;
+
+    // a vertex only owns a handful of edges, so pairing them up within its bucket is linear overall
+    this->twin.resize(edges);
+    this->pool.parallelFor(vertexCount, GRAIN, [&](std::size_t begin, std::size_t end, unsigned int worker)
+    {
+        Counts& c = this->counts[worker];
+        for(std::size_t v = begin; v < end; v++)
+        {
+            auto upper = [&](int e) { return std::max(tail(triangles, e), head(triangles, e)); };
+            int* first = this->edgeOrder.data() + this->start[v];
+            int* last = this->edgeOrder.data() + this->start[v + 1];
+            std::sort(first, last, [&](int a, int b) { return upper(a) < upper(b); });
+
+            for(int* run = first; run < last; )
+            {
+                int* runEnd = run + 1;
+                while(runEnd < last && upper(*runEnd) == upper(*run))
+                    runEnd++;
+
+                if(runEnd - run == 1)
+                {
+                    this->twin[run[0]] = BOUNDARY;
+                    c.boundary++;
+                }
+                else if(runEnd - run == 2 && tail(triangles, run[0]) == head(triangles, run[1]))
+                {
+                    this->twin[run[0]] = run[1];
+                    this->twin[run[1]] = run[0];
+                    c.interior++;
+                }
+                else
+                {
+                    for(int* e = run; e < runEnd; e++)
+                    {
+                        this->twin[*e] = NON_MANIFOLD;
+                        c.markBad(*e / 3);
+                    }
+                    c.nonManifold++;
+                }
+                run = runEnd;
+            }
+        }
+    });
+}
+
+void DelaunayVerifier::checkBoundary(std::span<const Node> nodes, std::span<const std::array<int, 3>> triangles, VerifyReport* report)
+{
+    TRACE_SCOPE("checkBoundary");
+    int edges = static_cast<int>(triangles.size() * 3);
+    this->next.assign(nodes.size(), Mesh::NONE);
+    for(int e = 0; e < edges; e++)
+    {
+        if(this->twin[e] != BOUNDARY)
+            continue;
+        int& successor = this->next[tail(triangles, e)];
+        if(successor != Mesh::NONE)
+            report->pinchedVertices++;
+        else
+            successor = head(triangles, e);
+    }
+
+    double turns = 0.0;
+    std::vector<int> loop;
+    for(int e = 0; e < edges; e++)
+    {
+        int first = tail(triangles, e);
+        if(this->twin[e] != BOUNDARY || this->next[first] < 0)
+            continue;
+
+        loop.clear();
+        for(int v = first; v >= 0 && this->next[v] >= 0; )
+        {
+            loop.push_back(v);
+            int w = this->next[v];
+            this->next[v] = VISITED;
+            v = w;
+        }
+        report->boundaryLoops++;
+
+        // the exact sign finds reflex corners, the angles only need to add up to whole turns
+        double angle = 0.0;
+        std::size_t size = loop.size();
+        for(std::size_t k = 0; k < size; k++)
+        {
+            const Node& a = nodes[loop[k]];
+            const Node& b = nodes[loop[(k + 1) % size]];
+            const Node& c = nodes[loop[(k + 2) % size]];
+            if(orient2d(a, b, c) < 0.0)
+                report->reflexCorners++;
+            double ux = double(b.x) - a.x, uy = double(b.y) - a.y;
+            double vx = double(c.x) - b.x, vy = double(c.y) - b.y;
+            angle += std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+        }
+        turns += angle;
+    }
+    report->windingNumber = static_cast<int>(std::lround(turns / (2.0 * std::numbers::pi)));
+}
+
+VerifyReport DelaunayVerifier::verify(std::span<const Node> nodes, std::span<const std::array<int, 3>> triangles)
+{
+    TRACE_SCOPE("verify");
+    VerifyReport report;
+    report.triangles = triangles.size();
+    int vertexCount = static_cast<int>(nodes.size());
+
+    this->resetCounts();
+    this->pool.parallelFor(triangles.size(), GRAIN, [&](std::size_t begin, std::size_t end, unsigned int worker)
+    {
+        Counts& c = this->counts[worker];
+        for(std::size_t t = begin; t < end; t++)
+        {
+            const std::array<int, 3>& f = triangles[t];
+            if(f[0] < 0 || f[1] < 0 || f[2] < 0 || f[0] >= vertexCount || f[1] >= vertexCount || f[2] >= vertexCount
+                || f[0] == f[1] || f[1] == f[2] || f[2] == f[0])
+            {
+                c.invalid++;
+                c.markBad(static_cast<int>(t));
+            }
+            else if(orient2d(nodes[f[0]], nodes[f[1]], nodes[f[2]]) <= 0.0)
+            {
+                c.badOrientation++;
+                c.markBad(static_cast<int>(t));
+            }
+        }
+    });
+    Counts sum = this->sumCounts();
+    report.invalidTriangles = sum.invalid;
+    report.badOrientation = sum.badOrientation;
+    report.firstBadTriangle = sum.firstBad;
+    if(report.invalidTriangles > 0)
+        return report; // nothing else can be trusted to index the nodes
+
+    this->used.assign(nodes.size(), 0);
+    for(const std::array<int, 3>& f : triangles)
+        this->used[f[0]] = this->used[f[1]] = this->used[f[2]] = 1;
+    report.vertices = static_cast<std::size_t>(std::count(this->used.begin(), this->used.end(), 1));
+    report.unusedVertices = nodes.size() - report.vertices;
+
+    this->start.assign(nodes.size() + 1, 0);
+    this->matchEdges(triangles);
+
+    // one in-circle test per interior edge, from the side with the lower half-edge
+    this->pool.parallelFor(triangles.size(), GRAIN, [&](std::size_t begin, std::size_t end, unsigned int worker)
+    {
+        Counts& c = this->counts[worker];
+        for(std::size_t t = begin; t < end; t++)
+        {
+            const std::array<int, 3>& f = triangles[t];
+            for(int i = 0; i < 3; i++)
+            {
+                int e = static_cast<int>(3 * t) + i;
+                int other = this->twin[e];
+                if(other <= e)
+                    continue;
+                const Node& opposite = nodes[triangles[other / 3][other % 3]];
+                if(inCircle(nodes[f[0]], nodes[f[1]], nodes[f[2]], opposite) > 0.0)
+                {
+                    c.nonDelaunay++;
+                    c.markBad(static_cast<int>(t));
+                }
+            }
+        }
+    });
+    sum = this->sumCounts();
+    report.nonDelaunayEdges = sum.nonDelaunay;
+    report.nonManifoldEdges = sum.nonManifold;
+    report.boundaryEdges = sum.boundary;
+    report.edges = sum.interior + sum.boundary + sum.nonManifold;
+    report.firstBadTriangle = sum.firstBad;
+    report.eulerCharacteristic = static_cast<long long>(report.vertices) - static_cast<long long>(report.edges)
+        + static_cast<long long>(report.triangles);
+
+    this->checkBoundary(nodes, triangles, &report);
+    return report;
+}
+
+VerifyReport DelaunayVerifier::verify(const Mesh& mesh)
+{
+    this->faces.clear();
+    mesh.getTriangles(&this->faces);
+    VerifyReport report = this->verify(mesh.vertices, this->faces);
+
+    // super vertices and removed vertices are rightly missing from the triangles
+    if(report.invalidTriangles == 0)
+    {
+        report.unusedVertices = 0;
+        for(int v = 3; v < static_cast<int>(mesh.vertices.size()); v++)
+        {
+            if(mesh.isVertexAlive(v) && !this->used[v])
+                report.unusedVertices++;
+        }
+    }
+
+    // every neighbour must link back across the same edge, super faces included
+    this->resetCounts();
+    this->pool.parallelFor(mesh.faces.size(), GRAIN, [&](std::size_t begin, std::size_t end, unsigned int worker)
+    {
+        Counts& c = this->counts[worker];
+        for(int face = static_cast<int>(begin); face < static_cast<int>(end); face++)
+        {
+            if(!mesh.isAlive(face))
+                continue;
+            const Mesh::Face& f = mesh.faces[face];
+            for(int i = 0; i < 3; i++)
+            {
+                int other = f.adj[i];
+                if(other == Mesh::NONE)
+                    continue;
+                if(!mesh.isAlive(other))
+                {
+                    c.brokenLinks++;
+                    continue;
+                }
+                const Mesh::Face& g = mesh.faces[other];
+                int j = g.adj[0] == face ? 0 : g.adj[1] == face ? 1 : g.adj[2] == face ? 2 : Mesh::NONE;
+                if(j == Mesh::NONE || g.v[(j + 1) % 3] != f.v[(i + 2) % 3] || g.v[(j + 2) % 3] != f.v[(i + 1) % 3])
+                    c.brokenLinks++;
+            }
+        }
+    });
+    report.brokenLinks = this->sumCounts().brokenLinks;
+    return report;
+}
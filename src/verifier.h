@@ -0,0 +1,106 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "node.h"
+#include "mesh.h"
+#include "threadpool.h"
+
+/** What DelaunayVerifier found, counts of every kind of defect plus the shape of the mesh. */
+class VerifyReport
+{
+public:
+    std::size_t vertices = 0;          // vertices used by at least one triangle
+    std::size_t edges = 0;
+    std::size_t triangles = 0;
+    std::size_t boundaryEdges = 0;
+    std::size_t unusedVertices = 0;    // nodes no triangle uses, exact duplicates end up here
+    std::size_t invalidTriangles = 0;  // indices out of range or repeated
+    std::size_t badOrientation = 0;    // triangles that are not strictly counter-clockwise
+    std::size_t nonManifoldEdges = 0;  // edges of more than two triangles, or twice in one direction
+    std::size_t nonDelaunayEdges = 0;  // edges whose opposite vertices lie inside each other's circumcircle
+    std::size_t pinchedVertices = 0;   // vertices where the boundary touches itself
+    std::size_t reflexCorners = 0;     // boundary corners turning right, the boundary is not the convex hull
+    std::size_t brokenLinks = 0;       // mesh adjacency that does not point back or disagrees on the edge
+    long long eulerCharacteristic = 0; // V - E + F, 1 for a triangulated disc
+    int boundaryLoops = 0;
+    int windingNumber = 0;             // turns of the boundary around the mesh, summed over loops
+    int firstBadTriangle = Mesh::NONE; // lowest triangle with a local defect
+
+    /**==============================================
+    *@return true for a Delaunay triangulation of the convex hull of the used vertices */
+    inline bool isValid(void) const noexcept
+    {
+        bool local = this->invalidTriangles == 0 && this->badOrientation == 0 && this->nonManifoldEdges == 0
+            && this->nonDelaunayEdges == 0 && this->brokenLinks == 0;
+        bool global = this->triangles == 0 || (this->eulerCharacteristic == 1 && this->boundaryLoops == 1
+            && this->windingNumber == 1 && this->pinchedVertices == 0 && this->reflexCorners == 0);
+        return local && global;
+    }
+
+    friend std::ostream& operator << (std::ostream& out, const VerifyReport& report);
+};
+
+/** Checks that a triangulation is Delaunay and covers exactly the convex hull of its vertices.
+* Locally, every triangle must be counter-clockwise and no vertex across an edge may
+* lie inside its circumcircle; that single test per edge is enough for the whole mesh
+* to be Delaunay. Globally, the edges must form a disc (manifold, V - E + F = 1) whose
+* boundary is one convex loop winding once: a locally consistent disc with such a
+* boundary cannot fold over itself, so it has no overlaps and leaves no holes.
+* Every step is linear: edges are matched by bucketing them under their lower vertex
+* rather than by sorting, and the per-triangle and per-edge tests run across a pool. */
+class DelaunayVerifier
+{
+public:
+    explicit DelaunayVerifier(unsigned int threadCount = std::thread::hardware_concurrency());
+
+    /// checks triangles given as counter-clockwise index triples into nodes
+    VerifyReport verify(std::span<const Node> nodes, std::span<const std::array<int, 3>> triangles);
+    /// checks the finite triangles of a mesh and the adjacency it keeps between its faces
+    VerifyReport verify(const Mesh& mesh);
+
+private:
+    static const int BOUNDARY = -1;    // twin of an edge on the boundary
+    static const int NON_MANIFOLD = -2;
+
+    class alignas(64) Counts
+    {
+    public:
+        std::size_t invalid = 0;
+        std::size_t badOrientation = 0;
+        std::size_t nonDelaunay = 0;
+        std::size_t interior = 0;
+        std::size_t boundary = 0;
+        std::size_t nonManifold = 0;
+        std::size_t brokenLinks = 0;
+        int firstBad = Mesh::NONE;
+
+        inline void markBad(int triangle) noexcept
+        {
+            if(this->firstBad == Mesh::NONE || triangle < this->firstBad)
+                this->firstBad = triangle;
+        }
+    };
+
+    void matchEdges(std::span<const std::array<int, 3>> triangles);
+    void checkBoundary(std::span<const Node> nodes, std::span<const std::array<int, 3>> triangles, VerifyReport* report);
+    void resetCounts(void);
+    Counts sumCounts(void) const;
+
+    ThreadPool pool;
+    std::vector<Counts> counts;              // one per worker
+    std::vector<unsigned char> used;         // whether some triangle uses each node
+    std::vector<int> start;                  // where the edges of each lower vertex start in edgeOrder
+    std::vector<int> edgeOrder;              // half-edges 3 * t + i grouped by their lower vertex
+    std::vector<int> twin;                   // the opposite half-edge, BOUNDARY or NON_MANIFOLD
+    std::vector<int> next;                   // the boundary successor of each vertex
+    std::vector<std::array<int, 3>> faces;   // finite faces of a mesh being verified
+};
+
+#endif // VERIFIER_H
@@ -0,0 +1,99 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const float TWO_PI = 6.28318530717958647692f;
+
+// each node owns this many consecutive counters of the node stream
+static const std::uint64_t DRAWS = 4;
+
+Node Workload::node(std::size_t index, std::size_t count) const
+{
+    CounterRandom random(this->seed, NODE_STREAM);
+    std::uint64_t counter = index * DRAWS;
+    float width = this->maxCorner.x - this->minCorner.x;
+    float height = this->maxCorner.y - this->minCorner.y;
+    float cx = (this->minCorner.x + this->maxCorner.x) / 2.0f;
+    float cy = (this->minCorner.y + this->maxCorner.y) / 2.0f;
+
+    switch(this->distribution)
+    {
+    case GAUSSIAN_CLUSTERS:
+    {
+        CounterRandom centers(this->seed, CENTER_STREAM);
+        std::uint64_t cluster = random.bits(counter) % static_cast<std::uint64_t>(std::max(this->clusters, 1));
+        float x = this->minCorner.x + (0.05f + 0.9f * centers.uniform(2 * cluster)) * width;
+        float y = this->minCorner.y + (0.05f + 0.9f * centers.uniform(2 * cluster + 1)) * height;
+
+        // Box-Muller, 1 - u keeps the logarithm finite
+        float radius = std::sqrt(-2.0f * std::log(1.0f - random.uniform(counter + 1)));
+        float angle = TWO_PI * random.uniform(counter + 2);
+        float sigma = this->spread * std::max(width, height);
+        return Node(std::clamp(x + sigma * radius * std::cos(angle), this->minCorner.x, this->maxCorner.x),
+                    std::clamp(y + sigma * radius * std::sin(angle), this->minCorner.y, this->maxCorner.y));
+    }
+    case GRID:
+    case JITTERED_GRID:
+    {
+        std::size_t side = std::max<std::size_t>(static_cast<std::size_t>(std::ceil(std::sqrt(double(count)))), 1);
+        float cellX = width / side, cellY = height / side;
+        float x = this->minCorner.x + (float(index % side) + 0.5f) * cellX;
+        float y = this->minCorner.y + (float(index / side) + 0.5f) * cellY;
+        if(this->distribution == JITTERED_GRID)
+        {
+            x += (2.0f * random.uniform(counter) - 1.0f) * this->jitter * cellX;
+            y += (2.0f * random.uniform(counter + 1) - 1.0f) * this->jitter * cellY;
+        }
+        return Node(x, y);
+    }
+    case CIRCLE:
+    {
+        // every node on one circle, the classic degenerate input
+        float angle = TWO_PI * random.uniform(counter);
+        return Node(cx + 0.5f * width * std::cos(angle), cy + 0.5f * height * std::sin(angle));
+    }
+    case LINE:
+    {
+        // every node on the diagonal of the box, nothing to triangulate
+        float t = random.uniform(counter);
+        return Node(this->minCorner.x + t * width, this->minCorner.y + t * height);
+    }
+    case UNIFORM:
+    default:
+        return Node(this->minCorner.x + random.uniform(counter) * width,
+                    this->minCorner.y + random.uniform(counter + 1) * height);
+    }
+}
+
+const char* Workload::name(Distribution distribution) noexcept
+{
+    switch(distribution)
+    {
+    case UNIFORM:           return "uniform";
+    case GAUSSIAN_CLUSTERS: return "clustered";
+    case GRID:              return "grid";
+    case JITTERED_GRID:     return "jittered-grid";
+    case CIRCLE:            return "circle";
+    case LINE:              return "line";
+    }
+    return "unknown";
+}
+
+WorkloadGenerator::WorkloadGenerator(unsigned int threadCount)
+    : pool(threadCount)
+{
+}
+
+void WorkloadGenerator::generate(const Workload& workload, std::size_t count, std::vector<Node>* out)
+{
+    out->resize(count);
+    Node* data = out->data();
+
+    // large chunks, every node is independent and the loop is bound by memory bandwidth
+    this->pool.parallelFor(count, 1 << 16, [&](std::size_t begin, std::size_t end, unsigned int)
+    {
+        for(std::size_t i = begin; i < end; i++)
+            data[i] = workload.node(i, count);
+    });
+}
@@ -0,0 +1,86 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "node.h"
+#include "threadpool.h"
+
+/**==============================================
+*@return a well mixed 64 bit value of z, the SplitMix64 finalizer */
+static inline std::uint64_t mix64(std::uint64_t z) noexcept
+{
+    z += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/** Counter based random numbers: value k of a stream is a hash of (seed, stream, k).
+* Nothing is carried from one draw to the next, so any thread can produce any part
+* of a sequence and the result never depends on how the work was split. */
+class CounterRandom
+{
+public:
+    explicit CounterRandom(std::uint64_t seed, std::uint64_t stream = 0) noexcept
+        : key(mix64(seed ^ mix64(stream)))
+    {
+    }
+
+    inline std::uint64_t bits(std::uint64_t counter) const noexcept
+    {
+        return mix64(this->key + counter * 0xd1b54a32d192ed03ull);
+    }
+
+    /**==============================================
+    *@return a uniform value in [0, 1) with 24 random bits, the resolution of a float */
+    inline float uniform(std::uint64_t counter) const noexcept
+    {
+        return static_cast<float>(this->bits(counter) >> 40) * (1.0f / 16777216.0f);
+    }
+
+private:
+    std::uint64_t key;
+};
+
+/** Describes a reproducible point set: the same workload and count always produce
+* the same nodes, whatever the number of threads. */
+class Workload
+{
+public:
+    enum Distribution {UNIFORM, GAUSSIAN_CLUSTERS, GRID, JITTERED_GRID, CIRCLE, LINE};
+    /// the CounterRandom streams node() draws from, callers sharing the seed start at FREE_STREAM
+    enum Stream {NODE_STREAM, CENTER_STREAM, FREE_STREAM};
+
+    Distribution distribution = UNIFORM;
+    std::uint64_t seed = 0;
+    Node minCorner = Node(-1.0f, -1.0f);
+    Node maxCorner = Node(1.0f, 1.0f);
+    int clusters = 16;      // GAUSSIAN_CLUSTERS: number of blobs
+    float spread = 0.01f;   // GAUSSIAN_CLUSTERS: standard deviation, relative to the box size
+    float jitter = 0.25f;   // JITTERED_GRID: largest offset, relative to the cell size
+
+    /**==============================================
+    *@return node index of a set of count nodes */
+    Node node(std::size_t index, std::size_t count) const;
+
+    static const char* name(Distribution distribution) noexcept;
+};
+
+/** Fills large point sets in parallel; each node is computed from its index alone. */
+class WorkloadGenerator
+{
+public:
+    explicit WorkloadGenerator(unsigned int threadCount = std::thread::hardware_concurrency());
+
+    /// replaces the content of out with count nodes of workload
+    void generate(const Workload& workload, std::size_t count, std::vector<Node>* out);
+
+private:
+    ThreadPool pool;
+};
+
+#endif // WORKLOAD_H
@@ -0,0 +1,110 @@
+/** BatchTriangulator triangulates sets on both sides of SMALL_KERNEL_LIMIT into Delaunay
+* triangles of their own nodes, as many as one Mesh per set makes, whatever the order the
+* pool's workers finish them in. Once a worker's buffers are warm, sets in general position
+* cost it no allocation. */
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <span>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/smalltriangulation.h"
+#include "../src/batchtriangulator.h"
+#include "../src/workload.h"
+#include "check.h"
+
+// the counting operator new takes its memory from malloc, so delete hands it back to free
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size > 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(void)
+{
+    WorkloadGenerator generator;
+    std::vector<Node> nodes;
+    std::vector<std::size_t> offsets = {0};
+    std::uint64_t seed = 1;
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GRID, Workload::CIRCLE})
+    {
+        for(std::size_t size = 1; size <= 2 * SMALL_KERNEL_LIMIT + 8; size++)
+        {
+            Workload workload;
+            workload.distribution = distribution;
+            workload.seed = seed++;
+            std::vector<Node> set;
+            generator.generate(workload, size, &set);
+            nodes.insert(nodes.end(), set.begin(), set.end());
+            offsets.push_back(nodes.size());
+        }
+    }
+
+    BatchTriangulator triangulator(4);
+    MeshBatch batch;
+    triangulator.triangulate(nodes, offsets, &batch);
+    CHECK(batch.setCount() == offsets.size() - 1);
+
+    Mesh mesh;
+    std::vector<std::array<int, 3>> triangles;
+    for(std::size_t s = 0; s < batch.setCount(); s++)
+    {
+        std::span<const Node> set = std::span<const Node>(nodes).subspan(offsets[s], offsets[s + 1] - offsets[s]);
+        CHECK(isDelaunay(set, batch[s]));
+        mesh.clear();
+        mesh.insertBatch(set);
+        triangles.clear();
+        mesh.getTriangles(&triangles);
+        CHECK(batch[s].size() == triangles.size());
+    }
+
+    // a second run reuses the scratch of the first and gives the same batch
+    MeshBatch again;
+    triangulator.triangulate(nodes, offsets, &again);
+    CHECK(again.triangles == batch.triangles && again.offsets == batch.offsets);
+
+    // a single worker sees every set, so one run warms it; uniform sets never need the
+    // exact predicates, whose expansions allocate
+    std::vector<Node> uniform;
+    std::vector<std::size_t> uniformOffsets = {0};
+    for(std::size_t size = 1; size <= 2 * SMALL_KERNEL_LIMIT + 8; size++)
+    {
+        Workload workload;
+        workload.seed = seed++;
+        std::vector<Node> set;
+        generator.generate(workload, size, &set);
+        uniform.insert(uniform.end(), set.begin(), set.end());
+        uniformOffsets.push_back(uniform.size());
+    }
+    BatchTriangulator single(1);
+    single.triangulate(uniform, uniformOffsets, &again);
+    std::size_t before = allocations.load();
+    single.triangulate(uniform, uniformOffsets, &again);
+    std::size_t warm = allocations.load() - before;
+    std::cout << again.setCount() << " sets in " << warm << " allocations\n";
+    // the pool's task for the run may take one or two
+    CHECK(warm <= 2);
+    return finish("batchtriangulator_test");
+}
@@ -0,0 +1,63 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <array>
+#include <iostream>
+#include <span>
+
+#include "../src/node.h"
+#include "../src/predicates.h"
+
+/** Assertions of the headless tests. A failed CHECK prints where it is and what it
+* tested and the test carries on, so one run shows every failure; main() returns
+* finish(), which is non-zero once any check failed. */
+inline int& failedChecks(void)
+{
+    static int count = 0;
+    return count;
+}
+
+#define CHECK(condition)                                                                   \
+    do                                                                                     \
+    {                                                                                      \
+        if(!(condition))                                                                   \
+        {                                                                                  \
+            std::cout << __FILE__ << ':' << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+            failedChecks()++;                                                              \
+        }                                                                                  \
+    } while(false)
+
+/// prints the outcome of a test
+/// @return the exit code of its main()
+inline int finish(const char* test)
+{
+    if(failedChecks() == 0)
+        std::cout << test << ": ok\n";
+    else
+        std::cout << test << ": " << failedChecks() << " checks failed\n";
+    return failedChecks() == 0 ? 0 : 1;
+}
+
+/// brute force check of a triangulation by index triples into nodes: every triangle is
+/// counterclockwise and no node lies strictly inside its circumcircle
+inline bool isDelaunay(std::span<const Node> nodes, std::span<const std::array<int, 3>> triangles)
+{
+    for(const std::array<int, 3>& t : triangles)
+    {
+        for(int i : t)
+        {
+            if(i < 0 || i >= static_cast<int>(nodes.size()))
+                return false;
+        }
+        if(orient2d(nodes[t[0]], nodes[t[1]], nodes[t[2]]) <= 0.0)
+            return false;
+        for(const Node& n : nodes)
+        {
+            if(inCircle(nodes[t[0]], nodes[t[1]], nodes[t[2]], n) > 0.0)
+                return false;
+        }
+    }
+    return true;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,238 @@
+/** Every insertion engine triangulates every workload distribution into a mesh the
+* DelaunayVerifier accepts, and all engines agree on the number of triangles. Removal and
+* nearest vertex queries are checked on the meshes they leave behind. */
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/hierarchy.h"
+#include "../src/conflictgraph.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+/// small enough for the plain walks, which are quadratic on the degenerate distributions
+static const std::size_t COUNT = 4000;
+
+/// builds a triangulation of nodes and verifies it
+typedef std::function<VerifyReport(const std::vector<Node>&, DelaunayVerifier&)> Build;
+
+class Engine
+{
+public:
+    std::string name;
+    Build build;
+};
+
+static std::vector<Engine> engines(void)
+{
+    return {
+        {"walk", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            Mesh mesh;
+            for(const Node& n : nodes)
+                mesh.insert(n);
+            return verifier.verify(mesh);
+        }},
+        {"batch", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            Mesh mesh;
+            mesh.insertBatch(nodes);
+            return verifier.verify(mesh);
+        }},
+        {"batch-flip", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            Mesh mesh;
+            mesh.setEngine(Mesh::FLIP_ENGINE);
+            mesh.insertBatch(nodes);
+            return verifier.verify(mesh);
+        }},
+        {"walk-flip", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            Mesh mesh;
+            mesh.setEngine(Mesh::FLIP_ENGINE);
+            for(const Node& n : nodes)
+                mesh.insert(n);
+            return verifier.verify(mesh);
+        }},
+        {"hierarchy", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            DelaunayHierarchy hierarchy;
+            for(const Node& n : nodes)
+                hierarchy.insert(n);
+            return verifier.verify(hierarchy.base());
+        }},
+        {"hierarchy-flip", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            DelaunayHierarchy hierarchy;
+            hierarchy.setEngine(Mesh::FLIP_ENGINE);
+            for(const Node& n : nodes)
+                hierarchy.insert(n);
+            return verifier.verify(hierarchy.base());
+        }},
+        {"conflict-graph", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            Mesh mesh;
+            ConflictGraph().build(&mesh, nodes);
+            return verifier.verify(mesh);
+        }},
+        {"conflict-graph-cheapest", [](const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+        {
+            Mesh mesh;
+            ConflictGraph().build(&mesh, nodes, ConflictGraph::CHEAPEST_FIRST);
+            return verifier.verify(mesh);
+        }}
+    };
+}
+
+/// removing every other vertex leaves the Delaunay triangulation of the rest
+static void checkRemoval(const std::vector<Node>& nodes, DelaunayVerifier& verifier, Mesh::Engine engine)
+{
+    DelaunayHierarchy hierarchy;
+    hierarchy.setEngine(engine);
+    std::vector<int> handles;
+    for(const Node& n : nodes)
+        handles.push_back(hierarchy.insert(n));
+    std::vector<Node> kept;
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        if(i % 2 == 1 && handles[i] != Mesh::NONE && hierarchy.base().isVertexAlive(handles[i]))
+            CHECK(hierarchy.remove(handles[i]));
+        else if(i % 2 == 0)
+            kept.push_back(nodes[i]);
+    }
+    VerifyReport removed = verifier.verify(hierarchy.base());
+    CHECK(removed.isValid());
+
+    Mesh fresh;
+    fresh.insertBatch(kept);
+    CHECK(removed.triangles == verifier.verify(fresh).triangles);
+}
+
+/// removed vertices give their slots to the next insertions, so churn keeps the storage flat
+/// and the hierarchy links of a recycled slot belong to its new vertex
+static void checkChurn(const std::vector<Node>& nodes, DelaunayVerifier& verifier, Mesh::Engine engine)
+{
+    DelaunayHierarchy hierarchy;
+    hierarchy.setEngine(engine);
+    std::vector<int> handles;
+    for(const Node& n : nodes)
+        handles.push_back(hierarchy.insert(n));
+    std::size_t slots = hierarchy.base().vertices.size();
+    std::size_t triangles = verifier.verify(hierarchy.base()).triangles;
+    for(int round = 0; round < 5; round++)
+    {
+        for(std::size_t i = round; i < nodes.size(); i += 3)
+        {
+            if(hierarchy.base().isVertexAlive(handles[i]) && hierarchy.base().vertices[handles[i]] == nodes[i])
+                hierarchy.remove(handles[i]);
+        }
+        for(std::size_t i = round; i < nodes.size(); i += 3)
+            handles[i] = hierarchy.insert(nodes[i]);
+    }
+    CHECK(hierarchy.base().vertices.size() == slots);
+    VerifyReport report = verifier.verify(hierarchy.base());
+    CHECK(report.isValid() && report.triangles == triangles);
+    // an equal node finds its vertex, also in a recycled slot
+    for(std::size_t i = 0; i < nodes.size(); i++)
+        CHECK(hierarchy.insert(nodes[i]) == handles[i]);
+    CHECK(hierarchy.base().vertices.size() == slots);
+
+    Mesh mesh;
+    mesh.setEngine(engine);
+    mesh.insertBatch(nodes);
+    slots = mesh.vertices.size();
+    for(int cycle = 0; cycle < 10000; cycle++)
+        CHECK(mesh.remove(mesh.insert(Node(0.001f * (cycle % 7), -0.002f * (cycle % 5)))));
+    CHECK(mesh.vertices.size() <= slots + 1 && mesh.faces.size() <= 2 * slots + 16);
+}
+
+/// every handle insertBatch returns is the vertex of its node, and a cancelled batch
+/// still leaves a Delaunay mesh
+static void checkBatch(const std::vector<Node>& nodes, DelaunayVerifier& verifier)
+{
+    std::vector<Node> doubled(nodes);
+    doubled.insert(doubled.end(), nodes.begin(), nodes.end());
+    Mesh mesh;
+    std::vector<int> handles = mesh.insertBatch(doubled);
+    CHECK(handles.size() == doubled.size());
+    for(std::size_t i = 0; i < handles.size(); i++)
+    {
+        CHECK(handles[i] != Mesh::NONE);
+        if(handles[i] != Mesh::NONE)
+            CHECK(mesh.vertices[handles[i]].x == doubled[i].x && mesh.vertices[handles[i]].y == doubled[i].y);
+    }
+    // duplicates share the handle of the first copy
+    for(std::size_t i = 0; i < nodes.size(); i++)
+        CHECK(handles[i] == handles[nodes.size() + i]);
+
+    std::atomic<bool> cancel(true);
+    Mesh partial;
+    partial.insertBatch(nodes, &cancel);
+    CHECK(verifier.verify(partial).isValid());
+}
+
+/// the nearest vertex found by walking the mesh is the one a linear scan finds
+static void checkNearest(const std::vector<Node>& nodes)
+{
+    Mesh mesh;
+    mesh.insertBatch(nodes);
+    CounterRandom random(7);
+    for(std::uint64_t q = 0; q < 200; q++)
+    {
+        Node query(2.0f * random.uniform(2 * q) - 1.0f, 2.0f * random.uniform(2 * q + 1) - 1.0f);
+        int vertex = mesh.nearest(query);
+        CHECK(vertex != Mesh::NONE);
+        if(vertex == Mesh::NONE)
+            continue;
+        double best = squaredDistance(mesh.vertices[vertex], query);
+        for(const Node& n : nodes)
+            CHECK(squaredDistance(n, query) >= best);
+    }
+}
+
+int main(void)
+{
+    WorkloadGenerator generator;
+    DelaunayVerifier verifier;
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::GRID,
+                                               Workload::JITTERED_GRID, Workload::CIRCLE, Workload::LINE})
+    {
+        Workload workload;
+        workload.distribution = distribution;
+        workload.seed = 11;
+        std::vector<Node> nodes;
+        generator.generate(workload, COUNT, &nodes);
+
+        std::size_t triangles = 0;
+        for(const Engine& engine : engines())
+        {
+            VerifyReport report = engine.build(nodes, verifier);
+            if(!report.isValid())
+                std::cout << engine.name << " on " << Workload::name(distribution) << ":\n" << report;
+            CHECK(report.isValid());
+            // the points of a line span no triangle at all
+            CHECK(report.triangles > 0 || distribution == Workload::LINE);
+            if(triangles == 0)
+                triangles = report.triangles;
+            CHECK(report.triangles == triangles);
+        }
+
+        checkRemoval(nodes, verifier, Mesh::CAVITY_ENGINE);
+        checkRemoval(nodes, verifier, Mesh::FLIP_ENGINE);
+        checkBatch(nodes, verifier);
+        if(distribution == Workload::UNIFORM)
+            checkNearest(nodes);
+        // a point inside a circle is joined to all of it, churn there is quadratic by nature
+        if(distribution == Workload::UNIFORM || distribution == Workload::GAUSSIAN_CLUSTERS)
+        {
+            checkChurn(nodes, verifier, Mesh::CAVITY_ENGINE);
+            checkChurn(nodes, verifier, Mesh::FLIP_ENGINE);
+        }
+    }
+    return finish("engines_test");
+}
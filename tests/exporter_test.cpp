@@ -0,0 +1,241 @@
+/** Every format MeshExporter writes reads back as the mesh it was given: OBJ and PLY give the
+* vertices and triangles again, which DelaunayVerifier accepts, STL and GeoJSON the corners of
+* every triangle in order. Formatting on a pool writes the same bytes as the calling thread. */
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/meshexporter.h"
+#include "../src/meshfile.h"
+#include "../src/threadpool.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+typedef std::vector<MeshFile::Triple> Triples;
+
+static std::string load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static bool readObj(const std::string& text, std::vector<Node>* vertices, Triples* triangles)
+{
+    std::istringstream in(text);
+    std::string line;
+    while(std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if(kind == "v")
+        {
+            float x, y, z;
+            if(!(fields >> x >> y >> z) || z != 0.0f)
+                return false;
+            vertices->push_back(Node(x, y));
+        }
+        else if(kind == "f")
+        {
+            MeshFile::Triple t;
+            if(!(fields >> t[0] >> t[1] >> t[2]))
+                return false;
+            triangles->push_back({t[0] - 1, t[1] - 1, t[2] - 1});
+        }
+        else if(kind != "#")
+            return false;
+    }
+    return true;
+}
+
+static bool readPly(const std::string& bytes, std::vector<Node>* vertices, Triples* triangles)
+{
+    std::size_t end = bytes.find("end_header\n");
+    if(bytes.compare(0, 4, "ply\n") != 0 || end == std::string::npos)
+        return false;
+    std::istringstream header(bytes.substr(0, end));
+    std::string line;
+    std::size_t vertexCount = 0, faceCount = 0;
+    while(std::getline(header, line))
+    {
+        std::sscanf(line.c_str(), "element vertex %zu", &vertexCount);
+        std::sscanf(line.c_str(), "element face %zu", &faceCount);
+    }
+    const char* p = bytes.data() + end + std::strlen("end_header\n");
+    if(static_cast<std::size_t>(bytes.data() + bytes.size() - p) != vertexCount * 3 * sizeof(float) + faceCount * (1 + sizeof(MeshFile::Triple)))
+        return false;
+    for(std::size_t i = 0; i < vertexCount; i++, p += 3 * sizeof(float))
+    {
+        float xyz[3];
+        std::memcpy(xyz, p, sizeof(xyz));
+        vertices->push_back(Node(xyz[0], xyz[1]));
+    }
+    for(std::size_t i = 0; i < faceCount; i++, p += 1 + sizeof(MeshFile::Triple))
+    {
+        MeshFile::Triple t;
+        std::memcpy(&t, p + 1, sizeof(t));
+        if(*p != 3)
+            return false;
+        triangles->push_back(t);
+    }
+    return true;
+}
+
+/// the corners of every triangle as the file lists them
+static bool readStl(const std::string& bytes, std::vector<Node>* corners)
+{
+    std::uint32_t count;
+    if(bytes.size() < 84)
+        return false;
+    std::memcpy(&count, bytes.data() + 80, sizeof(count));
+    const std::size_t FACET = 12 * sizeof(float) + sizeof(std::uint16_t);
+    if(bytes.size() != 84 + count * FACET)
+        return false;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        float facet[12];
+        std::memcpy(facet, bytes.data() + 84 + i * FACET, sizeof(facet));
+        if(facet[0] != 0.0f || facet[1] != 0.0f || facet[2] != 1.0f)
+            return false;
+        for(int k = 1; k <= 3; k++)
+            corners->push_back(Node(facet[3 * k], facet[3 * k + 1]));
+    }
+    return true;
+}
+
+/// the corners of every ring, the closing corner checked and dropped
+static bool readGeoJson(const std::string& text, std::vector<Node>* corners)
+{
+    std::size_t start = text.find("\"coordinates\":[");
+    if(start == std::string::npos || text.find("\"MultiPolygon\"") == std::string::npos)
+        return false;
+    // every number after the key is a coordinate, in rings of four x y pairs
+    std::vector<float> numbers;
+    const char* p = text.c_str() + start + std::strlen("\"coordinates\":[");
+    while(*p != '\0')
+    {
+        if(*p == '-' || (*p >= '0' && *p <= '9'))
+        {
+            char* end;
+            numbers.push_back(std::strtof(p, &end));
+            p = end;
+        }
+        else
+            p++;
+    }
+    if(numbers.size() % 8 != 0)
+        return false;
+    for(std::size_t i = 0; i < numbers.size(); i += 8)
+    {
+        if(numbers[i] != numbers[i + 6] || numbers[i + 1] != numbers[i + 7])
+            return false;
+        for(int k = 0; k < 3; k++)
+            corners->push_back(Node(numbers[i + 2 * k], numbers[i + 2 * k + 1]));
+    }
+    return true;
+}
+
+static bool isCorners(const std::vector<Node>& corners, const std::vector<Node>& vertices, const Triples& triangles)
+{
+    if(corners.size() != 3 * triangles.size())
+        return false;
+    for(std::size_t i = 0; i < triangles.size(); i++)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            if(!(corners[3 * i + k] == vertices[triangles[i][k]]))
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    DelaunayVerifier verifier;
+    ThreadPool pool(4);
+
+    // more triangles than one chunk holds, with coordinates of every magnitude
+    Workload workload;
+    workload.distribution = Workload::GAUSSIAN_CLUSTERS;
+    workload.seed = 47;
+    std::vector<Node> nodes;
+    WorkloadGenerator().generate(workload, 40000, &nodes);
+    nodes.push_back(Node(1e-7f, -3.5e-6f));
+    nodes.push_back(Node(-123456.0f, 0.1f));
+    Mesh mesh;
+    mesh.insertBatch(nodes);
+    std::vector<Node> vertices;
+    Triples triangles;
+    MeshFile::compact(mesh, &vertices, &triangles);
+    CHECK(triangles.size() > MeshExporter::CHUNK_SIZE);
+
+    for(MeshExporter::Format format : {MeshExporter::OBJ, MeshExporter::PLY, MeshExporter::STL, MeshExporter::GEOJSON})
+    {
+        std::string name = MeshExporter::formatName(format);
+        std::string path = (directory / ("exporter_test." + name)).string();
+        MeshExporter::Format named;
+        CHECK(MeshExporter::formatOf(path.c_str(), &named) && named == format);
+
+        MeshExporter serial;
+        CHECK(serial.write(path.c_str(), format, mesh));
+        CHECK(serial.getBytes() == std::filesystem::file_size(path));
+        std::string bytes = load(path);
+        MeshExporter parallel(&pool);
+        CHECK(parallel.write(path.c_str(), format, vertices, triangles));
+        CHECK(load(path) == bytes);
+
+        std::vector<Node> readVertices, corners;
+        Triples readTriangles;
+        switch(format)
+        {
+        case MeshExporter::OBJ:
+        case MeshExporter::PLY:
+        {
+            bool read = format == MeshExporter::OBJ ? readObj(bytes, &readVertices, &readTriangles)
+                                                    : readPly(bytes, &readVertices, &readTriangles);
+            CHECK(read);
+            CHECK(readVertices.size() == vertices.size() && readTriangles == triangles);
+            bool same = readVertices.size() == vertices.size();
+            for(std::size_t i = 0; same && i < vertices.size(); i++)
+                same = readVertices[i] == vertices[i];
+            CHECK(same);
+            VerifyReport report = verifier.verify(readVertices, readTriangles);
+            if(!report.isValid())
+                std::cout << name << ":\n" << report;
+            CHECK(report.isValid());
+            break;
+        }
+        case MeshExporter::STL:
+            CHECK(readStl(bytes, &corners));
+            CHECK(isCorners(corners, vertices, triangles));
+            break;
+        case MeshExporter::GEOJSON:
+            CHECK(readGeoJson(bytes, &corners));
+            CHECK(isCorners(corners, vertices, triangles));
+            break;
+        }
+        std::filesystem::remove(path);
+    }
+
+    MeshExporter::Format format;
+    CHECK(MeshExporter::formatOf("mesh.JSON", &format) && format == MeshExporter::GEOJSON);
+    CHECK(!MeshExporter::formatOf("mesh.txt", &format) && !MeshExporter::formatOf("mesh", &format));
+    MeshExporter exporter;
+    CHECK(!exporter.write((directory / "missing" / "mesh.obj").string().c_str(), MeshExporter::OBJ, mesh));
+    CHECK(!exporter.getError().empty());
+    return finish("exporter_test");
+}
@@ -0,0 +1,139 @@
+/** A mesh encoded with MeshCodec decodes to the same triangles, renumbered by getOrder(),
+* with every vertex within half a quantization step. DelaunayVerifier accepts the decoded
+* triangles over the original points; quantized points on a common circle may flip a diagonal,
+* so not always over the decoded ones. Damaged or cut encodings are refused. The size of every
+* encoding is printed in bytes per triangle. */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/meshcodec.h"
+#include "../src/meshfile.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+typedef std::vector<MeshFile::Triple> Triples;
+
+/// the triangles with their smallest vertex first, sorted
+static Triples canonical(const Triples& triangles)
+{
+    Triples out;
+    for(MeshFile::Triple t : triangles)
+    {
+        while(t[0] > t[1] || t[0] > t[2])
+            t = {t[1], t[2], t[0]};
+        out.push_back(t);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static void checkRoundTrip(const Mesh& mesh, int bits, bool entropy, const char* name, DelaunayVerifier& verifier)
+{
+    std::vector<Node> vertices;
+    Triples triangles;
+    MeshFile::compact(mesh, &vertices, &triangles);
+
+    MeshCodec codec(bits, entropy);
+    std::vector<unsigned char> data, fromMesh;
+    CHECK(codec.encode(vertices, triangles, &data));
+    CHECK(codec.encode(mesh, &fromMesh) && fromMesh == data);
+    std::vector<Node> decodedVertices;
+    Triples decodedTriangles;
+    MeshCodec decoder(bits, entropy);
+    CHECK(decoder.decode(data, &decodedVertices, &decodedTriangles));
+    CHECK(decodedVertices.size() == vertices.size() && decodedTriangles.size() == triangles.size());
+
+    // the same triangles under the numbering of the walk
+    const std::vector<int>& order = codec.getOrder();
+    CHECK(order.size() == vertices.size());
+    Triples renamed;
+    for(const MeshFile::Triple& t : triangles)
+        renamed.push_back({order[t[0]], order[t[1]], order[t[2]]});
+    CHECK(canonical(renamed) == canonical(decodedTriangles));
+
+    Node minCorner = vertices[0], maxCorner = vertices[0];
+    for(const Node& n : vertices)
+    {
+        minCorner = Node(std::min(minCorner.x, n.x), std::min(minCorner.y, n.y));
+        maxCorner = Node(std::max(maxCorner.x, n.x), std::max(maxCorner.y, n.y));
+    }
+    double step = std::max(maxCorner.x - minCorner.x, maxCorner.y - minCorner.y) / std::ldexp(1.0, bits);
+    double error = 0.0;
+    for(std::size_t v = 0; v < vertices.size() && decodedVertices.size() == vertices.size(); v++)
+    {
+        const Node& decoded = decodedVertices[order[v]];
+        error = std::max({error, std::abs(double(decoded.x) - vertices[v].x), std::abs(double(decoded.y) - vertices[v].y)});
+    }
+    // the float a coordinate is rounded to on the way out adds a little
+    CHECK(error <= 0.5 * step + 1e-6);
+    std::vector<Node> placed(decodedVertices.size());
+    for(std::size_t v = 0; v < vertices.size() && placed.size() == vertices.size(); v++)
+        placed[order[v]] = vertices[v];
+    VerifyReport report = verifier.verify(placed, decodedTriangles);
+    if(!report.isValid())
+        std::cout << name << ":\n" << report;
+    CHECK(report.isValid());
+    std::cout << name << ", " << bits << " bits" << (entropy ? ", entropy coded: " : ", bit-packed: ")
+              << static_cast<double>(data.size()) / triangles.size() << " bytes per triangle\n";
+
+    // cut short in either stream or with a damaged header
+    for(std::size_t size : {data.size() / 4, data.size() / 2, data.size() - 1})
+    {
+        std::vector<unsigned char> cut(data.begin(), data.begin() + size);
+        CHECK(!decoder.decode(cut, &decodedVertices, &decodedTriangles));
+        CHECK(!decoder.getError().empty() && decodedTriangles.empty());
+    }
+    std::vector<unsigned char> damaged = data;
+    damaged[0] ^= 0xff;
+    CHECK(!decoder.decode(damaged, &decodedVertices, &decodedTriangles));
+}
+
+int main(void)
+{
+    WorkloadGenerator generator;
+    DelaunayVerifier verifier;
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::GRID, Workload::CIRCLE})
+    {
+        Workload workload;
+        workload.distribution = distribution;
+        workload.seed = 53;
+        std::vector<Node> nodes;
+        generator.generate(workload, 30000, &nodes);
+        Mesh mesh;
+        mesh.insertBatch(nodes);
+        // removals leave holes in the numbering that the encoding closes
+        for(int v = 3; v < 3000; v += 7)
+            mesh.remove(v);
+        for(bool entropy : {true, false})
+        {
+            checkRoundTrip(mesh, MeshCodec::DEFAULT_BITS, entropy, Workload::name(distribution), verifier);
+            checkRoundTrip(mesh, MeshCodec::MAX_BITS, entropy, Workload::name(distribution), verifier);
+        }
+    }
+
+    // through a file
+    Workload workload;
+    workload.seed = 54;
+    std::vector<Node> nodes;
+    generator.generate(workload, 5000, &nodes);
+    Mesh mesh;
+    mesh.insertBatch(nodes);
+    std::string path = (std::filesystem::temp_directory_path() / "meshcodec_test.dmc").string();
+    MeshCodec codec;
+    CHECK(codec.write(path.c_str(), mesh));
+    std::vector<Node> vertices;
+    Triples triangles;
+    CHECK(codec.read(path.c_str(), &vertices, &triangles));
+    CHECK(verifier.verify(vertices, triangles).triangles == verifier.verify(mesh).triangles);
+    std::filesystem::remove(path);
+    CHECK(!codec.read(path.c_str(), &vertices, &triangles));
+    return finish("meshcodec_test");
+}
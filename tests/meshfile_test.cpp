@@ -0,0 +1,117 @@
+/** A mesh written with MeshFile maps back as the same Delaunay triangulation, locate() finds
+* the triangle of a point on the mapping, and Mesh::assign() takes the stored triangles as
+* they are, ready for further edits, while refusing anything that is not a triangulation. */
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/meshfile.h"
+#include "../src/predicates.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+typedef std::vector<MeshFile::Triple> Triples;
+
+static bool contains(const MeshFile& file, int triangle, const Node& n)
+{
+    std::span<const Node> vertices = file.vertices();
+    const MeshFile::Triple& t = file.triangles()[triangle];
+    for(int i = 0; i < 3; i++)
+    {
+        if(orient2d(vertices[t[i]], vertices[t[(i + 1) % 3]], n) < 0.0)
+            return false;
+    }
+    return true;
+}
+
+static void checkRoundTrip(const std::vector<Node>& nodes, const std::string& path, DelaunayVerifier& verifier)
+{
+    Mesh mesh;
+    mesh.insertBatch(nodes);
+    VerifyReport original = verifier.verify(mesh);
+    CHECK(MeshFile::write(path.c_str(), mesh));
+
+    MeshFile file;
+    CHECK(file.open(path.c_str()));
+    CHECK(file.hasAdjacency());
+    VerifyReport mapped = verifier.verify(file.vertices(), file.triangles());
+    CHECK(mapped.isValid());
+    CHECK(mapped.triangles == original.triangles && mapped.vertices == original.vertices);
+
+    CounterRandom random(3);
+    for(std::uint64_t q = 0; q < 100; q++)
+    {
+        Node query(1.8f * random.uniform(2 * q) - 0.9f, 1.8f * random.uniform(2 * q + 1) - 0.9f);
+        int triangle = file.locate(query);
+        if(triangle != Mesh::NONE)
+            CHECK(contains(file, triangle, query));
+    }
+
+    // with the stored adjacency and with the one found by matching edges
+    for(bool linked : {true, false})
+    {
+        Mesh loaded;
+        CHECK(loaded.assign(file.vertices(), file.triangles(), linked ? file.adjacency() : std::span<const MeshFile::Triple>()));
+        VerifyReport assigned = verifier.verify(loaded);
+        CHECK(assigned.isValid());
+        CHECK(assigned.triangles == original.triangles);
+
+        // the super faces around the hull are right if edits outside and inside it still work
+        loaded.insert(Node(3.0f, 0.5f));
+        loaded.insert(Node(0.01f, -0.02f));
+        loaded.remove(static_cast<int>(loaded.vertices.size()) / 2);
+        CHECK(verifier.verify(loaded).isValid());
+    }
+}
+
+int main(void)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string path = (directory / "meshfile_test.mesh").string();
+    WorkloadGenerator generator;
+    DelaunayVerifier verifier;
+
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::GRID, Workload::CIRCLE})
+    {
+        Workload workload;
+        workload.distribution = distribution;
+        workload.seed = 17;
+        std::vector<Node> nodes;
+        generator.generate(workload, 20000, &nodes);
+        checkRoundTrip(nodes, path, verifier);
+    }
+
+    // a points-only file feeds insertBatch from the mapping and assign() turns it down
+    std::vector<Node> points = {Node(0.0f, 0.0f), Node(1.0f, 0.0f), Node(0.0f, 1.0f), Node(1.0f, 1.0f)};
+    CHECK(MeshFile::write(path.c_str(), points, {}));
+    MeshFile file;
+    CHECK(file.open(path.c_str()));
+    CHECK(file.triangles().empty() && !file.hasAdjacency());
+    Mesh mesh;
+    CHECK(!mesh.assign(file.vertices(), file.triangles()));
+    mesh.insertBatch(file.vertices());
+    CHECK(verifier.verify(mesh).triangles == 2);
+    file.close();
+
+    // the kite 0 1 2 3 with its Delaunay diagonal 1 3, and triangulations assign() refuses
+    std::vector<Node> kite = {Node(0.0f, 0.0f), Node(2.0f, -1.0f), Node(4.0f, 0.0f), Node(2.0f, 1.0f)};
+    CHECK(mesh.assign(kite, Triples{{0, 1, 3}, {1, 2, 3}}));
+    CHECK(verifier.verify(mesh).isValid() && verifier.verify(mesh).triangles == 2);
+    CHECK(!mesh.assign(kite, Triples{{0, 1, 2}, {0, 2, 3}}));              // not Delaunay
+    CHECK(!mesh.assign(kite, Triples{{0, 3, 1}, {1, 2, 3}}));              // clockwise
+    CHECK(!mesh.assign(kite, Triples{{0, 1, 3}, {1, 2, 4}}));              // out of range
+    CHECK(!mesh.assign(kite, Triples{{0, 1, 3}}));                         // a node unused
+    CHECK(!mesh.assign(kite, Triples{{0, 1, 3}, {1, 2, 3}}, Triples{{-1, -1, -1}, {-1, -1, -1}}));
+    CHECK(!mesh.assign(kite, Triples{{0, 1, 3}, {1, 2, 3}}, Triples{{1, -1, -1}, {7, -1, -1}}));
+    std::vector<Node> notch = {Node(-1.0f, -1.0f), Node(1.0f, -1.0f), Node(1.0f, 1.0f), Node(-1.0f, 1.0f), Node(0.0f, 0.0f)};
+    CHECK(!mesh.assign(notch, Triples{{0, 1, 4}, {1, 2, 4}, {2, 3, 4}})); // not convex
+    // a refused triangulation leaves the mesh as it was
+    CHECK(verifier.verify(mesh).isValid() && verifier.verify(mesh).triangles == 2);
+
+    std::filesystem::remove(path);
+    return finish("meshfile_test");
+}
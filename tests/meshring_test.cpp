@@ -0,0 +1,202 @@
+/** A MeshReplica in a forked process follows a MeshPublisher through the ring: after every
+* commit it holds the triangles and vertices of the published mesh, face slot for face slot,
+* also when it polls while the publisher writes and when the publisher laps it and a full
+* copy has to resync it. */
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/meshring.h"
+#include "../src/workload.h"
+#include "check.h"
+
+/// small enough that the paused replica is lapped, large enough for a full copy
+static const std::uint32_t CAPACITY = 1 << 15;
+
+/// commands of the parent: converge and report, poll until the next command, or quit
+enum Command : char {REPORT = 'r', FOLLOW = 'f', QUIT = 'q'};
+
+static bool transfer(int descriptor, void* data, std::size_t length, bool writing)
+{
+    char* p = static_cast<char*>(data);
+    for(std::size_t done = 0; done < length; )
+    {
+        ssize_t n = writing ? write(descriptor, p + done, length - done) : read(descriptor, p + done, length - done);
+        if(n <= 0)
+            return false;
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+template <typename T>
+static bool sendVector(int descriptor, std::vector<T>& values)
+{
+    std::uint64_t count = values.size();
+    return transfer(descriptor, &count, sizeof(count), true) && transfer(descriptor, values.data(), count * sizeof(T), true);
+}
+
+template <typename T>
+static bool receiveVector(int descriptor, std::vector<T>* values)
+{
+    std::uint64_t count;
+    if(!transfer(descriptor, &count, sizeof(count), false))
+        return false;
+    values->resize(count);
+    return transfer(descriptor, values->data(), count * sizeof(T), false);
+}
+
+static bool isReadable(int descriptor, int timeout)
+{
+    pollfd entry{descriptor, POLLIN, 0};
+    return ::poll(&entry, 1, timeout) > 0;
+}
+
+/// the forked side, answers the commands read from input on output
+static int runReplica(const char* name, int input, int output)
+{
+    MeshReplica replica;
+    if(!replica.open(name))
+        return 1;
+    char command;
+    while(transfer(input, &command, 1, false) && command != QUIT)
+    {
+        if(command == FOLLOW)
+        {
+            while(!isReadable(input, 0))
+                replica.poll();
+            continue;
+        }
+        // everything the publisher will send for this report is in the ring or on its way
+        while(replica.poll() > 0 || !replica.isConsistent())
+            usleep(100);
+        std::vector<std::array<int, 3>> triangles;
+        replica.getTriangles(&triangles);
+        std::vector<Node> vertices = replica.getVertices();
+        std::uint64_t resyncs = replica.getResyncs();
+        if(!transfer(output, &resyncs, sizeof(resyncs), true) || !sendVector(output, triangles) || !sendVector(output, vertices))
+            return 1;
+    }
+    return 0;
+}
+
+/// asks the replica for its state, committing until it answers so resync requests are served
+static void checkReplica(MeshPublisher& publisher, const Mesh& mesh, int input, int output, std::uint64_t* resyncs)
+{
+    char command = REPORT;
+    CHECK(transfer(output, &command, 1, true));
+    while(!isReadable(input, 1))
+        publisher.commit();
+    std::vector<std::array<int, 3>> triangles, expected;
+    std::vector<Node> vertices;
+    CHECK(transfer(input, resyncs, sizeof(*resyncs), false));
+    CHECK(receiveVector(input, &triangles));
+    CHECK(receiveVector(input, &vertices));
+    mesh.getTriangles(&expected);
+    CHECK(triangles == expected);
+    bool same = vertices.size() >= mesh.vertices.size();
+    for(std::size_t f = 0; same && f < triangles.size(); f++)
+    {
+        for(int v : triangles[f])
+            same = same && mesh.vertices[v] == vertices[v];
+    }
+    CHECK(same);
+}
+
+int main(void)
+{
+    std::string name = "/meshring_test_" + std::to_string(getpid());
+    MeshPublisher publisher;
+    CHECK(publisher.create(name.c_str(), CAPACITY));
+    Mesh mesh;
+    publisher.attach(&mesh);
+
+    int commands[2], reports[2];
+    CHECK(pipe(commands) == 0 && pipe(reports) == 0);
+    pid_t child = fork();
+    if(child == 0)
+    {
+        close(commands[1]);
+        close(reports[0]);
+        _exit(runReplica(name.c_str(), commands[0], reports[1]));
+    }
+    close(commands[0]);
+    close(reports[1]);
+
+    Workload workload;
+    workload.seed = 43;
+    std::vector<Node> nodes;
+    WorkloadGenerator().generate(workload, 10000, &nodes);
+    std::uint64_t resyncs = 0;
+
+    // the replica opens, asks for a full copy and then follows commit by commit
+    for(std::size_t i = 0; i < 4000; i++)
+    {
+        mesh.insert(nodes[i]);
+        if(i % 1000 == 999)
+        {
+            publisher.commit();
+            checkReplica(publisher, mesh, reports[0], commands[1], &resyncs);
+        }
+    }
+    CHECK(resyncs == 1);
+
+    // polls racing the writer read slots while they are rewritten
+    char command = FOLLOW;
+    CHECK(transfer(commands[1], &command, 1, true));
+    for(std::size_t i = 4000; i < 6000; i++)
+    {
+        mesh.insert(nodes[i]);
+        if(i % 50 == 49)
+            publisher.commit();
+    }
+    for(int v = 3; v < 1500; v += 3)
+    {
+        mesh.remove(v);
+        publisher.commit();
+    }
+    checkReplica(publisher, mesh, reports[0], commands[1], &resyncs);
+    CHECK(resyncs == 1);
+
+    // a paused replica is lapped by more than a ring of records and resyncs from a full copy
+    std::uint64_t published = publisher.getPublished();
+    std::uint64_t copies = publisher.getFullCopies();
+    for(std::size_t i = 6000; i < 10000; i++)
+    {
+        mesh.insert(nodes[i]);
+        publisher.commit();
+    }
+    for(int v = 1500; v < 4500; v += 3)
+    {
+        mesh.remove(v);
+        publisher.commit();
+    }
+    CHECK(publisher.getPublished() - published > CAPACITY);
+    checkReplica(publisher, mesh, reports[0], commands[1], &resyncs);
+    CHECK(resyncs == 2);
+    CHECK(publisher.getFullCopies() == copies + 1);
+
+    // a cleared mesh is sent in full without a request
+    mesh.clear();
+    for(std::size_t i = 0; i < 500; i++)
+        mesh.insert(nodes[i]);
+    publisher.commit();
+    checkReplica(publisher, mesh, reports[0], commands[1], &resyncs);
+    CHECK(resyncs == 2);
+    CHECK(publisher.getFullCopies() == copies + 2);
+
+    command = QUIT;
+    CHECK(transfer(commands[1], &command, 1, true));
+    int status = 0;
+    CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(commands[1]);
+    close(reports[0]);
+    return finish("meshring_test");
+}
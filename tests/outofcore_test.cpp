@@ -0,0 +1,76 @@
+/** A binary point file run through the out-of-core triangulator comes out as a mesh file that
+* DelaunayVerifier accepts, with the triangles of the batch mesh; equal points are triangulated
+* once and points that are not finite are refused. */
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/meshfile.h"
+#include "../src/outofcore.h"
+#include "../src/pointreader.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+static void checkOutput(const std::string& path, std::size_t expected, DelaunayVerifier& verifier)
+{
+    MeshFile file;
+    CHECK(file.open(path.c_str()));
+    VerifyReport report = verifier.verify(file.vertices(), file.triangles());
+    if(!report.isValid())
+        std::cout << report;
+    CHECK(report.isValid());
+    CHECK(report.triangles == expected);
+}
+
+int main(void)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "outofcore_test";
+    std::string input = (directory / "points.bin").string();
+    std::string output = (directory / "points.mesh").string();
+    std::filesystem::create_directories(directory);
+    DelaunayVerifier verifier;
+
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::GRID})
+    {
+        Workload workload;
+        workload.distribution = distribution;
+        workload.seed = 31;
+        std::vector<Node> nodes;
+        WorkloadGenerator().generate(workload, 200000, &nodes);
+        // a copy of some points and one that is not finite
+        nodes.insert(nodes.end(), nodes.begin(), nodes.begin() + 1000);
+        nodes.push_back(Node(std::numeric_limits<float>::quiet_NaN(), 0.0f));
+
+        Mesh mesh;
+        mesh.insertBatch(std::span<const Node>(nodes).first(nodes.size() - 1));
+        std::size_t expected = verifier.verify(mesh).triangles;
+
+        CHECK(PointReader::writeBinary(input.c_str(), nodes));
+        OutOfCoreTriangulator triangulator(directory / "spill", 32, 16);
+        CHECK(triangulator.run(input.c_str(), output.c_str()));
+        CHECK(triangulator.getRejected() == 1);
+        CHECK(triangulator.getTriangleCount() == expected);
+        checkOutput(output, expected, verifier);
+        std::cout << Workload::name(distribution) << ": peak " << triangulator.getPeakFaces() << " faces";
+        for(const IoPhase& phase : triangulator.getPhases())
+            std::cout << ", " << phase;
+        std::cout << '\n';
+
+        // the same points already in memory
+        CHECK(triangulator.run(nodes, output.c_str()));
+        checkOutput(output, expected, verifier);
+    }
+
+    OutOfCoreTriangulator triangulator(directory / "spill", 4, 4);
+    CHECK(!triangulator.run((directory / "missing.bin").string().c_str(), output.c_str()));
+    CHECK(!triangulator.getError().empty());
+
+    std::filesystem::remove_all(directory);
+    return finish("outofcore_test");
+}
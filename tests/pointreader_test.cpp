@@ -0,0 +1,75 @@
+/** PointReader parses text, binary and .mesh point files alike: headers, comments and points
+* with a NaN or infinite coordinate are skipped and counted, whatever the format. */
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/pointreader.h"
+#include "../src/meshfile.h"
+#include "check.h"
+
+static bool isSame(const std::vector<Node>& nodes, const std::vector<Node>& expected)
+{
+    if(nodes.size() != expected.size())
+        return false;
+    for(std::size_t i = 0; i < nodes.size(); i++)
+    {
+        if(nodes[i].x != expected[i].x || nodes[i].y != expected[i].y)
+            return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    const float INF = std::numeric_limits<float>::infinity();
+    const float NaN = std::numeric_limits<float>::quiet_NaN();
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    PointReader reader(4);
+    std::vector<Node> nodes;
+
+    // header, comment, blank line, CRLF, extra columns, every separator and a sign
+    std::string text = "x,y,z\n# comment\n\n1,2,3\r\n+0.5\t-0.25\n3;4\n 5 , 6\nnan,1\n1,inf\n-inf 2\n7 8";
+    reader.parseText(text, &nodes);
+    CHECK(isSame(nodes, {Node(1.0f, 2.0f), Node(0.5f, -0.25f), Node(3.0f, 4.0f), Node(5.0f, 6.0f), Node(7.0f, 8.0f)}));
+    CHECK(reader.getSkippedLines() == 5);
+
+    std::string textPath = (directory / "pointreader_test.csv").string();
+    std::ofstream(textPath, std::ios::binary) << text;
+    CHECK(reader.read(textPath.c_str(), &nodes));
+    CHECK(nodes.size() == 5 && reader.getSkippedLines() == 5);
+
+    // many short lines cut into pieces across the pool
+    std::string lines;
+    for(int i = 0; i < 100000; i++)
+        lines += std::to_string(i) + ' ' + std::to_string(-i) + '\n';
+    reader.parseText(lines, &nodes);
+    CHECK(nodes.size() == 100000 && reader.getSkippedLines() == 0);
+    for(int i = 0; i < static_cast<int>(nodes.size()); i++)
+        CHECK(nodes[i].x == float(i) && nodes[i].y == float(-i));
+
+    std::vector<Node> raw = {Node(1.0f, 2.0f), Node(NaN, 0.0f), Node(3.0f, 4.0f), Node(0.0f, -INF)};
+    std::string binaryPath = (directory / "pointreader_test.bin").string();
+    CHECK(PointReader::writeBinary(binaryPath.c_str(), raw));
+    CHECK(reader.read(binaryPath.c_str(), &nodes));
+    CHECK(isSame(nodes, {Node(1.0f, 2.0f), Node(3.0f, 4.0f)}));
+    CHECK(reader.getSkippedLines() == 2);
+
+    std::string meshPath = (directory / "pointreader_test.mesh").string();
+    CHECK(MeshFile::write(meshPath.c_str(), raw, {}));
+    CHECK(reader.read(meshPath.c_str(), &nodes));
+    CHECK(isSame(nodes, {Node(1.0f, 2.0f), Node(3.0f, 4.0f)}));
+    CHECK(reader.getSkippedLines() == 2);
+
+    CHECK(!reader.read((directory / "pointreader_test_missing.bin").string().c_str(), &nodes));
+    CHECK(!reader.getError().empty());
+
+    std::filesystem::remove(textPath);
+    std::filesystem::remove(binaryPath);
+    std::filesystem::remove(meshPath);
+    return finish("pointreader_test");
+}
@@ -0,0 +1,241 @@
+/** The triangulation service, run on a socket of its own, builds the mesh a client sends it
+* in INSERT requests: a QUERY over the whole bounds returns the triangles of the batch mesh as
+* DelaunayVerifier checks them, equal nodes share a handle and nodes outside the bounds and
+* unknown meshes are refused. Churn through REMOVE and INSERT reuses the removed handles, so
+* the vertex storage of a mesh stays flat. */
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/serviceprotocol.h"
+#include "../src/triangulationservice.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+/// a blocking client sending one request at a time
+class Client
+{
+public:
+    explicit Client(const std::string& path)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        this->socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if(this->socket >= 0 && connect(this->socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close(this->socket);
+            this->socket = -1;
+        }
+    }
+
+    ~Client()
+    {
+        if(this->socket >= 0)
+            close(this->socket);
+    }
+
+    inline bool isConnected(void) const noexcept
+    {
+        return this->socket >= 0;
+    }
+
+    /// @return the status of the reply, with its payload in reply
+    int request(std::uint16_t opcode, std::uint32_t mesh, const void* payload, std::size_t length, std::vector<unsigned char>* reply)
+    {
+        RequestHeader header{};
+        header.length = static_cast<std::uint32_t>(length);
+        header.tag = ++this->tag;
+        header.mesh = mesh;
+        header.opcode = opcode;
+        ReplyHeader answer{};
+        if(!this->send(&header, sizeof(header)) || !this->send(payload, length) || !this->receive(&answer, sizeof(answer)) ||
+           answer.tag != header.tag)
+            return -1;
+        reply->resize(answer.length);
+        return this->receive(reply->data(), reply->size()) ? answer.status : -1;
+    }
+
+private:
+    bool send(const void* data, std::size_t length)
+    {
+        const char* p = static_cast<const char*>(data);
+        for(std::size_t done = 0; done < length; )
+        {
+            ssize_t n = write(this->socket, p + done, length - done);
+            if(n <= 0)
+                return false;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool receive(void* data, std::size_t length)
+    {
+        char* p = static_cast<char*>(data);
+        for(std::size_t done = 0; done < length; )
+        {
+            ssize_t n = read(this->socket, p + done, length - done);
+            if(n <= 0)
+                return false;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    int socket = -1;
+    std::uint32_t tag = 0;
+};
+
+template <typename T>
+static T as(const std::vector<unsigned char>& bytes, std::size_t index = 0)
+{
+    T value;
+    std::memcpy(&value, bytes.data() + index * sizeof(T), sizeof(T));
+    return value;
+}
+
+int main(void)
+{
+    std::string path = (std::filesystem::temp_directory_path() / "service_test.sock").string();
+    TriangulationService service(100);
+    CHECK(service.listen(path.c_str()));
+    std::thread server([&service]()
+    {
+        service.run();
+    });
+
+    DelaunayVerifier verifier;
+    {
+        Client client(path);
+        CHECK(client.isConnected());
+        std::vector<unsigned char> reply;
+        for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::GRID})
+        {
+            Workload workload;
+            workload.distribution = distribution;
+            workload.seed = 41;
+            std::vector<Node> nodes;
+            WorkloadGenerator().generate(workload, 20000, &nodes);
+            Box bounds{workload.minCorner, workload.maxCorner};
+            CHECK(client.request(RequestHeader::CREATE, 0, &bounds, sizeof(bounds), &reply) == ReplyHeader::OK);
+            std::uint32_t id = as<std::uint32_t>(reply);
+
+            // in requests of a few hundred nodes, the last ones again
+            std::vector<std::int32_t> handles;
+            for(std::size_t first = 0; first < nodes.size(); first += 500)
+            {
+                std::size_t count = std::min<std::size_t>(500, nodes.size() - first);
+                CHECK(client.request(RequestHeader::INSERT, id, nodes.data() + first, count * sizeof(Node), &reply) == ReplyHeader::OK);
+                CHECK(reply.size() == count * sizeof(std::int32_t));
+                for(std::size_t i = 0; i < reply.size() / sizeof(std::int32_t); i++)
+                    handles.push_back(as<std::int32_t>(reply, i));
+            }
+            CHECK(handles.size() == nodes.size());
+            CHECK(client.request(RequestHeader::INSERT, id, nodes.data() + nodes.size() - 100, 100 * sizeof(Node), &reply) == ReplyHeader::OK);
+            for(std::size_t i = 0; i < 100 && reply.size() == 100 * sizeof(std::int32_t); i++)
+                CHECK(as<std::int32_t>(reply, i) == handles[nodes.size() - 100 + i]);
+
+            // the handles of the queried triangles index the nodes sent under them
+            CHECK(client.request(RequestHeader::QUERY, id, &bounds, sizeof(bounds), &reply) == ReplyHeader::OK);
+            std::unordered_map<std::int32_t, int> index;
+            std::vector<Node> vertices;
+            for(std::size_t i = 0; i < nodes.size(); i++)
+            {
+                CHECK(handles[i] > 2);
+                if(index.emplace(handles[i], static_cast<int>(vertices.size())).second)
+                    vertices.push_back(nodes[i]);
+            }
+            std::vector<std::array<int, 3>> triangles(reply.size() / (3 * sizeof(std::int32_t)));
+            for(std::size_t t = 0; t < triangles.size(); t++)
+            {
+                for(int i = 0; i < 3; i++)
+                {
+                    auto found = index.find(as<std::int32_t>(reply, 3 * t + i));
+                    triangles[t][i] = found == index.end() ? -1 : found->second;
+                }
+            }
+            Mesh mesh;
+            mesh.insertBatch(nodes);
+            VerifyReport served = verifier.verify(vertices, triangles);
+            if(!served.isValid())
+                std::cout << Workload::name(distribution) << ":\n" << served;
+            CHECK(served.isValid());
+            CHECK(served.triangles == verifier.verify(mesh).triangles);
+
+            CHECK(client.request(RequestHeader::DROP, id, nullptr, 0, &reply) == ReplyHeader::OK);
+            CHECK(client.request(RequestHeader::QUERY, id, &bounds, sizeof(bounds), &reply) == ReplyHeader::NO_SUCH_MESH);
+        }
+
+        // removing a third of the nodes and sending them again, round after round, hands out
+        // no handle beyond the ones the first insertion used
+        {
+            Workload workload;
+            workload.seed = 42;
+            std::vector<Node> nodes;
+            WorkloadGenerator().generate(workload, 3000, &nodes);
+            Box bounds{workload.minCorner, workload.maxCorner};
+            CHECK(client.request(RequestHeader::CREATE, 0, &bounds, sizeof(bounds), &reply) == ReplyHeader::OK);
+            std::uint32_t id = as<std::uint32_t>(reply);
+            CHECK(client.request(RequestHeader::INSERT, id, nodes.data(), nodes.size() * sizeof(Node), &reply) == ReplyHeader::OK);
+            std::vector<std::int32_t> handles(nodes.size());
+            if(reply.size() == handles.size() * sizeof(std::int32_t))
+                std::memcpy(handles.data(), reply.data(), reply.size());
+            std::int32_t highest = *std::max_element(handles.begin(), handles.end());
+            for(int round = 0; round < 5; round++)
+            {
+                std::vector<std::int32_t> removed;
+                std::vector<Node> again;
+                for(std::size_t i = round; i < nodes.size(); i += 3)
+                {
+                    removed.push_back(handles[i]);
+                    again.push_back(nodes[i]);
+                }
+                CHECK(client.request(RequestHeader::REMOVE, id, removed.data(), removed.size() * sizeof(std::int32_t), &reply) == ReplyHeader::OK);
+                CHECK(reply.size() == removed.size() && std::count(reply.begin(), reply.end(), 1) == static_cast<long>(removed.size()));
+                CHECK(client.request(RequestHeader::INSERT, id, again.data(), again.size() * sizeof(Node), &reply) == ReplyHeader::OK);
+                CHECK(reply.size() == again.size() * sizeof(std::int32_t));
+                for(std::size_t k = 0, i = round; k < reply.size() / sizeof(std::int32_t); k++, i += 3)
+                {
+                    handles[i] = as<std::int32_t>(reply, k);
+                    CHECK(handles[i] > 2 && handles[i] <= highest);
+                }
+            }
+            CHECK(client.request(RequestHeader::QUERY, id, &bounds, sizeof(bounds), &reply) == ReplyHeader::OK);
+            Mesh mesh;
+            mesh.insertBatch(nodes);
+            CHECK(reply.size() / (3 * sizeof(std::int32_t)) == verifier.verify(mesh).triangles);
+            CHECK(client.request(RequestHeader::DROP, id, nullptr, 0, &reply) == ReplyHeader::OK);
+        }
+
+        // a node outside the bounds gets no handle, a broken payload no reply payload
+        Box bounds{Node(0.0f, 0.0f), Node(1.0f, 1.0f)};
+        CHECK(client.request(RequestHeader::CREATE, 0, &bounds, sizeof(bounds), &reply) == ReplyHeader::OK);
+        std::uint32_t id = as<std::uint32_t>(reply);
+        Node outside[2] = {Node(0.5f, 0.5f), Node(2.0f, 0.5f)};
+        CHECK(client.request(RequestHeader::INSERT, id, outside, sizeof(outside), &reply) == ReplyHeader::OK);
+        CHECK(reply.size() == 2 * sizeof(std::int32_t) && as<std::int32_t>(reply, 0) > 2 && as<std::int32_t>(reply, 1) == -1);
+        CHECK(client.request(RequestHeader::INSERT, id, outside, sizeof(Node) - 1, &reply) == ReplyHeader::BAD_REQUEST);
+        CHECK(reply.empty());
+        CHECK(client.request(RequestHeader::STATS, 0, nullptr, 0, &reply) == ReplyHeader::OK);
+        CHECK(reply.size() == sizeof(ServiceStats));
+    }
+
+    service.stop();
+    server.join();
+    CHECK(service.getStats().insertedPoints > 0);
+    return finish("service_test");
+}
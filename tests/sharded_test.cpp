@@ -0,0 +1,51 @@
+/** The sharded triangulator merges the slabs of its worker processes into a mesh that
+* DelaunayVerifier accepts, with the triangles of one mesh over the same points, and still
+* does when the first worker of a shard dies and the shard is run again. */
+#include <array>
+#include <iostream>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/shardedtriangulator.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+int main(void)
+{
+    WorkloadGenerator generator;
+    DelaunayVerifier verifier;
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::GRID})
+    {
+        Workload workload;
+        workload.distribution = distribution;
+        workload.seed = 37;
+        std::vector<Node> nodes;
+        generator.generate(workload, 50000, &nodes);
+        Mesh mesh;
+        mesh.insertBatch(nodes);
+        std::size_t expected = verifier.verify(mesh).triangles;
+
+        for(int shards : {1, 3, 4})
+        {
+            ShardedTriangulator triangulator(shards);
+            if(shards == 3)
+                triangulator.injectFailure(1);
+            std::vector<std::array<int, 3>> triangles;
+            bool done = triangulator.triangulate(nodes, &triangles);
+            if(!done)
+                std::cout << triangulator.getError() << '\n';
+            CHECK(done);
+            VerifyReport report = verifier.verify(nodes, triangles);
+            if(!report.isValid())
+                std::cout << Workload::name(distribution) << " in " << shards << " shards:\n" << report;
+            CHECK(report.isValid());
+            CHECK(report.triangles == expected);
+            CHECK(triangulator.getShards().size() == static_cast<std::size_t>(shards));
+            if(shards == 3 && triangulator.getShards().size() == 3)
+                CHECK(triangulator.getShards()[1].attempts == 2);
+        }
+    }
+    return finish("sharded_test");
+}
@@ -0,0 +1,78 @@
+/** The fixed-capacity kernels triangulate every set size up to SMALL_KERNEL_LIMIT, duplicate
+* nodes and degenerate layouts included, into Delaunay triangles of the input nodes, as many
+* as a Mesh of the same nodes has. Including stencil.h compiles its static_asserts, and the
+* stencils computed at compile time are the triangles the kernel gives at run time. */
+#include <array>
+#include <span>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/smalltriangulation.h"
+#include "../src/stencil.h"
+#include "../src/workload.h"
+#include "check.h"
+
+static void checkSet(std::span<const Node> nodes)
+{
+    std::array<std::array<int, 3>, 2 * SMALL_KERNEL_LIMIT> triangles;
+    int count = triangulateSmall(nodes, triangles.data());
+    CHECK(count >= 0 && count <= 2 * static_cast<int>(nodes.size()));
+    CHECK(isDelaunay(nodes, std::span<const std::array<int, 3>>(triangles.data(), count)));
+
+    Mesh mesh;
+    mesh.insertBatch(nodes);
+    std::vector<std::array<int, 3>> expected;
+    mesh.getTriangles(&expected);
+    CHECK(static_cast<std::size_t>(count) == expected.size());
+}
+
+template <std::size_t N>
+static void checkStencil(const std::array<Node, N>& nodes, const Stencil<N>& stencil)
+{
+    CHECK(isDelaunay(nodes, stencil.faces()));
+    std::array<std::array<int, 3>, 2 * SMALL_KERNEL_LIMIT> triangles;
+    int count = triangulateSmall(nodes, triangles.data());
+    CHECK(count == stencil.count);
+    for(int t = 0; t < count && t < stencil.count; t++)
+        CHECK(triangles[t] == stencil.triangles[t]);
+}
+
+int main(void)
+{
+    WorkloadGenerator generator;
+    std::uint64_t seed = 1;
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GRID, Workload::CIRCLE, Workload::LINE})
+    {
+        for(std::size_t size = 0; size <= SMALL_KERNEL_LIMIT; size++)
+        {
+            Workload workload;
+            workload.distribution = distribution;
+            workload.seed = seed++;
+            std::vector<Node> nodes;
+            generator.generate(workload, size, &nodes);
+            checkSet(nodes);
+
+            // every node twice, the copies are skipped
+            if(2 * size <= SMALL_KERNEL_LIMIT)
+            {
+                std::vector<Node> doubled(nodes);
+                doubled.insert(doubled.end(), nodes.begin(), nodes.end());
+                checkSet(doubled);
+            }
+        }
+    }
+
+    // a smaller kernel on the stack takes the same path
+    std::array<Node, 4> square = {Node(0.0f, 0.0f), Node(1.0f, 0.0f), Node(1.0f, 1.0f), Node(0.0f, 1.0f)};
+    std::array<std::array<int, 3>, SmallTriangulation<4>::MAX_TRIANGLES> triangles;
+    SmallTriangulation<4> kernel;
+    int count = kernel.triangulate(square, triangles.data());
+    CHECK(count == 2);
+    CHECK(isDelaunay(square, std::span<const std::array<int, 3>>(triangles.data(), count)));
+
+    checkStencil(CROSS_STENCIL, CROSS_TRIANGLES);
+    checkStencil(BLOCK_STENCIL, BLOCK_TRIANGLES);
+    checkStencil(HEXAGON_STENCIL, HEXAGON_TRIANGLES);
+    return finish("smalltriangulation_test");
+}
@@ -0,0 +1,137 @@
+/** A restored snapshot is the saved mesh or hierarchy slot for slot and continues exactly as
+* the saved one would; a snapshot with an index out of range or cut short is refused and
+* leaves the target as it was. */
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/hierarchy.h"
+#include "../src/snapshot.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+/// magic, version, kind and level count
+static const std::size_t HEADER_BYTES = 8 + 3 * sizeof(std::uint32_t);
+
+static bool isSame(const Mesh& a, const Mesh& b)
+{
+    if(a.vertices.size() != b.vertices.size() || a.faces.size() != b.faces.size() || a.vertexFace != b.vertexFace)
+        return false;
+    for(std::size_t v = 0; v < a.vertices.size(); v++)
+    {
+        if(!(a.vertices[v] == b.vertices[v]))
+            return false;
+    }
+    for(std::size_t f = 0; f < a.faces.size(); f++)
+    {
+        if(a.faces[f].v != b.faces[f].v || (a.faces[f].v[0] != Mesh::NONE && a.faces[f].adj != b.faces[f].adj))
+            return false;
+    }
+    return true;
+}
+
+/// overwrites the int32 at offset of a file
+static void patch(const std::string& path, std::size_t offset, std::int32_t value)
+{
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+int main(void)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string path = (directory / "snapshot_test.snap").string();
+    std::string damaged = (directory / "snapshot_test_damaged.snap").string();
+    DelaunayVerifier verifier;
+    Workload workload;
+    workload.seed = 23;
+    std::vector<Node> nodes, more;
+    WorkloadGenerator generator;
+    generator.generate(workload, 20000, &nodes);
+    workload.seed = 24;
+    generator.generate(workload, 1000, &more);
+
+    // removals leave free face and vertex slots for the free lists to carry
+    Mesh mesh;
+    mesh.setEngine(Mesh::FLIP_ENGINE);
+    mesh.insertBatch(nodes);
+    for(int v = 3; v < 2000; v += 3)
+        mesh.remove(v);
+    CHECK(Snapshot::save(path.c_str(), mesh));
+
+    Mesh restored;
+    MeshJournal journal;
+    restored.addJournal(&journal);
+    CHECK(Snapshot::restore(path.c_str(), &restored));
+    CHECK(isSame(mesh, restored));
+    CHECK(restored.getEngine() == Mesh::FLIP_ENGINE);
+    CHECK(journal.cleared);
+    CHECK(verifier.verify(restored).isValid());
+    for(const Node& n : more)
+    {
+        mesh.insert(n);
+        restored.insert(n);
+    }
+    CHECK(isSame(mesh, restored));
+
+    // every kind of index a walk follows, damaged one at a time
+    Mesh saved;
+    CHECK(Snapshot::restore(path.c_str(), &saved));
+    std::size_t vertices = HEADER_BYTES + 2 * sizeof(std::int32_t);
+    std::size_t faces = vertices + sizeof(std::uint64_t) + saved.vertices.size() * sizeof(Node) + sizeof(std::uint64_t);
+    int live = 0;
+    while(saved.faces[live].v[0] == Mesh::NONE)
+        live++;
+    std::size_t face = faces + live * sizeof(Mesh::Face);
+    std::size_t vertexFaces = faces + saved.faces.size() * sizeof(Mesh::Face) + sizeof(std::uint64_t);
+    std::size_t freeFaces = vertexFaces + saved.vertexFace.size() * sizeof(std::int32_t) + sizeof(std::uint64_t);
+    CHECK(static_cast<std::size_t>(saved.faceCount()) < saved.faces.size()); // some slots are free
+    const std::vector<std::pair<std::size_t, std::int32_t>> damages = {
+        {HEADER_BYTES + sizeof(std::int32_t), static_cast<std::int32_t>(saved.faces.size())}, // last face
+        {face + sizeof(std::int32_t), static_cast<std::int32_t>(saved.vertices.size())},      // Face::v
+        {face, Mesh::NONE - 1},                                                                // Face::v
+        {face + 4 * sizeof(std::int32_t), static_cast<std::int32_t>(saved.faces.size())},     // Face::adj
+        {face + 5 * sizeof(std::int32_t), -7},                                                 // Face::adj
+        {vertexFaces + 5 * sizeof(std::int32_t), 1 << 30},                                     // vertexFace
+        {freeFaces, static_cast<std::int32_t>(saved.faces.size())},                            // freeFaces
+        {freeFaces, live},                                                                     // a live face freed
+    };
+    for(const auto& damage : damages)
+    {
+        std::filesystem::copy_file(path, damaged, std::filesystem::copy_options::overwrite_existing);
+        patch(damaged, damage.first, damage.second);
+        Mesh target = mesh;
+        CHECK(!Snapshot::restore(damaged.c_str(), &target));
+        CHECK(isSame(mesh, target));
+    }
+    std::filesystem::resize_file(damaged, std::filesystem::file_size(path) - 1);
+    CHECK(!Snapshot::restore(damaged.c_str(), &restored));
+
+    // a hierarchy continues with the same levels and the same random levels for new vertices
+    DelaunayHierarchy hierarchy;
+    for(const Node& n : nodes)
+        hierarchy.insert(n);
+    for(int v = 3; v < 2000; v += 5)
+        hierarchy.remove(v);
+    CHECK(Snapshot::save(path.c_str(), hierarchy));
+    DelaunayHierarchy copy;
+    CHECK(Snapshot::restore(path.c_str(), &copy));
+    CHECK(isSame(hierarchy.base(), copy.base()));
+    for(const Node& n : more)
+        CHECK(hierarchy.insert(n) == copy.insert(n));
+    CHECK(isSame(hierarchy.base(), copy.base()));
+    CHECK(verifier.verify(copy.base()).isValid());
+
+    // a snapshot of one kind does not restore as the other
+    CHECK(!Snapshot::restore(path.c_str(), &restored));
+    std::filesystem::remove(path);
+    std::filesystem::remove(damaged);
+    return finish("snapshot_test");
+}
@@ -0,0 +1,63 @@
+/** The streaming triangulator emits the triangles of the batch mesh, as DelaunayVerifier
+* checks them, while holding only a fraction of its faces at once. The peak face count and
+* the locations that fell back to a scan of the frontier are printed for every run. */
+#include <array>
+#include <iostream>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/streamingtriangulator.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+static const std::size_t COUNT = 100000;
+
+int main(void)
+{
+    WorkloadGenerator generator;
+    DelaunayVerifier verifier;
+    for(Workload::Distribution distribution : {Workload::UNIFORM, Workload::GAUSSIAN_CLUSTERS, Workload::JITTERED_GRID})
+    {
+        Workload workload;
+        workload.distribution = distribution;
+        workload.seed = 29;
+        std::vector<Node> nodes;
+        generator.generate(workload, COUNT, &nodes);
+
+        std::vector<std::array<int, 3>> triangles;
+        StreamingTriangulator streaming(workload.minCorner, workload.maxCorner, 64, 64, [&](const StreamTriangle& t)
+        {
+            triangles.push_back({static_cast<int>(t.id[0]), static_cast<int>(t.id[1]), static_cast<int>(t.id[2])});
+        });
+        streaming.triangulate(nodes);
+
+        Mesh mesh;
+        mesh.insertBatch(nodes);
+        VerifyReport batch = verifier.verify(mesh);
+        VerifyReport streamed = verifier.verify(nodes, triangles);
+        CHECK(streamed.isValid());
+        CHECK(streamed.triangles == batch.triangles);
+        CHECK(streaming.getEmitted() == triangles.size());
+        CHECK(streaming.getRejected() == 0);
+        // the frontier of a 64 x 64 grid swept row by row is a small part of the mesh
+        CHECK(streaming.getPeakFaces() < mesh.faces.size() / 4);
+        // a fallback scans the whole frontier, it has to stay the exception
+        CHECK(streaming.getLocateFallbacks() < COUNT / 50);
+
+        std::cout << Workload::name(distribution) << ": " << streamed.triangles << " triangles, peak "
+                  << streaming.getPeakFaces() << " faces against " << mesh.faces.size() << " in the batch mesh, "
+                  << streaming.getLocateFallbacks() << " locate fallbacks\n";
+    }
+
+    // points in a finalized cell or outside the grid are refused
+    StreamingTriangulator streaming(Node(0.0f, 0.0f), Node(1.0f, 1.0f), 2, 2, [&](const StreamTriangle&) {});
+    CHECK(streaming.insert(Node(0.25f, 0.25f), 0) == 0);
+    CHECK(streaming.insert(Node(0.25f, 0.25f), 1) == 0);
+    streaming.finalize(streaming.cellOf(Node(0.25f, 0.25f)));
+    CHECK(streaming.insert(Node(0.3f, 0.3f), 2) == StreamingTriangulator::NO_ID);
+    CHECK(streaming.insert(Node(2.0f, 0.5f), 3) == StreamingTriangulator::NO_ID);
+    CHECK(streaming.getRejected() == 2);
+    return finish("streaming_test");
+}
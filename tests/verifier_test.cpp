@@ -0,0 +1,65 @@
+/** DelaunayVerifier accepts Delaunay meshes and counts each kind of defect planted in one,
+* with the same report whatever the number of threads. */
+#include <array>
+#include <vector>
+
+#include "../src/node.h"
+#include "../src/mesh.h"
+#include "../src/workload.h"
+#include "../src/verifier.h"
+#include "check.h"
+
+typedef std::vector<std::array<int, 3>> Triangles;
+
+/// the kite 0 1 2 3, whose short diagonal 1 3 is the Delaunay one
+static const std::vector<Node> KITE = {Node(0.0f, 0.0f), Node(2.0f, -1.0f), Node(4.0f, 0.0f), Node(2.0f, 1.0f)};
+
+int main(void)
+{
+    DelaunayVerifier verifier(4);
+
+    VerifyReport kite = verifier.verify(KITE, Triangles{{0, 1, 3}, {1, 2, 3}});
+    CHECK(kite.isValid());
+    CHECK(kite.triangles == 2 && kite.edges == 5 && kite.boundaryEdges == 4 && kite.eulerCharacteristic == 1);
+
+    VerifyReport longDiagonal = verifier.verify(KITE, Triangles{{0, 1, 2}, {0, 2, 3}});
+    CHECK(!longDiagonal.isValid());
+    CHECK(longDiagonal.nonDelaunayEdges == 1);
+
+    VerifyReport clockwise = verifier.verify(KITE, Triangles{{0, 3, 1}, {1, 2, 3}});
+    CHECK(!clockwise.isValid());
+    CHECK(clockwise.badOrientation == 1);
+
+    VerifyReport outOfRange = verifier.verify(KITE, Triangles{{0, 1, 3}, {1, 2, 7}});
+    CHECK(!outOfRange.isValid());
+    CHECK(outOfRange.invalidTriangles == 1 && outOfRange.firstBadTriangle == 1);
+
+    VerifyReport repeated = verifier.verify(KITE, Triangles{{0, 1, 3}, {1, 2, 3}, {1, 2, 3}});
+    CHECK(!repeated.isValid());
+    CHECK(repeated.nonManifoldEdges > 0);
+
+    // half the kite is the Delaunay triangulation of three of its corners
+    VerifyReport unused = verifier.verify(KITE, Triangles{{0, 1, 3}});
+    CHECK(unused.isValid());
+    CHECK(unused.unusedVertices == 1);
+
+    // a fan around the centre of a square with one triangle taken out is not convex
+    std::vector<Node> square = {Node(-1.0f, -1.0f), Node(1.0f, -1.0f), Node(1.0f, 1.0f), Node(-1.0f, 1.0f), Node(0.0f, 0.0f)};
+    VerifyReport notch = verifier.verify(square, Triangles{{0, 1, 4}, {1, 2, 4}, {2, 3, 4}});
+    CHECK(!notch.isValid());
+    CHECK(notch.reflexCorners > 0);
+
+    // a large mesh gets the same report from one worker as from several
+    Workload workload;
+    workload.seed = 5;
+    std::vector<Node> nodes;
+    WorkloadGenerator().generate(workload, 100000, &nodes);
+    Mesh mesh;
+    mesh.insertBatch(nodes);
+    VerifyReport parallel = verifier.verify(mesh);
+    VerifyReport serial = DelaunayVerifier(1).verify(mesh);
+    CHECK(parallel.isValid() && serial.isValid());
+    CHECK(parallel.triangles == serial.triangles && parallel.edges == serial.edges);
+    CHECK(parallel.triangles == static_cast<std::size_t>(2 * parallel.vertices - parallel.boundaryEdges - 2));
+    return finish("verifier_test");
+}